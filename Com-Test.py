@@ -1,3 +1,4 @@
+import sys
 import serial
 import time
 
@@ -25,7 +26,42 @@ def send_hex_data(port, baudrate, hex_str, delay=0):
         if delay > 0:
             time.sleep(delay)
 
+def pong_responder(port, baudrate, host_id="HOST", fixed_group=None):
+    """
+    应答设备的PING：设备切换串口波特率后发 HOST:<设备>:PING:<波特率>，
+    收不到 <设备>:HOST:PONG:<波特率> 会退回9600，见 include/Command.h
+
+    :param port: 上位机LoRa模块所接的串口
+    :param baudrate: 上位机与其模块之间的波特率
+    :param host_id: 上位机名字，与设备的hostID一致
+    :param fixed_group: 设备使用定点传输时填组号，回复前加 组号+设备号 帧头
+    """
+    with serial.Serial(port, baudrate, timeout=1) as ser:
+        print(f"打开串口 {port}，波特率 {baudrate}，等待PING")
+        while True:
+            line = ser.readline()
+            if not line:
+                continue
+            fields = line.decode(errors="replace").strip().split(":", 3)
+            if len(fields) < 3 or fields[0] != host_id or fields[2] != "PING":
+                continue
+            # 发送者字段可能带 /S 等选项，只取设备名
+            device = fields[1].split("/", 1)[0]
+            payload = fields[3] if len(fields) > 3 else ""
+            reply = f"{device}:{host_id}:PONG:{payload}\n".encode()
+            digits = device[len(device.rstrip("0123456789")):]
+            if fixed_group is not None and digits:
+                reply = bytes([fixed_group, int(digits)]) + reply
+            ser.write(reply)
+            print(f"{device} PING {payload} -> PONG")
+
 if __name__ == '__main__':
+    if len(sys.argv) >= 2 and sys.argv[1] == "pong":
+        # 用法: python Com-Test.py pong <串口> [波特率]
+        pong_responder(sys.argv[2] if len(sys.argv) > 2 else "COM24",
+                       int(sys.argv[3]) if len(sys.argv) > 3 else 9600)
+        sys.exit(0)
+
     # 修改成你的串口和波特率
     port = 'COM24'           # Windows 示例，Linux/Mac 下改成 /dev/ttyUSB0
     baudrate = 9600
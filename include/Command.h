@@ -8,18 +8,47 @@
 #define Address 0x05  // 地址
 #define Channel 0x20  // 信道
 
+#include "lora_config.h"
+
 // 空速62.5k，功率20dBm,透明传输模式，波特率9600，组号地址信道如上，目标组号目标地址同上
-#define LoraCMD                                                                \
-    "80041E0000258000041F00010503E8007777772E617368696E696E672E636F6D7C7C7C7C" \
-    "7C054000230000003C3C000A19000000050005000000002000"
+// 寄存器格式见 lora_config.h；串口波特率由LORA_UART_BAUD在运行时协商，这里保持9600
+constexpr LoraModuleConfig LORA_DEFAULT_CONFIG =
+    LoraModuleConfig()
+        .withChannel(Channel)
+        .withPower(3)
+        .withAir(LoraAir::Bps62500)
+        .withMode(LoraMode::Transparent, LoraRole::Master)
+        .withLocal(GroupNum, Address)
+        .withTarget(GroupNum, Address);
+
+static_assert(LORA_DEFAULT_CONFIG.radioValid(),
+              "LoRa channel/power/air rate out of range");
+static_assert(LORA_DEFAULT_CONFIG.keyValid(),
+              "LoRa key must be exactly 16 characters");
+static_assert(LORA_DEFAULT_CONFIG.addressingValid(),
+              "Transparent mode needs target group/address equal to local");
+static_assert(LORA_DEFAULT_CONFIG.roleValid(),
+              "Slave role needs master/slave mode and a non-broadcast target");
+static_assert(LORA_DEFAULT_CONFIG.valid(), "Invalid LoRa module configuration");
+
+// 用于估算空中时间的默认空速
+#define LORA_AIR_RATE_BPS (LORA_DEFAULT_CONFIG.airRateBps())
 
 #define EMG_F "EMG_F" // 电磁铁前进侧_两触点
 #define EMG_B "EMG_B" // 电磁铁后退侧_两触点
 
 #define STOP "STOP" // 停止命令
+// 紧急停止标记：上位机直接发送 "\n\x1B\x1B\x1B\n"，不带接收者，所有听到的设备都停止
+// 在串口接收回调中就关闭输出，不经过组帧和命令分派，随后按普通STOP回复ACK
+// 中继不转发，延迟统计见 LINK_STATS:AUX 的 FAST_STOP:<次数>,<最近us>,<最大us>
+// 该统计从接收事件开始计时；此前标记在FIFO中等待事件，115200波特率时
+// 单独到达约0.2ms，夹在连续数据流中最坏约10ms(见 test_rx_latency)
+#define STOP_FAST "\n\x1B\x1B\x1B\n"
 
 // 【命令字】+【频率】+【电压】
 // 相位-封装在内部
+// M_F / M_B / STOP 放入运动队列由运动任务执行(见 motion_queue.h)，ACK表示已入队
+// 发送者选项 /D<ms> 指定有效期，超过仍未执行的 M_F / M_B 被丢弃，默认 MOTION_CMD_MAX_AGE_MS
 #define Forward "M_F"
 #define Backward "M_B"
 
@@ -33,23 +62,107 @@
 #define GET_IP "GET_IP" // 获得自身连接的IP地址
 
 #define SET_BATCH_PARAMS "SET_BATCH_PARAMS" // 批处理命令
-// SET_PARAMS 的 payload 格式: "PARAM_NAME,VALUE"
-// 可用的 PARAM_NAME 包括: 所有数值都是int
-// - "VOLTAGE"      (0-80)
-// - "DUTY"         (1-99)
-// - "FWD_FREQ"     (100-50000)
-// - "FWD_PHASE"    (0-360)
-// - "BWD_FREQ"     (100-50000)
-// - "BWD_PHASE"    (0-360)
+// payload 格式: "NAME:VALUE;NAME:VALUE..."，最多 PARAM_BATCH_MAX 个
+// 整批检查通过后一次生效(正在运动时立即生效)，任一条出错则整批不生效
+// 回复 ACK:BATCH_OK:<结果码> 或 ACK:BATCH_FAIL:<结果码>，每个参数按顺序一个字符：
+//   0 成功  U 未知参数  F 格式错误  R 超出范围  W 只读  D 重复  X 超过个数上限
+// 参数名、类型、范围和单位见 param_registry.cpp，上位机可用 PARAM_SCHEMA 查询:
+// - "VOLTAGE"       整数 (0-80 V)
+// - "DUTY"          浮点 (0.1-99.9 %)
+// - "FWD_FREQ"      整数 (100-50000 Hz)
+// - "FWD_PHASE"     浮点 (0-360 deg)
+// - "BWD_FREQ"      整数 (100-50000 Hz)
+// - "BWD_PHASE"     浮点 (0-360 deg)
+// - "STEP_TIME_MS"  浮点 (0-60000 ms)
+// - "STILL_TIME_MS" 浮点 (0-60000 ms)
+
+// 设备启动时报告自身参数；上位机发送(payload为空)时回复全部参数的当前值
+// 负载格式: "NAME:VALUE;NAME:VALUE..."，另含只读的 STEP_MODE_ENABLED 和 direction_reversed
+#define REPORT_ALL_PARAMS "REPORT_ALL_PARAMS"
 
-#define REPORT_ALL_PARAMS "REPORT_ALL_PARAMS" // 设备启动报告自身参数
+// 查询单个参数; payload: 参数名，回复 GET_PARAM:<NAME>:<VALUE>
+#define GET_PARAM "GET_PARAM"
+
+// 分页下载参数说明; payload: 起始序号(空为0)
+// 回复 PARAM_SCHEMA:<起始序号>,<参数总数>,<哈希>;NAME,ID,TYPE,MIN,MAX,UNITS,RW;...
+// TYPE为I/F/B(整数/浮点/0或1)，RW为W(可写)或R(只读)，ID与二进制帧的参数ID一致
+// 一页放不下时截断，从 起始序号+本页条数 继续请求；哈希不变时上位机可直接用缓存
+#define PARAM_SCHEMA "PARAM_SCHEMA"
+
+// 按版本查询参数变化; payload: <纪元>,<版本>，空表示全部
+// 回复 PARAM_DELTA:<纪元>,<版本>;NAME:VALUE;... ，只含该版本之后变化的参数
+// 纪元为4位十六进制，设备重启后改变，此时回复全部参数；版本为十进制
+// 参数变化后设备也主动发出同样格式的通知(PARAM_NOTIFY_DEFAULT)，见 param_store.h
+// 组播请求引起的通知在本机回复时隙内发出，只有 <纪元>,<版本>，不带参数值
+#define PARAM_DELTA "PARAM_DELTA"
 
 #define SWAP_DIRECTION "SWAP_DIR" // 切换运动方向 (前进/后退)
 
 // 启用/禁用步进模式; payload: "1" 或 "0"
 #define ENABLE_STEP_MODE "STEP_MODE"
 
+// 查询链路统计，分页回复; payload: 空或"TX"(发送队列、丢弃、空中时间占空比)、
+// "AUX"(AUX等待、串口波特率、紧急停止延迟、运动队列)、"NET"(转发、时钟同步、定时执行、回复时隙)
+// 运动队列: MOTION_Q:<执行>,<过期丢弃>,<被STOP清除>,<队列满>,<最大延迟us>
+#define LINK_STATS "LINK_STATS"
+
+// 开启/关闭多跳转发; payload: "1" 或 "0"，回复 ACK:RELAY_MODE,ENABLED/DISABLED
+// "2" 开启转发并汇总下游发给上位机的ACK，回复 ACK:RELAY_MODE,AGGREGATE，见 reply_slot.h
+// 帧格式见 relay.h，转发统计见 LINK_STATS:NET
+#define RELAY_MODE "RELAY_MODE"
+
+// 开启/关闭发送方向的字典压缩; payload: "1" 或 "0"，回复 ACK:DICT_MODE,ENABLED/DISABLED
+// 接收方向总是自动展开，码字与词条见 text_dict.h
+#define DICT_MODE "DICT_MODE"
+
+// 开启/关闭ESP-NOW近距离传输; payload: "1" 或 "0"，回复 ACK:ESPNOW,ENABLED/DISABLED
+// "PEERS" 查询邻居，回复 ESPNOW:PEERS:<设备号,...>;TX:<单播>,<广播>,<失败>;RX:<收到>,<丢弃>
+// 邻居发现与单播/广播规则见 espnow_link.h
+#define ESPNOW "ESPNOW"
+// 经ESP-NOW把一帧发给邻居，本机作为发送者; payload: <接收者>:<命令>:<负载>
+// 例：SR_01:HOST:ESPNOW_SEND:SR_02:M_F:  SR_01 发出 SR_02:SR_01:M_F:
+// 回复 ACK:ESPNOW_SEND,OK|FAILED
+#define ESPNOW_SEND "ESPNOW_SEND"
+// 邻居发现广播，设备自动发出，由ESP-NOW传输层消化，不进入命令处理
+#define ESPNOW_HELLO "ESPNOW_HELLO"
+
+// 设置本机所属的组并保存到NVS; payload: 逗号分隔的组名，例如 "legs,front"
+// 空负载表示退出所有组，回复 ACK:SET_GROUPS,<组数>；接收者写法见 address_filter.h
+#define SET_GROUPS "SET_GROUPS"
+
+// 设置组播回复的时隙号并保存到NVS; payload: 0-254，或 "AUTO" 由设备号推导
+// 回复 ACK:SET_SLOT,<时隙号>,<时隙宽度ms>；时隙规则见 reply_slot.h
+#define SET_SLOT "SET_SLOT"
+
+// 时钟同步信标，上位机周期性广播; payload: 上位机发送时的时间(us，十进制)
+// 例：ALL:HOST:SYNC:123456789012  之后可用 /A<时间> 安排命令定时执行，见 scheduled_command.h
+#define SYNC "SYNC"
+
+// 运行时修改模块信道/功率/空速，只写入与当前不同的寄存器并保存到NVS
+// payload: CH:<0-127>;PWR:<0-3>;AIR:<0-7>;BAUD:<9600..115200>;FIXED:<0|1>，省略的项保持不变
+// FIXED:1 切换为定点传输：模块地址为 组号GroupNum + 设备号，只收发给本机和广播的帧，
+// 上位机的模块地址为 GroupNum + BIN_ID_HOST，发送时每帧前加2字节帧头，
+// 帧头由 loraFixedHeader(GroupNum, fixedModeAddress(帧)) 生成，见 lora_config.h
+// 配合 /A<时间> 选项可让全队在同一时刻切换(上位机须同时切换自己的模块)
+// 切换后回复 ACK:LORA_CFG,APPLIED|FALLBACK|FAILED,信道,功率,空速,波特率,定点传输(0|1)
+#define LORA_CFG "LORA_CFG"
+
+// 链路探测：收到PING原样回复PONG:<payload>，上位机可用来测量往返时延
+// LORA_CFG切换串口波特率后设备也会向上位机发PING，收不到PONG则退回9600并保存；
+// 上电配置不发PING，波特率只由模块的写入回显确认。上位机应答见 Com-Test.py pong
+#define PING "PING"
+#define PONG "PONG"
+
+// 估算设备各类回复帧在给定空速下的空中时间，供上位机按信道容量规划队伍规模
+// payload: 空(当前空速)或空速等级0-7，回复 AIRTIME:<bps>;ACK=<us>;PONG=<us>;...
+#define AIRTIME "AIRTIME"
+
 // 统一的确认回复命令  原参数返回，加一个ACK
 #define ACK "ACK"
+// 发送者字段带会话号和序列号(HOST/E4821/S17)时，设备额外回复累计ACK：ACK:SEQ,<累计序号>,<位图>
+// 设备不知道该会话此前的序号时只接受序号1，其余回复 ACK:SEQ_RESYNC,<会话号> 且不执行
+// 详见 reliable_link.h；再带 /W<窗口> 时为流水线模式：按序执行，处理函数不单独回复ACK，
+// 累计ACK多一个失败位图：ACK:SEQ,<累计序号>,<位图>,<失败位图>
+// 同一目标的多条ACK可能被合并为一帧，负载之间用'|'分隔：ACK:BATCH_OK|SEQ,12,0
 
 #endif /* Command LORA */
\ No newline at end of file
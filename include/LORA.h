@@ -3,49 +3,265 @@
 
 // 全局用透明模式，发送内容：【目标设备ID】+【命令字】+【发送设备ID】，符合设备ID的应答；
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "frame_parser.h"
+#include "lora_config.h"
+#include "tx_scheduler.h"
 #include <Arduino.h>
 #include <Preferences.h>
 
+#define LORA_RX_BUFFER_SIZE 1024 // Serial1接收环形缓冲区大小(字节)
+#define LORA_RX_CHUNK_SIZE 128   // LoRa任务每次批量读取的最大字节数
+#define LORA_RX_IDLE_POLL_MS 100 // 无事件时的兜底轮询周期，防止丢失通知
+// 串口空闲多少个字符时间后产生接收事件(默认10)，决定STOP标记从到达到被识别的延迟
+#define LORA_RX_TIMEOUT_SYMBOLS 2
+
+#define LORA_TX_QUEUE_DEPTH 6 // 每个优先级队列的深度，满了直接丢弃
+
+#define LORA_DUTY_CYCLE_PERMILLE 100 // 本机允许的最大空中占空比(千分比)
+#define LORA_DUTY_WINDOW_MS 10000    // 占空比统计窗口
+
+#define LORA_AUX_TIMEOUT_MS 1000 // 等待AUX变高的超时，超时后复位模块
+#define LORA_AUX_SETTLE_MS 2     // AUX变高后的默认稳定延时(原来固定20ms)
+#define LORA_MODE_SWITCH_MS 10   // MD0/MD1切换后等待模块响应的时间
+#define LORA_CONFIG_REPLY_MS 200 // 配置模式下等待模块回复的时间
+#define LORA_UART_BAUD 115200     // 期望的串口波特率，配置模式固定为9600
+// 运行中用LORA_CFG改变波特率后ping上位机确认，上电配置不发PING
+#define LORA_PING_TIMEOUT_MS 1500 // 切换波特率后等待上位机PONG的时间
+#define LORA_PING_ATTEMPTS 3      // 一次切换最多发几次PING
+// 每次PING前随机等待，同时切换的设备不会在同一时刻发出PING
+#define LORA_PING_JITTER_MS 500
+
 extern String deviceID;
 extern String hostID;
+extern uint8_t deviceNum; // 二进制帧中使用的1字节设备ID，由deviceID推导
+
+// 发送优先级，数值越小越先发送
+enum LoraTxPriority {
+    LORA_TX_HIGH,   // ACK、停止相关的回复
+    LORA_TX_NORMAL, // 普通回复
+    LORA_TX_LOW,    // 参数上报、IP上报等状态报告
+    LORA_TX_PRIORITY_COUNT
+};
+
+// 发送统计
+struct LoraTxStats {
+    uint32_t sent;                             // 已发送帧数
+    uint32_t dropped[LORA_TX_PRIORITY_COUNT];  // 队列满或帧过长被丢弃的帧数
+    uint32_t queued[LORA_TX_PRIORITY_COUNT];   // 当前各队列中的帧数
+    uint32_t maxDepth[LORA_TX_PRIORITY_COUNT]; // 各队列出现过的最大深度
+    uint32_t failed; // 模块复位后仍未就绪而放弃的帧数
+};
+
+// AUX等待统计，单位微秒
+enum LoraConfigResult {
+    LORA_CONFIG_APPLIED,
+    LORA_CONFIG_FALLBACK, // 新波特率ping不通，已退回9600，无线参数已生效
+    LORA_CONFIG_FAILED,
+};
+
+struct LoraAuxStats {
+    uint32_t lastFrameWaitUs; // 最近一帧发送前后等待AUX的总时间
+    uint32_t maxFrameWaitUs;  // 单帧等待AUX的最大时间
+    uint64_t totalWaitUs;     // 累计等待时间
+    uint32_t frames;          // 统计的帧数
+    uint32_t timeouts;        // AUX等待超时次数
+    uint32_t resets;          // 通过MD0/MD1复位模块的次数
+    uint32_t settleMs;        // 当前使用的稳定延时
+};
+
+// 紧急停止快速路径统计，时间从接收回调开始读取到输出关闭，单位微秒
+// 不含字节到达后等待LORA_RX_TIMEOUT_SYMBOLS个字符时间产生事件的部分
+struct LoraFastStopStats {
+    uint32_t count;  // 触发次数
+    uint32_t lastUs; // 最近一次的延迟
+    uint32_t maxUs;  // 出现过的最大延迟
+};
+
+// 一帧的发送方式，由发出该帧的一方随帧传入，LORA对象本身不保存
+struct LoraTxRoute {
+    uint8_t ttl = 0;    // 上位机经几跳转发到达本机，帧带上同样的/T选项，0为直连
+    bool held = false;  // 组播请求的回复：暂存到本机时隙(见reply_slot.h)
+    uint32_t dueMs = 0; // held时开始发送的时刻
+};
 
 class LORA {
   private:
     Preferences prefs;
     String deviceID;
 
+    QueueHandle_t txQueues[LORA_TX_PRIORITY_COUNT];
+    SemaphoreHandle_t txWake; // 有新帧入队时唤醒发送任务
+    LoraTxStats txStats;
+    TxScheduler txScheduler; // 合并与空中时间预算，只由发送任务访问
+
+    void drainTxQueues(); // 把各队列中的帧移入调度器
+
+    LoraAuxStats auxStats;
+    uint32_t auxTimeoutMs;
+    uint32_t auxSettleMs;
+
+    volatile bool dictTx; // 发出的文本帧是否用字典压缩(见text_dict.h)
+
+    LoraRadioParams radio;         // 模块当前的信道/功率/空速
+    LoraRadioParams pendingRadio;  // 等待发送任务切换的新配置
+    uint32_t pendingBaud;
+    LoraTxRoute pendingRoute;      // 切换完成后的ACK按请求的路由发回
+    uint32_t uartBaud;             // Serial1与模块之间当前的波特率
+    volatile bool fixedMode;       // 模块处于定点传输，每帧前写帧头(见lora_config.h)
+    bool pendingFixed;
+    volatile bool radioPending;
+    volatile bool configuring;     // 处于配置模式，接收任务暂停读取Serial1
+
+    // 接收路径：UART事件回调读出Serial1，先识别STOP标记，再转交LoRa任务组帧
+    StreamBufferHandle_t rxStream;   // 回调写入、LoRa任务读取
+    SemaphoreHandle_t rxLock;        // 同一时刻只有一个写入者(回调或兜底读取)
+    uint8_t rxPumpChunk[LORA_RX_CHUNK_SIZE]; // 持有rxLock时使用，不占回调栈
+    StopTokenDetector stopDetector;
+    void (*stopHandler)();
+    LoraFastStopStats fastStopStats;
+
+    bool enterConfigMode();                   // MD0=MD1=低，清空残留的接收数据
+    bool leaveConfigMode(uint32_t &waitedUs); // 回到正常工作模式并等待AUX
+    /**
+     * @brief 配置模式下写入一段寄存器，等待模块回显
+     * @param offset 相对LORA_REG_BASE的偏移
+     */
+    bool writeRegisters(uint8_t offset, const uint8_t *data, uint8_t len);
+    bool readReply(uint8_t *buf, size_t len); // 按LORA_CONFIG_REPLY_MS超时读取
+    /**
+     * @brief 与NVS中上次写入的寄存器副本比较，只写入不同的段(须已在配置模式)
+     * 没有副本(首次启动、上次写入中途失败)时整块写入；写入成功后更新副本
+     * @param force 不比较，整块写入
+     * @return int 写入的段数，失败返回-1
+     */
+    int syncRegisters(const uint8_t *desired, bool force);
+    bool loadRegisters(uint8_t *regs);       // 读取NVS中的寄存器副本
+    void saveRegisters(const uint8_t *regs); // NULL表示清除副本
+    bool pingHost(); // 发送PING并等待上位机回复PONG，验证当前波特率可用
+    /**
+     * @brief 9600波特率下写入配置，回到正常模式后切换Serial1波特率
+     * 只在本地核对：写入的寄存器(含波特率)由模块回显逐字节确认，不与上位机通信
+     * @param force 不与NVS副本比较，整块写入
+     * @return LoraConfigResult APPLIED或FAILED
+     */
+    LoraConfigResult applyConfig(uint8_t *desired, bool force);
+    /**
+     * @brief 运行中切换波特率后ping上位机确认，失败时模块和Serial1都退回9600
+     * 只在上位机发来LORA_CFG之后调用，上电时上位机可能还没运行
+     * @return LoraConfigResult APPLIED或FALLBACK
+     */
+    LoraConfigResult confirmBaud(uint8_t *desired);
+    // 把当前无线参数、串口波特率和传输模式保存到NVS
+    void saveConfig();
+    // 按传输模式改写目标寄存器：定点传输时本地组号GroupNum、本地地址deviceNum
+    void setAddressing(uint8_t *regs, bool fixed);
+    void applyPendingRadio(); // 由发送任务调用，切换期间不会有帧在发送
+
+    /**
+     * @brief 阻塞发送，只由发送任务调用
+     * @param text 压缩发送时用于日志的明文，NULL表示data本身
+     */
+    void transmit(const char *data, size_t len, const char *text = NULL);
+
+    /**
+     * @brief 等待AUX变高(模块空闲)：由GPIO中断+任务通知唤醒，不占用CPU
+     * @param waitedUs 输出本次等待的时间
+     * @return bool 超时返回false
+     */
+    bool waitAUXReady(uint32_t &waitedUs);
+    bool resetModule(); // 通过MD0/MD1进出深度睡眠复位模块，返回是否恢复就绪
+
   public:
     LORA(); // 构造函数
     ~LORA();
     String getDeviceID(); // 返回设备ID，如果失败返回"unknown"
+    String getGroups();   // 从NVS读取本机所属的组，逗号分隔
+    bool loadConfig(LoraRadioParams &radio); // 从NVS读取运行时修改过的无线参数
+    uint32_t loadUartBaud(); // 从NVS读取串口波特率，默认LORA_UART_BAUD
+    bool loadFixedMode(); // 从NVS读取是否使用定点传输，默认LORA_FIXED_MODE_DEFAULT
+    void saveGroups(const char *groups); // 保存本机所属的组到NVS
+    uint8_t loadReplySlot(); // 从NVS读取指定的时隙号，未指定返回REPLY_SLOT_AUTO
+    void saveReplySlot(uint8_t slot);
     void sendHexCommand(const char *hexString,
                         HardwareSerial &serialPort); // 发送LORA指令
     void initLORA();
-    void sendData(const String &data); // 给上位机HOST发送数据
+    void enableRxEvents(); // 注册串口接收事件，有数据到达时唤醒LoRa任务
+
+    /**
+     * @brief 把Serial1中的数据搬到接收流，逐字节识别STOP标记，然后唤醒LoRa任务
+     * 由串口接收事件回调调用(UART事件任务，优先级最高)；另一方正在搬运时直接返回
+     */
+    void pumpRx();
+    /**
+     * @brief LoRa任务读取接收流，流为空时自己搬运一次(兜底丢失的事件)
+     * @return size_t 读出的字节数，没有数据返回0
+     */
+    size_t readRx(uint8_t *buf, size_t cap);
+    /**
+     * @brief 设置识别到STOP标记时在回调中直接调用的函数
+     * 运行在UART事件任务中：只能关闭输出，不能打印或阻塞
+     */
+    void setStopHandler(void (*handler)()) { stopHandler = handler; }
+    LoraFastStopStats getFastStopStats() { return fastStopStats; }
+    void initTxQueue(); // 创建发送队列，必须在发送任务启动前调用
+
+    /**
+     * @brief 给上位机HOST发送数据：只入队，不阻塞调用者
+     * @param data 完整的协议帧(含'\n')
+     * @param priority 发送优先级
+     * @param route 转发跳数与时隙，默认直连、立即发送
+     * @return bool 队列已满或帧过长时返回false(计入丢弃统计)
+     */
+    bool sendData(const String &data, LoraTxPriority priority = LORA_TX_NORMAL,
+                  const LoraTxRoute &route = LoraTxRoute());
+    bool sendData(const char *data, size_t len,
+                  LoraTxPriority priority = LORA_TX_NORMAL,
+                  const LoraTxRoute &route = LoraTxRoute());
+
+    /**
+     * @brief 发送任务主体：经调度器合并、限速后取出一帧并写入Serial1
+     * @param timeout 等待新帧的最长时间
+     * @return bool 是否发送了一帧
+     */
+    bool processTxQueue(TickType_t timeout);
+
+    LoraTxStats getTxStats();
+    TxSchedulerStats getSchedulerStats();
+    LoraAuxStats getAuxStats();
+
+    void setAuxTimeoutMs(uint32_t ms) { auxTimeoutMs = ms; }
+    void setAuxSettleMs(uint32_t ms) { auxSettleMs = ms; }
+
+    // 开启后发出的文本帧用字典压缩，接收方向总是自动展开
+    void setDictCompression(bool enable) { dictTx = enable; }
+    bool isDictCompression() const { return dictTx; }
+
+    /**
+     * @brief 请求切换信道/功率/空速、串口波特率和传输模式：发送任务发完当前帧后
+     * 进入配置模式写入，并保存到NVS，重启后initLORA按同样的差异方式恢复
+     * @param fixed 定点传输，由模块按本机地址过滤其他设备的帧
+     * @param route 切换完成后ACK:LORA_CFG的发送方式，与请求的回复相同
+     * @return bool 参数越界，或本机名字中没有设备号却要求定点传输时返回false
+     */
+    bool requestRadioConfig(const LoraRadioParams &next, uint32_t baud,
+                            bool fixed,
+                            const LoraTxRoute &route = LoraTxRoute());
+    LoraRadioParams getRadio() const { return radio; }
+    uint32_t getUartBaud() const { return uartBaud; }
+    bool isFixedMode() const { return fixedMode; }
+    bool rxSuspended() const { return configuring; }
 };
 
 extern LORA lora; // 还需要在LORA.cpp中定义这个变量,这里只是全局引用声明而已
 
 #endif /* __WIFICONFIG_H */
 
-// 命令解析：
-/*信道0-127 2^7     4种功率等级2^2      8种空速2^3
-信道0x50 功率等级2，空速等级2 等级越高约大；
-1010000 01 001
-0a09
-
-80（CMD关键字） 04（参数起始地址，波特率开始）
-1E（要配置的寄存器长度，默认30个） （00 01 C2 00波特率 10进制直接转换）
-00（校验位，ODD16，EVEN14） 0A 09（信道+功率+空速） 00
-04（0001透传/0004主从/0002定点/0021中继）05 03
-E8（默认保留，不动）00（主机00/从机01）77 77 77 2E 61 73 68 69 6E 69 6E 67 2E 63
-6F 6D（16个密钥） 7C 7C 7C 7C 7C（保留5个）05 40 00 23 00 00 00 3C 3C（保留）
-00（唤醒时间 100ms为单位，对于接收方即为休眠时间，两者配置相同或唤醒＞休眠）0A
-19（保留） 00 00（保留）00
-00（0000不发送唤醒码，0080发送唤醒码）00（本地组号/FF为广播）
-10（本地地址/FF为广播）00（目标地址） 10（目标组号）00 00 00 00 50
-00（保留，中继模式相关设置）
-*/
+// 寄存器格式与各字段含义见 lora_config.h 中的 LoraModuleConfig，
+// 默认配置 LORA_DEFAULT_CONFIG 见 Command.h，非法组合在编译期报错
 
 /*
 主从模式下，主机无需配置目标地址，从机需要/透明模式下每个人均需配置目标地址。
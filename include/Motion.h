@@ -3,30 +3,47 @@
 #define __Motion_H
 
 #include "Pins.h"
+#include "motion_params.h"
 #include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include <Arduino.h>
 #include <stdint.h> //这里定义uint32_t和uint16_t数据变量
 
+enum MotionState : uint8_t {
+    MOTION_IDLE,
+    MOTION_FORWARD, // moveForward启动，与方向切换标志无关
+    MOTION_BACKWARD,
+};
+
 // 类的声明
+// 运动任务(启动、停止)和LoRa任务(参数、方向、步进模式)都会操作MCPWM和运动状态，
+// 这些公有函数都持有同一把锁执行；haltOutputs不取锁，由stopEpoch()保证不被撤销
 class Motion {
   public:
     Motion();
     ~Motion();
     //*****************MCPWM*****************
-    void init();
+    void init(); // 创建锁，必须在创建使用Motion的任务之前调用
     void stop();
+    void haltOutputs(); // 立即关闭输出，不打印日志，供紧急停止快速路径使用
+
+    // 每次停止加一；运动任务据此丢弃停止之前取出或排队的运动命令
+    uint32_t stopEpoch() const { return _stopEpoch; }
 
     void moveForward();
     void moveBackward();
 
-    // --- 参数设置函数 ---
+    // --- 参数读写，按整组进行，见 motion_params.h ---
 
-    bool setGlobalVoltage(int voltage);
-    bool setGlobalDutyCycle(float dutyCycle);
-    bool setForwardFreq(uint32_t freq);
-    bool setForwardPhase(float phase);
-    bool setBackwardFreq(uint32_t freq);
-    bool setBackwardPhase(float phase);
+    MotionParams getParams() const;
+
+    /**
+     * @brief 整组检查并提交运动参数，调压PWM和MCPWM各至多重新设置一次
+     * 正在运动时新的频率、相位、占空比立即生效，否则在下一次启动时生效
+     * @return bool 任一参数超出范围时返回false，参数和硬件都不变
+     */
+    bool applyParams(const MotionParams &next);
 
     void swapDirection();             // 切换运动方向
     bool isDirectionReversed() const; // 获取运动状态
@@ -35,10 +52,6 @@ class Motion {
 
     void enableStepMode(bool enable); // 切换步进模式
     bool isStepModeEnabled() const;   // 获取当前是否为步进模式
-    bool setStepTime(float step_time_ms);
-    bool setStillTime(float still_time_ms);
-
-    String getAllParamsAsString(); // 获取所有运动参数
 
   private:
     void setupMCPWM();
@@ -56,6 +69,18 @@ class Motion {
      */
     void _applyVoltage();
 
+    /**
+     * @brief 按逻辑方向和方向切换标志选择前进或后退参数组并应用
+     */
+    void _applyDirectionParams(bool forward);
+
+    /**
+     * @brief 按当前模式打开输出；从epoch取得之后有过停止则保持停止
+     * 紧急停止在串口事件任务中执行，可能发生在moveForward/moveBackward中途
+     * @param epoch 开始设置参数前的 stopEpoch()
+     */
+    void _startOutputs(uint32_t epoch);
+
     void _internal_start_mcpwm();
     void _internal_stop_mcpwm();
     static void stepTimerCallback(void *arg);
@@ -68,6 +93,8 @@ class Motion {
     uint32_t backward_freq;
     float backward_phase_deg;
     bool _isDirectionReversed; // 运动方向切换标志位
+    volatile MotionState _state; // 当前运动状态，提交参数时决定是否重设MCPWM
+    volatile uint32_t _stopEpoch; // 停止计数，见stopEpoch()
 
     //*****************Step motion*****************
     float _step_time_ms;     // 毫秒
@@ -81,6 +108,9 @@ class Motion {
     volatile bool
         isCurrentlyStepping; // 标记当前是处于“步进”还是“静止”状态 定时器用
 
+    friend class MotionLock;
+    SemaphoreHandle_t _lock; // 递归互斥锁：enableStepMode中会调用stop
+
     const int resolution = 10; // 精度2^10=1024 (取值0 ~ 20)
 };
 
@@ -6,6 +6,25 @@
 
 #define FORCE_LORA_CONFIG false // LORA配置开关，true的时候更新LORA命令
 
+#define RELAY_MODE_DEFAULT false // 上电时是否开启多跳转发，运行中可用RELAY_MODE命令切换
+
+#define TEXT_DICT_TX_DEFAULT false // 上电时发出的帧是否字典压缩，运行中可用DICT_MODE命令切换
+
+// 出厂时LoRa模块是否使用定点传输(模块按地址过滤他人的帧)，运行中可用LORA_CFG的FIXED项切换
+#define LORA_FIXED_MODE_DEFAULT false
+
+#define ESPNOW_DEFAULT true // 上电时是否开启ESP-NOW近距离传输，运行中可用ESPNOW命令切换
+
+// 参数变化后是否主动发出 PARAM_DELTA 通知(只含变化的参数)，上位机也可随时用 PARAM_DELTA 轮询
+#define PARAM_NOTIFY_DEFAULT true
+
+// 运动命令(M_F/M_B)的默认有效期：收到后超过该时间仍未执行则丢弃，发送者选项/D<ms>可单独指定
+#define MOTION_CMD_MAX_AGE_MS 500
+
+// USB串口：调试输出，同时接收台架上位机的协议帧(见reply_channel.h)
+#define USB_SERIAL_BAUD 921600
+#define USB_RX_BUFFER_SIZE 1024 // 高波特率下LoRa任务忙时也能暂存几帧
+
 #define WIFI_SSID "gaoyu"
 #define WIFI_PASS "123456789" // OTA用
 
@@ -20,6 +39,17 @@
 #define DEFAULT_BWD_FREQ 20000   // 默认后退频率 (Hz)
 #define DEFAULT_BWD_PHASE 270.0f // 默认后退相位 (度)
 
+// 参数范围，Motion的设置函数和参数注册表(param_registry.cpp)共用
+#define VOLTAGE_MIN 0
+#define VOLTAGE_MAX 80
+#define DUTY_MIN 0.1f
+#define DUTY_MAX 99.9f
+#define FREQ_MIN 100
+#define FREQ_MAX 50000
+#define PHASE_MIN 0.0f
+#define PHASE_MAX 360.0f
+#define STEP_TIME_MAX_MS 60000.0f // 步进/静止时间上限，换算成微秒不溢出uint32_t
+
 // LORA
 #define MD0 22  // 00：配置模式
 #define MD1 19  // 10：工作模式  11：深度睡眠模式
@@ -0,0 +1,81 @@
+// --- 文件名: include/address_filter.h ---
+// 接收者字段匹配：一帧可以同时发给任意一组设备
+//
+// RECEIVER 字段支持的写法：
+//   SR_05          单个设备
+//   ALL            所有设备
+//   @legs          组播：设备所属的组名保存在NVS中，见SET_GROUPS命令
+//   #3-12,15       设备号区间，逗号分隔，设备号即binaryIdFromName得到的1字节ID
+//   $F0F0F         位图，十六进制高位在前，第n位为1表示设备号n
+// 本机名字和组名在启动时预先算好哈希，每帧只需一次哈希和几次整数比较
+// 本模块不依赖Arduino
+
+#ifndef __ADDRESS_FILTER_H__
+#define __ADDRESS_FILTER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ADDR_GROUP_PREFIX '@'
+#define ADDR_RANGE_PREFIX '#'
+#define ADDR_MASK_PREFIX '$'
+#define ADDR_GROUP_MAX 8       // 每个设备最多加入的组数
+#define ADDR_GROUP_NAME_MAX 15 // 组名最大长度
+#define ADDR_GROUP_SEPARATOR ','
+
+enum AddressMatch {
+    ADDR_OTHER,        // 发给其他单个设备
+    ADDR_SELF,         // 发给本机
+    ADDR_GROUP_MEMBER, // 组播/广播，本机在其中
+    ADDR_GROUP_OTHER,  // 组播，本机不在其中
+};
+
+class AddressFilter {
+  public:
+    AddressFilter();
+
+    /**
+     * @brief 设置本机名字和设备号，名字的哈希只在这里计算一次
+     */
+    void setSelf(const char *name, size_t len, uint8_t num);
+
+    /**
+     * @brief 设置本机所属的组
+     * @param csv 逗号分隔的组名，例如 "legs,front"，空字符串表示不属于任何组
+     * @return bool 组名过长或组数超过ADDR_GROUP_MAX时返回false，原设置不变
+     */
+    bool setGroups(const char *csv, size_t len);
+    uint8_t groupCount() const { return groups; }
+
+    AddressMatch match(const char *receiver, size_t len) const;
+
+    static bool isMulticast(AddressMatch m) {
+        return m == ADDR_GROUP_MEMBER || m == ADDR_GROUP_OTHER;
+    }
+    static bool isForMe(AddressMatch m) {
+        return m == ADDR_SELF || m == ADDR_GROUP_MEMBER;
+    }
+
+  private:
+    bool inRanges(const char *list, size_t len) const;
+    bool inMask(const char *hex, size_t len) const;
+
+    uint32_t selfHash;
+    size_t selfLen;
+    uint8_t selfNum;
+    uint32_t groupHash[ADDR_GROUP_MAX];
+    uint8_t groups;
+};
+
+/**
+ * @brief LoRa模块定点传输时一帧应当写入的目标地址(见lora_config.h)
+ * 发给单个设备时为其设备号，上位机为BIN_ID_HOST；ALL、组播、区间、位图地址，
+ * 带/T选项需要中继转发的帧、以及二进制帧都用LORA_ADDR_BROADCAST，
+ * 软件过滤(match)照常进行。设备和上位机用同一个函数，两端的帧头一致
+ * @param frame 文本协议帧 RECEIVER:SENDER:...，可以不含'\n'
+ */
+uint8_t fixedModeAddress(const char *frame, size_t len);
+
+extern AddressFilter addressFilter; // 定义在LORA.cpp，与deviceID一起在启动时设置
+
+#endif // __ADDRESS_FILTER_H__
@@ -0,0 +1,141 @@
+// --- 文件名: include/binary_frame.h ---
+// 紧凑二进制帧格式，与文本协议并存，上位机与下位机共用同一份编解码代码
+//
+// 线上格式：【0xB5同步字节】+【COBS编码的帧体】+【0x00结束符】
+// 帧体：    【接收者ID 1B】+【发送者ID 1B】+【操作码 1B】+【参数...】+【CRC16 2B】
+//   - ID：HOST=0x00，ALL=0xFF，设备ID取名字末尾的数字 (SR_01 -> 0x01)
+//   - 参数：SET_BATCH_PARAMS 为若干组 varint(参数ID) + zigzag varint(值)
+//          STEP_MODE 等单值命令只有一个 zigzag varint(值)，见 BinaryArgKind
+//   - 参数ID、名字和类型都取自参数注册表(param_registry.h)，
+//     PARAM_FLOAT 按 BIN_PARAM_SCALE_CENTI 放大100倍后以整数传输，其余类型原样传输
+//   - CRC16/CCITT-FALSE (多项式0x1021，初值0xFFFF)，覆盖CRC之前的全部字节，高字节在前
+// 文本帧是纯ASCII且不含0xB5，所以接收端看帧首字节即可区分两种格式
+
+#ifndef __BINARY_FRAME_H__
+#define __BINARY_FRAME_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BIN_FRAME_SYNC 0xB5      // 二进制帧同步字节
+#define BIN_FRAME_DELIMITER 0x00 // COBS编码后帧内不会出现0x00，用作结束符
+
+#define BIN_ID_HOST 0x00      // 上位机
+#define BIN_ID_BROADCAST 0xFF // 对应文本协议中的 "ALL"
+
+#define BIN_MAX_PARAMS 12   // 单帧最多携带的参数个数
+#define BIN_MAX_BODY_LEN 96 // 帧体最大长度(未编码，含CRC)
+// 线上最大长度：同步字节 + COBS开销 + 帧体 + 结束符
+#define BIN_MAX_WIRE_LEN (1 + BIN_MAX_BODY_LEN + BIN_MAX_BODY_LEN / 254 + 1 + 1)
+
+// 操作码，与 Command.h 中的命令字一一对应，只能在末尾追加
+enum BinaryOpcode {
+    BIN_OP_FORWARD = 0x01,
+    BIN_OP_BACKWARD = 0x02,
+    BIN_OP_STOP = 0x03,
+    BIN_OP_OTA_ENABLE = 0x04,
+    BIN_OP_OTA_DISABLE = 0x05,
+    BIN_OP_SWAP_DIRECTION = 0x06,
+    BIN_OP_STEP_MODE = 0x07,
+    BIN_OP_SET_BATCH_PARAMS = 0x08,
+    BIN_OP_REPORT_ALL_PARAMS = 0x09,
+    BIN_OP_GET_PARAM = 0x0A,
+    BIN_OP_PARAM_SCHEMA = 0x0B,
+    BIN_OP_PARAM_DELTA = 0x0C,
+    BIN_OP_LINK_STATS = 0x0D,
+};
+
+// 参数ID，名字、类型和范围登记在 param_registry.cpp 的参数表中，只能在末尾追加
+enum BinaryParamId {
+    BIN_PARAM_VOLTAGE = 0x01,
+    BIN_PARAM_DUTY = 0x02,
+    BIN_PARAM_FWD_FREQ = 0x03,
+    BIN_PARAM_FWD_PHASE = 0x04,
+    BIN_PARAM_BWD_FREQ = 0x05,
+    BIN_PARAM_BWD_PHASE = 0x06,
+    BIN_PARAM_STEP_TIME_MS = 0x07,
+    BIN_PARAM_STILL_TIME_MS = 0x08,
+    BIN_PARAM_STEP_MODE_ENABLED = 0x09,
+    BIN_PARAM_DIRECTION_REVERSED = 0x0A,
+};
+
+// 操作码的参数形式
+enum BinaryArgKind {
+    BIN_ARGS_NONE,       // 无参数
+    BIN_ARGS_VALUE,      // 空或单个整数值
+    BIN_ARGS_PARAM_LIST, // NAME:VALUE;NAME:VALUE...
+    BIN_ARGS_PARAM_ID,   // 单个参数名，线上为 varint(参数ID)
+    BIN_ARGS_VERSION,    // 空或 <纪元(十六进制)>,<版本>，线上为两个值
+    BIN_ARGS_PAGE,       // 空或页名(TX/AUX/NET)，线上为页号
+};
+
+enum BinaryParamScale {
+    BIN_PARAM_SCALE_UNIT = 1,   // 整数参数
+    BIN_PARAM_SCALE_CENTI = 100 // 浮点参数，保留两位小数
+};
+
+struct BinaryParam {
+    uint8_t id;    // 参数ID，只用于 BIN_ARGS_PARAM_LIST / BIN_ARGS_PARAM_ID
+    int32_t value; // 已按比例放大的整数值
+};
+
+struct BinaryFrame {
+    uint8_t receiver;
+    uint8_t sender;
+    uint8_t opcode;
+    uint8_t paramCount;
+    BinaryParam params[BIN_MAX_PARAMS];
+};
+
+/**
+ * @brief CRC16/CCITT-FALSE
+ */
+uint16_t binaryCrc16(const uint8_t *data, size_t len);
+
+/**
+ * @brief 把设备名映射为1字节ID：HOST->0x00，ALL->0xFF，其余取末尾数字
+ * @return uint8_t 名字中没有数字时返回BIN_ID_BROADCAST
+ */
+uint8_t binaryIdFromName(const char *name);
+uint8_t binaryIdFromName(const char *name, size_t len);
+
+/**
+ * @brief 操作码与文本命令字互查
+ * @return 找不到时分别返回NULL / false
+ */
+const char *binaryOpcodeName(uint8_t opcode);
+bool binaryOpcodeFromName(const char *command, uint8_t &opcode);
+
+/**
+ * @brief 参数ID与文本参数名互查，查的是参数注册表
+ */
+const char *binaryParamName(uint8_t id);
+bool binaryParamFromName(const char *name, size_t len, uint8_t &id);
+
+/**
+ * @brief 编码一帧，输出包括同步字节和结束符在内的完整线上数据
+ * @return size_t 写入out的字节数，失败返回0
+ */
+size_t encodeBinaryFrame(const BinaryFrame &frame, uint8_t *out, size_t cap);
+
+/**
+ * @brief 解码一帧
+ * @param wire 同步字节和结束符之间的COBS数据
+ * @return bool COBS、长度、CRC、操作码和参数ID全部正确时返回true
+ */
+bool decodeBinaryFrame(const uint8_t *wire, size_t len, BinaryFrame &out);
+
+/**
+ * @brief 把文本命令的参数转成二进制参数 (上位机编码用)
+ * @return bool 参数名未知或数值无法解析时返回false
+ */
+bool binaryArgsFromText(uint8_t opcode, const char *args, BinaryFrame &frame);
+
+/**
+ * @brief 把二进制参数还原为文本协议的PAYLOAD，交给原有命令处理器
+ * out总是以'\0'结尾，失败时为空串
+ * @return bool 操作码或参数ID未知、缓冲区不足时返回false，调用方应丢弃该帧
+ */
+bool binaryArgsToText(const BinaryFrame &frame, char *out, size_t cap);
+
+#endif // __BINARY_FRAME_H__
@@ -0,0 +1,49 @@
+// --- 文件名: include/clock_sync.h ---
+// 全队时钟同步：上位机周期性广播信标 ALL:HOST:SYNC:<上位机时间us>
+// 各模块记录收到信标时的本地时间(esp_timer_get_time)，估计偏移和频率漂移
+// 信标从上位机到各模块的传输延迟基本相同，因此各模块之间的误差远小于绝对误差
+// 本模块不依赖Arduino，本地时间由调用者传入(微秒)
+
+#ifndef __CLOCK_SYNC_H__
+#define __CLOCK_SYNC_H__
+
+#include <stdint.h>
+
+#define CLOCK_DRIFT_MAX_PPB 500000 // 超过该漂移的测量视为异常(如信标丢失后重启)
+#define CLOCK_DRIFT_MIN_SPAN_US 1000000 // 两次信标间隔太短时不更新漂移
+
+class ClockSync {
+  public:
+    ClockSync();
+
+    /**
+     * @brief 收到一个信标
+     * @param hostUs 上位机发送信标时的时间
+     * @param localUs 本机收到信标时的时间
+     */
+    void onBeacon(uint64_t hostUs, int64_t localUs);
+
+    bool synced() const { return beacons > 0; }
+    uint32_t beaconCount() const { return beacons; }
+    int64_t offsetUs() const { return refHost - refLocal; } // 最近一次的偏移
+    int32_t driftPpb() const { return drift; }              // 本机相对上位机的漂移
+    int32_t lastErrorUs() const { return lastError; } // 最近一次信标与预测的差值
+
+    uint64_t localToHost(int64_t localUs) const;
+    int64_t hostToLocal(uint64_t hostUs) const;
+
+    /**
+     * @brief 把32位截断的上位机时间还原成本地时间
+     * 以当前时间为中心、前后约35分钟内的时刻都能正确还原
+     */
+    int64_t hostLowToLocal(uint32_t hostUsLow, int64_t nowLocalUs) const;
+
+  private:
+    uint64_t refHost;
+    int64_t refLocal;
+    int32_t drift;
+    int32_t lastError;
+    uint32_t beacons;
+};
+
+#endif // __CLOCK_SYNC_H__
@@ -2,12 +2,34 @@
 #ifndef __COMMAND_PROCESSOR_H__
 #define __COMMAND_PROCESSOR_H__
 
+#include "reply_channel.h"
 #include <Arduino.h>
 
+// 一条命令的执行环境，由收到命令的一方填写，随调用传给处理函数
+// 不保存在全局变量中：LoRa任务和定时执行的命令各自带着自己的环境
+struct CommandContext {
+    ReplyContext reply; // 回复发回哪个通道、经几跳、是否暂存到时隙
+    // 为false时处理函数不单独回复ACK(流水线模式，结果由累计ACK带回)
+    bool ack = true;
+    int64_t rxUs = 0;      // 收到命令的时刻，0表示现在(定时执行)
+    uint32_t maxAgeMs = 0; // 运动命令的有效期，0表示默认值，见 motion_queue.h
+};
+
 /**
  * @brief 处理从LoRa接收到的纯命令字符串
  * @param command 经过剥离DeviceID和trim后的命令
+ * @param args 命令参数，指向接收帧缓冲区，处理期间有效
+ * @param ctx 回复方式、是否ACK、收到时刻等执行环境
+ * @return bool 命令存在且执行成功；运动命令为已放入运动队列
+ */
+bool processCommand(const char *command, const char *args,
+                    const CommandContext &ctx);
+
+/**
+ * @brief 参数有变化时按reply发出 PARAM_DELTA 通知，见 param_store.h
+ * 只应在LoRa任务中调用：每处理完一帧、每执行完一条定时命令调用一次，
+ * 通知与该命令的ACK走同一回复方式；暂存到组播时隙时只发版本号
  */
-void processCommand(const String &command, const String &args);
+void reportParamChanges(const ReplyContext &reply);
 
 #endif // __COMMAND_PROCESSOR_H__
\ No newline at end of file
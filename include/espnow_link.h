@@ -0,0 +1,109 @@
+// --- 文件名: include/espnow_link.h ---
+// ESP-NOW近距离传输：相邻模块之间、或台架上的ESP32适配器直接收发文本协议帧
+// 帧格式与LoRa完全相同：RECEIVER:SENDER:COMMAND:PAYLOAD\n，收到后走同一个命令处理流程
+// LoRa仍是与上位机之间的远距离链路；OTA期间WiFi连着路由器，信道跟随路由器，
+// 与仍在ESPNOW_CHANNEL上的邻居不通，OTA关闭后恢复
+//
+// 邻居发现：每台设备每隔ESPNOW_HELLO_MS广播一帧 ALL:<本机>:ESPNOW_HELLO:
+// 收到任意一帧都按发送者名的1字节ID(binaryIdFromName)记下对方的MAC，
+// 之后发给该设备的帧单播(有链路层确认和重传)，未知设备、ALL、组播地址一律广播
+// 超过ESPNOW_PEER_EXPIRE_MS未再听到的邻居从表中移除
+//
+// 本模块不依赖Arduino和ESP-IDF，无线收发通过EspNowRadio中的函数完成，
+// 上位机可以用一组回环函数代替，在Linux上直接测试收发和邻居表逻辑
+
+#ifndef __ESPNOW_LINK_H__
+#define __ESPNOW_LINK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ESPNOW_MAC_LEN 6
+#define ESPNOW_FRAME_MAX 250          // ESP-NOW单帧最大负载(ESP_NOW_MAX_DATA_LEN)
+#define ESPNOW_PEER_MAX 16            // 邻居表条目数，ESP-NOW非加密对端上限为20
+#define ESPNOW_HELLO_MS 5000          // 邻居发现广播周期
+#define ESPNOW_PEER_EXPIRE_MS 30000   // 超过该时间未再听到则移除
+#define ESPNOW_CHANNEL 1              // OTA关闭时使用的WiFi信道，所有设备必须一致
+
+// 无线收发接口，由ESP-IDF封装(espnow_radio.h)或上位机的回环实现提供
+struct EspNowRadio {
+    bool (*send)(const uint8_t *mac, const uint8_t *data, size_t len);
+    bool (*addPeer)(const uint8_t *mac);
+    void (*removePeer)(const uint8_t *mac);
+};
+
+struct EspNowPeer {
+    uint8_t id; // 设备1字节ID，BIN_ID_BROADCAST表示空闲条目
+    uint8_t mac[ESPNOW_MAC_LEN];
+    uint32_t heardMs;
+};
+
+struct EspNowStats {
+    uint32_t sent;       // 单播发出的帧数
+    uint32_t broadcast;  // 广播发出的帧数(含邻居发现)
+    uint32_t received;   // 收到并交给命令处理的帧数
+    uint32_t sendFailed; // 无线层拒绝发送的帧数
+    uint32_t dropped;    // 格式错误或超长而丢弃的帧数
+};
+
+extern const uint8_t ESPNOW_BROADCAST_MAC[ESPNOW_MAC_LEN];
+
+class EspNowLink {
+  public:
+    EspNowLink();
+
+    /**
+     * @brief 绑定无线接口并清空邻居表，WiFi重新初始化之后也要调用
+     * @param selfId 本机1字节ID，用于忽略自己发出的帧
+     */
+    void begin(const EspNowRadio *radio, const char *self, uint8_t selfId);
+    void end() { radio = NULL; }
+    bool isActive() const { return radio != NULL; }
+
+    /**
+     * @brief 发送一帧完整的文本协议帧(含'\n')
+     * 接收者是已知邻居时单播，否则广播
+     * @return bool 无线层接受发送时返回true，不代表对方已收到
+     */
+    bool send(const char *frame, size_t len);
+
+    /**
+     * @brief 处理收到的一帧：学习发送者的MAC，邻居发现帧在这里消化
+     * @param data 收到的数据，可以带或不带结尾的'\n'
+     * @param out 需要交给命令处理的帧复制到这里(去掉'\n'，以'\0'结尾)
+     * @param cap out的大小，至少ESPNOW_FRAME_MAX+1
+     * @return size_t 需要处理的帧长度，0表示已消化或丢弃
+     */
+    size_t receive(const uint8_t *mac, const uint8_t *data, size_t len,
+                   uint32_t nowMs, char *out, size_t cap);
+
+    /**
+     * @brief 周期调用：到时间时广播邻居发现帧，并移除过期邻居
+     */
+    void poll(uint32_t nowMs);
+
+    /**
+     * @brief 邻居列表，逗号分隔的1字节ID(十进制)，用于上位机查询
+     * @return size_t 写入的字节数(不含'\0')
+     */
+    size_t formatPeers(char *out, size_t cap) const;
+
+    const EspNowPeer *findPeer(uint8_t id) const;
+    size_t peerCount() const;
+    EspNowStats getStats() const { return stats; }
+
+  private:
+    const EspNowRadio *radio;
+    const char *self;
+    uint8_t selfId;
+    EspNowPeer peers[ESPNOW_PEER_MAX];
+    uint32_t nextHelloMs;
+    bool helloSent;
+    EspNowStats stats;
+
+    void learn(uint8_t id, const uint8_t *mac, uint32_t nowMs);
+};
+
+extern EspNowLink espNowLink; // 定义在espnow_radio.cpp，只在LoRa任务中访问
+
+#endif // __ESPNOW_LINK_H__
@@ -0,0 +1,48 @@
+// --- 文件名: include/espnow_radio.h ---
+// ESP-NOW的ESP-IDF封装：初始化WiFi/ESP-NOW，提供EspNowRadio收发函数
+// 接收回调运行在WiFi任务中，只把数据复制进队列并唤醒LoRa任务，
+// 邻居表和命令处理都在LoRa任务中完成(见espnow_link.h)
+// OTA会关闭WiFi，关闭之后由LoRa任务重新初始化ESP-NOW
+
+#ifndef __ESPNOW_RADIO_H__
+#define __ESPNOW_RADIO_H__
+
+#include "espnow_link.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define ESPNOW_RX_QUEUE_DEPTH 4 // 接收队列深度，满了直接丢弃
+
+struct EspNowRxFrame {
+    uint8_t mac[ESPNOW_MAC_LEN];
+    uint8_t len;
+    uint8_t data[ESPNOW_FRAME_MAX];
+};
+
+/**
+ * @brief 开启/关闭ESP-NOW，开启时WiFi进入STA模式并固定在ESPNOW_CHANNEL
+ * 只应在LoRa任务中调用
+ * @return bool 开启失败时返回false
+ */
+bool espNowSetEnabled(bool enable);
+bool espNowIsEnabled();
+
+/**
+ * @brief OTA关闭WiFi之后调用，LoRa任务下次espNowService时重新初始化
+ */
+void espNowWifiReleased();
+
+/**
+ * @brief 由LoRa任务周期调用：处理重新初始化、邻居发现和过期
+ */
+void espNowService(uint32_t nowMs);
+
+/**
+ * @brief 从接收队列取一帧，不阻塞
+ * @return bool 队列为空返回false
+ */
+bool espNowReceive(EspNowRxFrame &frame);
+
+uint32_t espNowRxOverflow(); // 接收队列满而丢弃的帧数
+
+#endif // __ESPNOW_RADIO_H__
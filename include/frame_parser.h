@@ -0,0 +1,158 @@
+// --- 文件名: include/frame_parser.h ---
+// LoRa文本协议的定长帧缓冲区与零拷贝分词器
+// 协议：RECEIVER_ID:SENDER_ID:COMMAND:PAYLOAD\n
+// 同一缓冲区也负责切分二进制帧(以BIN_FRAME_SYNC开头，以0x00结尾)，见binary_frame.h
+// 本模块不依赖Arduino，解析过程中不做任何堆内存分配
+
+#ifndef __FRAME_PARSER_H__
+#define __FRAME_PARSER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "binary_frame.h"
+
+#define FRAME_MAX_LEN 256 // 单帧最大长度(不含'\n')，超长帧整帧丢弃
+
+/**
+ * @brief 不持有内存的字符串视图，指向帧缓冲区内部
+ * 分词后每个字段都以'\0'结尾，data可以直接当作C字符串使用
+ */
+struct StrView {
+    const char *data;
+    size_t len;
+
+    bool empty() const { return len == 0; }
+    bool equals(const char *s) const {
+        return strncmp(data, s, len) == 0 && s[len] == '\0';
+    }
+    bool equals(const char *s, size_t n) const {
+        return len == n && memcmp(data, s, n) == 0;
+    }
+};
+
+// 分词结果：四个字段都指向同一个帧缓冲区
+struct FrameFields {
+    StrView receiver;
+    StrView sender;
+    StrView command;
+    StrView payload;
+};
+
+// 发送者字段可携带扩展选项：NAME{/<大写字母><十进制数>}，例如 HOST/S17
+// 不认识这些选项的旧设备会把整个字段当作发送者名，不影响命令执行
+#define SENDER_OPT_SEQ 'S'   // 序列号，见 reliable_link.h
+#define SENDER_OPT_SESSION 'E' // 上位机的会话号，序列号在会话内从1开始，见 reliable_link.h
+#define SENDER_OPT_TTL 'T'   // 剩余可转发跳数，见 relay.h
+#define SENDER_OPT_HOPS 'H'  // 已经过的转发跳数
+#define SENDER_OPT_VIA 'V'   // 最后一跳转发设备的1字节ID
+#define SENDER_OPT_AT 'A'    // 定时执行的上位机时间(us低32位)，见 scheduled_command.h
+#define SENDER_OPT_WINDOW 'W' // 流水线模式及上位机的发送窗口，见 reliable_link.h
+#define SENDER_OPT_DEADLINE 'D' // 运动命令的有效期(ms)，超时未执行则丢弃，见 motion_queue.h
+// 选项值最多10位十进制数且不超过uint32_t (/A 的时间可达4294967295)，否则整帧拒绝
+#define SENDER_OPT_MAX_DIGITS 10
+
+struct SenderOptions {
+    StrView name;     // 去掉选项后的发送者名
+    uint32_t present; // 第(key-'A')位为1表示该选项存在
+    uint32_t values[26]; // 只有present中对应位为1的项有效
+
+    bool has(char key) const { return (present >> (key - 'A')) & 1; }
+    // 不存在的选项返回0
+    uint32_t get(char key) const { return has(key) ? values[key - 'A'] : 0; }
+};
+
+enum FramePushResult {
+    FRAME_PENDING,      // 帧尚未结束
+    FRAME_READY,        // 收到'\n'，一帧完整可用
+    FRAME_READY_BINARY, // 收到0x00，一帧完整的二进制帧(COBS数据，不含同步字节)
+    FRAME_OVERFLOW,     // 帧超过FRAME_MAX_LEN，已整帧丢弃
+};
+
+/**
+ * @brief 定长帧缓冲区，按字节累积直到遇到'\n'，文本帧中的字典码字边收边展开
+ * 帧首字节为BIN_FRAME_SYNC时切换为二进制模式，改以0x00作为帧结束符
+ * 超长帧会一直丢弃到下一个结束符为止，然后报告一次FRAME_OVERFLOW
+ */
+class FrameBuffer {
+  public:
+    FrameBuffer();
+    FramePushResult push(char c);
+    void reset();
+
+    char *data() { return buf; }
+    size_t length() const { return len; }
+
+  private:
+    char buf[FRAME_MAX_LEN + 1];
+    size_t len;
+    bool overflow;
+    bool binary; // 当前帧是否为二进制帧
+};
+
+// 紧急停止标记(Command.h 中的 STOP_FAST)：帧边界('\n'或0x00)之后连续STOP_TOKEN_LEN个ESC
+// 文本帧中不会出现ESC，二进制帧只在帧中间可能出现，所以只在帧边界之后识别
+#define STOP_TOKEN_BYTE 0x1B
+#define STOP_TOKEN_LEN 3
+
+/**
+ * @brief 逐字节识别紧急停止标记，不缓存数据，可在串口接收回调中使用
+ * 标记本身之后仍会进入FrameBuffer，形成一帧只含标记的"帧"，由isStopToken识别
+ */
+class StopTokenDetector {
+  public:
+    StopTokenDetector();
+    bool push(uint8_t c); // 刚好收完一个标记时返回true
+
+  private:
+    uint8_t matched;
+    bool armed; // 上一个字节是帧边界，或正在匹配标记
+};
+
+inline bool isStopToken(const char *frame, size_t len) {
+    if (len != STOP_TOKEN_LEN) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if ((uint8_t)frame[i] != STOP_TOKEN_BYTE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 原地切分一帧为四个字段，会把分隔符改写为'\0'
+ * command和payload两端的空白字符(含'\r')会被去掉
+ * @param frame 可写的帧数据，长度为len，frame[len]必须可写
+ * @return bool 至少包含三个':'且接收者非空时返回true
+ */
+bool tokenizeFrame(char *frame, size_t len, FrameFields &out);
+
+/**
+ * @brief FNV-1a 32位哈希，用于帧去重和名字匹配，也用于编译期的命令表(perfect_hash.h)
+ */
+constexpr uint32_t fnv1aHash(const char *data, size_t len,
+                             uint32_t seed = 2166136261UL) {
+    uint32_t h = seed;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)data[i];
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+/**
+ * @brief 解析发送者字段中的扩展选项，不修改帧缓冲区
+ * @return bool 选项格式错误时返回false
+ */
+bool parseSenderOptions(const StrView &sender, SenderOptions &out);
+
+/**
+ * @brief 在视图中按分隔符取出下一个片段，并把视图推进到分隔符之后
+ * @return bool 视图已经耗尽时返回false
+ */
+bool nextToken(StrView &rest, char delimiter, StrView &token);
+
+#endif // __FRAME_PARSER_H__
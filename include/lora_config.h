@@ -0,0 +1,285 @@
+// --- 文件名: include/lora_config.h ---
+// LoRa模块寄存器镜像：类型化的模块配置(编译期生成寄存器内容并校验)、
+// 读取/修改信道功率空速、计算需要写入的差异段、估算空中时间
+// 配置模式(MD0=MD1=低)下的命令格式：
+//   写：80 <起始地址> <长度> <数据...>    模块原样回显
+// 手册没有读命令，模块当前的内容以设备上次成功写入并保存在NVS中的副本为准；
+// 更换过模块时用 FORCE_LORA_CONFIG (Pins.h) 整块写入一次
+// 本模块不依赖Arduino，需要C++17(constexpr)
+
+#ifndef __LORA_CONFIG_H__
+#define __LORA_CONFIG_H__
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LORA_CMD_WRITE 0x80
+#define LORA_CMD_HEADER_LEN 3
+#define LORA_REG_BASE 0x04  // 第一个寄存器(波特率)的地址
+#define LORA_REG_COUNT 58   // 一次配置的寄存器字节数
+#define LORA_REG_RUN_MAX 8  // 一次同步最多分几段写入
+// 两段差异之间只隔几个相同字节时合并写入，比多发一个命令头更省
+#define LORA_REG_MERGE_GAP LORA_CMD_HEADER_LEN
+
+// 寄存器偏移(相对LORA_REG_BASE)，多字节字段高字节在前
+#define LORA_REG_BAUD 0           // 串口波特率，4字节，十进制数值直接存储
+#define LORA_REG_PARITY 4         // 校验位
+#define LORA_REG_RADIO 5          // 信道<<5 | 功率<<3 | 空速，2字节
+#define LORA_REG_MODE 7           // 传输模式，2字节
+#define LORA_REG_ROLE 12          // 主从模式下的角色
+#define LORA_REG_KEY 13           // 密钥，16字节
+#define LORA_REG_KEY_LEN 16
+#define LORA_REG_WAKE_TIME 43     // 唤醒时间，100ms为单位；接收方即为休眠时间
+#define LORA_REG_LOCAL_GROUP 48   // 本地组号，FF为广播
+#define LORA_REG_LOCAL_ADDR 49    // 本地地址，FF为广播
+#define LORA_REG_TARGET_GROUP 50  // 目标组号
+#define LORA_REG_TARGET_ADDR 51   // 目标地址
+
+#define LORA_CONFIG_BAUD 9600 // 配置模式下的串口波特率，也是失败时的回退值
+
+// 定点传输：写入模块的每帧前加 目标组号+目标地址，模块只把目标与本机
+// 组号/地址相同或为广播(LORA_ADDR_BROADCAST)的帧交给串口，交出的数据不含帧头
+// 组号和地址取值见 fixedModeAddress (address_filter.h)，上位机用同样的函数生成帧头
+#define LORA_FIXED_HEADER_LEN 2
+#define LORA_ADDR_BROADCAST 0xFF
+
+#define LORA_CHANNEL_MAX 127
+#define LORA_POWER_MAX 3
+#define LORA_AIR_MAX 7
+
+// 一帧的固定开销(前导码、报头等)折算成的字节数，用于空中时间估算
+#define LORA_FRAME_OVERHEAD_BYTES 6
+
+// 信道/功率/空速，打包为 信道<<5 | 功率<<3 | 空速
+struct LoraRadioParams {
+    uint8_t channel;
+    uint8_t power;
+    uint8_t airRate;
+};
+
+struct LoraRegRun {
+    uint8_t offset; // 相对LORA_REG_BASE的偏移
+    uint8_t len;
+};
+
+typedef std::array<uint8_t, LORA_REG_COUNT> LoraRegisters;
+
+enum class LoraParity : uint8_t { None = 0x00, Even = 0x14, Odd = 0x16 };
+
+enum class LoraMode : uint16_t {
+    Transparent = 0x0001, // 透明传输，所见即所得
+    Fixed = 0x0002,       // 定点传输，帧前加 目标组号+目标地址
+    MasterSlave = 0x0004, // 主从，帧前加 组号+地址
+    Relay = 0x0021,       // 模块自带的中继
+};
+
+enum class LoraRole : uint8_t { Master = 0x00, Slave = 0x01 };
+
+// 空速等级，数值即寄存器中的3位编码
+enum class LoraAir : uint8_t {
+    Bps300,
+    Bps1200,
+    Bps2400,
+    Bps4800,
+    Bps9600,
+    Bps19200,
+    Bps38400,
+    Bps62500,
+};
+
+/**
+ * @brief 空速等级对应的空中速率(bps)，用于发送调度的空中时间估算
+ */
+constexpr uint32_t loraAirRateBps(uint8_t airRate) {
+    constexpr uint32_t table[LORA_AIR_MAX + 1] = {300,   1200,  2400,  4800,
+                                                  9600,  19200, 38400, 62500};
+    return table[airRate <= LORA_AIR_MAX ? airRate : LORA_AIR_MAX];
+}
+
+/**
+ * @brief 估算一帧的空中时间(向上取整)
+ * @param len 串口写入模块的字节数(整帧，含'\n')
+ */
+constexpr uint32_t loraAirtimeUs(uint32_t airRateBps, size_t len) {
+    return (uint32_t)(((uint64_t)(len + LORA_FRAME_OVERHEAD_BYTES) * 8 *
+                           1000000ULL +
+                       airRateBps - 1) /
+                      airRateBps);
+}
+
+constexpr bool loraBaudValid(uint32_t baud) {
+    return baud == 9600 || baud == 19200 || baud == 38400 || baud == 57600 ||
+           baud == 115200;
+}
+
+/**
+ * @brief 类型化的模块配置，用with*()链式修改，registers()生成寄存器内容
+ * 声明为constexpr后可以用static_assert在编译期拒绝非法组合，见Command.h
+ */
+struct LoraModuleConfig {
+    uint32_t uartBaud = LORA_CONFIG_BAUD;
+    LoraParity parity = LoraParity::None;
+    uint8_t channel = 0;
+    uint8_t power = LORA_POWER_MAX;
+    LoraAir air = LoraAir::Bps62500;
+    LoraMode mode = LoraMode::Transparent;
+    LoraRole role = LoraRole::Master;
+    const char *key = "www.ashining.com"; // 必须正好16个字符
+    uint8_t wakeTime100ms = 0;
+    uint8_t localGroup = 0;
+    uint8_t localAddress = 0;
+    uint8_t targetGroup = 0;
+    uint8_t targetAddress = 0;
+
+    constexpr LoraModuleConfig withUartBaud(uint32_t baud) const {
+        LoraModuleConfig c = *this;
+        c.uartBaud = baud;
+        return c;
+    }
+    constexpr LoraModuleConfig withParity(LoraParity p) const {
+        LoraModuleConfig c = *this;
+        c.parity = p;
+        return c;
+    }
+    constexpr LoraModuleConfig withChannel(uint8_t ch) const {
+        LoraModuleConfig c = *this;
+        c.channel = ch;
+        return c;
+    }
+    constexpr LoraModuleConfig withPower(uint8_t level) const {
+        LoraModuleConfig c = *this;
+        c.power = level;
+        return c;
+    }
+    constexpr LoraModuleConfig withAir(LoraAir rate) const {
+        LoraModuleConfig c = *this;
+        c.air = rate;
+        return c;
+    }
+    constexpr LoraModuleConfig withMode(LoraMode m, LoraRole r) const {
+        LoraModuleConfig c = *this;
+        c.mode = m;
+        c.role = r;
+        return c;
+    }
+    constexpr LoraModuleConfig withKey(const char *k) const {
+        LoraModuleConfig c = *this;
+        c.key = k;
+        return c;
+    }
+    constexpr LoraModuleConfig withWakeTime(uint8_t units100ms) const {
+        LoraModuleConfig c = *this;
+        c.wakeTime100ms = units100ms;
+        return c;
+    }
+    constexpr LoraModuleConfig withLocal(uint8_t group, uint8_t address) const {
+        LoraModuleConfig c = *this;
+        c.localGroup = group;
+        c.localAddress = address;
+        return c;
+    }
+    constexpr LoraModuleConfig withTarget(uint8_t group,
+                                          uint8_t address) const {
+        LoraModuleConfig c = *this;
+        c.targetGroup = group;
+        c.targetAddress = address;
+        return c;
+    }
+
+    constexpr uint32_t airRateBps() const {
+        return loraAirRateBps((uint8_t)air);
+    }
+    constexpr LoraRadioParams radio() const {
+        return LoraRadioParams{channel, power, (uint8_t)air};
+    }
+
+    // --- 合法性检查，分开写以便static_assert给出具体的错误信息 ---
+    constexpr bool keyValid() const {
+        size_t n = 0;
+        while (key[n] != '\0' && n <= LORA_REG_KEY_LEN) {
+            n++;
+        }
+        return n == LORA_REG_KEY_LEN;
+    }
+    constexpr bool radioValid() const {
+        return channel <= LORA_CHANNEL_MAX && power <= LORA_POWER_MAX &&
+               (uint8_t)air <= LORA_AIR_MAX;
+    }
+    // 透明传输：收发双方的组号、地址必须一致
+    constexpr bool addressingValid() const {
+        return mode != LoraMode::Transparent ||
+               (targetGroup == localGroup && targetAddress == localAddress);
+    }
+    // 主从模式：主机不需要目标地址，从机必须指定主机的地址(不能是广播)
+    constexpr bool roleValid() const {
+        return role == LoraRole::Master ||
+               (mode == LoraMode::MasterSlave && targetAddress != 0xFF);
+    }
+    constexpr bool valid() const {
+        return loraBaudValid(uartBaud) && keyValid() && radioValid() &&
+               addressingValid() && roleValid();
+    }
+
+    constexpr LoraRegisters registers() const {
+        // 保留字节取厂家默认值，不在配置中暴露
+        LoraRegisters r = {
+            0x00, 0x00, 0x25, 0x80, 0x00, 0x04, 0x1F, 0x00, 0x01, 0x05,
+            0x03, 0xE8, 0x00, 0x77, 0x77, 0x77, 0x2E, 0x61, 0x73, 0x68,
+            0x69, 0x6E, 0x69, 0x6E, 0x67, 0x2E, 0x63, 0x6F, 0x6D, 0x7C,
+            0x7C, 0x7C, 0x7C, 0x7C, 0x05, 0x40, 0x00, 0x23, 0x00, 0x00,
+            0x00, 0x3C, 0x3C, 0x00, 0x0A, 0x19, 0x00, 0x00, 0x00, 0x05,
+            0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00};
+        r[LORA_REG_BAUD] = (uint8_t)(uartBaud >> 24);
+        r[LORA_REG_BAUD + 1] = (uint8_t)(uartBaud >> 16);
+        r[LORA_REG_BAUD + 2] = (uint8_t)(uartBaud >> 8);
+        r[LORA_REG_BAUD + 3] = (uint8_t)uartBaud;
+        r[LORA_REG_PARITY] = (uint8_t)parity;
+        uint16_t word = (uint16_t)(channel << 5 | power << 3 | (uint8_t)air);
+        r[LORA_REG_RADIO] = (uint8_t)(word >> 8);
+        r[LORA_REG_RADIO + 1] = (uint8_t)word;
+        r[LORA_REG_MODE] = (uint8_t)((uint16_t)mode >> 8);
+        r[LORA_REG_MODE + 1] = (uint8_t)mode;
+        r[LORA_REG_ROLE] = (uint8_t)role;
+        for (size_t i = 0; i < LORA_REG_KEY_LEN; i++) {
+            r[LORA_REG_KEY + i] = (uint8_t)key[i];
+        }
+        r[LORA_REG_WAKE_TIME] = wakeTime100ms;
+        r[LORA_REG_LOCAL_GROUP] = localGroup;
+        r[LORA_REG_LOCAL_ADDR] = localAddress;
+        r[LORA_REG_TARGET_GROUP] = targetGroup;
+        r[LORA_REG_TARGET_ADDR] = targetAddress;
+        return r;
+    }
+};
+
+LoraRadioParams loraGetRadio(const uint8_t *regs);
+void loraSetRadio(uint8_t *regs, const LoraRadioParams &radio);
+uint16_t loraPackRadio(const LoraRadioParams &radio);
+LoraRadioParams loraUnpackRadio(uint16_t word);
+bool loraRadioValid(const LoraRadioParams &radio);
+
+uint32_t loraGetBaud(const uint8_t *regs);
+void loraSetBaud(uint8_t *regs, uint32_t baud);
+
+/**
+ * @brief 切换为定点传输：本地组号/地址用于模块过滤，目标字段不再使用(由帧头指定)
+ */
+void loraSetFixed(uint8_t *regs, uint8_t group, uint8_t address);
+bool loraIsFixed(const uint8_t *regs);
+
+/**
+ * @brief 定点传输的帧头，写在每帧数据之前
+ * @return size_t LORA_FIXED_HEADER_LEN
+ */
+size_t loraFixedHeader(uint8_t group, uint8_t address, uint8_t *out);
+
+/**
+ * @brief 比较当前与目标寄存器，输出需要写入的连续段
+ * 段数超过maxRuns时，最后一段延伸到末尾
+ * @return size_t 段数，0表示无需写入
+ */
+size_t loraRegDiff(const uint8_t *current, const uint8_t *desired,
+                   LoraRegRun *runs, size_t maxRuns);
+
+#endif // __LORA_CONFIG_H__
@@ -0,0 +1,26 @@
+// --- 文件名: include/motion_params.h ---
+// 运动参数的完整快照：Motion按整组读取和提交，参数注册表的读写函数都作用在快照上
+// SET_BATCH_PARAMS 先把一批参数写进快照的副本，全部通过检查后一次提交给Motion，
+// 硬件(调压PWM、MCPWM)只在提交时重新设置一次，见 Motion::applyParams
+// 本模块不依赖Arduino
+
+#ifndef __MOTION_PARAMS_H__
+#define __MOTION_PARAMS_H__
+
+#include <stdint.h>
+
+struct MotionParams {
+    int voltage;
+    float dutyCycle;
+    uint32_t forwardFreq;
+    float forwardPhase;
+    uint32_t backwardFreq;
+    float backwardPhase;
+    float stepTimeMs;
+    float stillTimeMs;
+    // 以下两项只读，由 STEP_MODE / SWAP_DIR 命令修改，applyParams忽略
+    bool stepMode;
+    bool directionReversed;
+};
+
+#endif // __MOTION_PARAMS_H__
@@ -0,0 +1,74 @@
+// --- 文件名: include/motion_queue.h ---
+// 运动命令队列：M_F / M_B / STOP 不在LoRa任务中直接执行，
+// 而是解析成定长的MotionCommand放入队列，由优先级更高的运动任务依次执行
+// 运动任务打印日志、等待串口时，LoRa任务可以继续收帧和处理其他命令
+//
+// 每条命令带收到的时刻和截止时刻：运动任务取出时已过截止时刻的前进/后退命令直接丢弃，
+// 避免LoRa任务忙或串口拥塞时积压的旧命令在很久以后才动作
+// 截止时刻 = 收到时刻 + 有效期，有效期取发送者选项 /D<ms>，没有时为 MOTION_CMD_MAX_AGE_MS
+// STOP 从不过期，入队前先清空尚未执行的命令，所以不会排在旧命令后面
+// 每次清空换一个纪元号，命令带着入队时的纪元号，
+// 运动任务已取出还没执行的命令在清空之后也不再执行
+// 正在执行的命令由 Motion::stopEpoch() 保证不会撤销停止
+//
+// 参数、步进模式、方向切换等需要按结果回复的命令仍在LoRa任务中执行
+// 运动任务优先级高于LoRa任务且在同一个核上，入队后立即开始执行，与后续命令的先后顺序不变
+
+#ifndef __MOTION_QUEUE_H__
+#define __MOTION_QUEUE_H__
+
+#include "freertos/FreeRTOS.h"
+#include <stdint.h>
+
+#define MOTION_QUEUE_DEPTH 8 // 队列满时新的命令被拒绝，计入overflow
+
+enum MotionOp : uint8_t {
+    MOTION_OP_FORWARD,
+    MOTION_OP_BACKWARD,
+    MOTION_OP_STOP,
+};
+
+struct MotionCommand {
+    MotionOp op;
+    int64_t rxUs;       // 收到命令的时刻(esp_timer_get_time)
+    int64_t deadlineUs; // 过了这个时刻还未执行则丢弃，0表示不过期
+    uint32_t epoch;     // 入队时的纪元号，之后清空过队列则丢弃
+};
+
+struct MotionQueueStats {
+    uint32_t executed;      // 执行的命令数
+    uint32_t stale;         // 过了截止时刻而丢弃的命令数
+    uint32_t flushed;       // 被STOP清掉的命令数(含已取出未执行的)
+    uint32_t overflow;      // 队列满而拒绝的命令数
+    uint32_t lastLatencyUs; // 从收到到开始执行的时间
+    uint32_t maxLatencyUs;
+};
+
+/**
+ * @brief 创建队列，应在创建运动任务之前调用
+ */
+void motionQueueInit();
+
+/**
+ * @brief 把一条运动命令放入队列，不阻塞；STOP先清空队列
+ * @param rxUs 收到命令的时刻
+ * @param maxAgeMs 有效期，0表示使用 MOTION_CMD_MAX_AGE_MS
+ * @return bool 队列满时返回false
+ */
+bool motionQueuePush(MotionOp op, int64_t rxUs, uint32_t maxAgeMs);
+
+/**
+ * @brief 丢弃尚未执行的命令，包括运动任务已取出的那一条，可在任意任务中调用
+ */
+void motionQueueFlush();
+
+/**
+ * @brief 运动任务主体：取出一条命令，过期则丢弃，否则执行
+ * @param timeout 等待新命令的最长时间
+ * @return bool 是否取到了命令
+ */
+bool motionQueueServe(TickType_t timeout);
+
+MotionQueueStats motionQueueStats();
+
+#endif // __MOTION_QUEUE_H__
@@ -0,0 +1,116 @@
+// --- 文件名: include/param_registry.h ---
+// 参数注册表：每个运动参数的名称、ID、类型、范围、单位和读写函数集中在一张表里
+// SET_BATCH_PARAMS 的解析和设置、GET_PARAM、REPORT_ALL_PARAMS 的上报、
+// PARAM_SCHEMA 的参数说明都由这张表生成，新增参数只需在 param_registry.cpp 中加一行
+//
+// 按名字查找用编译期完美哈希(perfect_hash.h)，按ID查找用编译期生成的下标表，都是O(1)
+// 参数ID与二进制帧的 BinaryParamId 一致；上报顺序即表中顺序，只能在末尾追加
+// 上位机用 PARAM_SCHEMA 下载一次参数说明，按其中的哈希值缓存，不必在上位机写死范围
+//
+// 读写函数都作用在参数快照(motion_params.h)上，不直接操作硬件：
+// SET_BATCH_PARAMS 先把整批参数暂存进快照副本(ParamBatch)，全部通过检查后
+// 才由调用方一次提交给 Motion::applyParams，任一条失败则整批不生效
+// 本模块不依赖Arduino
+
+#ifndef __PARAM_REGISTRY_H__
+#define __PARAM_REGISTRY_H__
+
+#include "motion_params.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define PARAM_ID_LIMIT 32         // 参数ID上限(不含)，按ID查找的下标表大小
+#define PARAM_VALUE_MAX_LEN 24    // 单个参数值的最大字符数
+#define PARAM_REPORT_MAX 180      // REPORT_ALL_PARAMS 负载的最大长度
+#define PARAM_SCHEMA_PAGE_MAX 180 // PARAM_SCHEMA 每页负载的最大长度
+#define PARAM_BATCH_MAX 16        // 一批最多的参数个数，ACK中每个参数一个结果码
+
+enum ParamType : uint8_t {
+    PARAM_INT,   // 整数，文本为十进制
+    PARAM_FLOAT, // 浮点，上报保留两位小数
+    PARAM_BOOL,  // 0或1
+};
+
+// 每个参数的处理结果，在 SET_BATCH_PARAMS 的ACK中按出现顺序各占一个字符
+enum ParamResult : char {
+    PARAM_OK = '0',
+    PARAM_ERR_UNKNOWN = 'U',   // 没有这个参数名
+    PARAM_ERR_FORMAT = 'F',    // 缺少':'或数值格式错误
+    PARAM_ERR_RANGE = 'R',     // 超出范围
+    PARAM_ERR_READONLY = 'W',  // 只读参数
+    PARAM_ERR_DUPLICATE = 'D', // 同一批中重复出现
+    PARAM_ERR_TOO_MANY = 'X',  // 超过PARAM_BATCH_MAX，之后的条目不再处理
+};
+
+struct ParamDescriptor {
+    const char *name; // 文本协议中的参数名
+    uint8_t id;       // 参数ID，与 BinaryParamId 一致
+    ParamType type;
+    float min; // 闭区间，PARAM_BOOL为0~1
+    float max;
+    const char *units;
+    void (*set)(MotionParams &params, float value); // NULL表示只读
+    float (*get)(const MotionParams &params);
+};
+
+// 一批参数的暂存区
+struct ParamBatch {
+    MotionParams shadow; // 当前参数的副本，暂存本批的新值
+    uint32_t staged;     // 本批已出现的参数ID位图
+    uint8_t count;
+    bool valid;                        // 所有条目都通过了检查
+    char results[PARAM_BATCH_MAX + 2]; // 每个条目的ParamResult，以'\0'结尾
+};
+
+size_t paramCount();
+const ParamDescriptor *paramAt(size_t index); // 按上报顺序，越界返回NULL
+
+/**
+ * @brief 按名字查找参数，名字不必以'\0'结尾
+ * @return const ParamDescriptor* 找不到时返回NULL
+ */
+const ParamDescriptor *paramFind(const char *name, size_t len);
+const ParamDescriptor *paramFindById(uint8_t id);
+
+/**
+ * @brief 按参数类型解析文本值并检查范围，不写入参数
+ * @return ParamResult PARAM_OK、PARAM_ERR_FORMAT或PARAM_ERR_RANGE
+ */
+ParamResult paramParse(const ParamDescriptor &param, const char *text,
+                       size_t len, float &value);
+
+/**
+ * @brief 以当前参数为基础开始一批
+ */
+void paramBatchBegin(ParamBatch &batch, const MotionParams &current);
+
+/**
+ * @brief 解析一个 NAME:VALUE 并写入暂存区，结果码追加到batch.results
+ * 失败的条目不写入，同时batch.valid置为false
+ */
+ParamResult paramBatchStage(ParamBatch &batch, const char *pair, size_t len);
+
+/**
+ * @brief 按参数类型格式化一个值(不含名字)
+ * @return size_t 写入的字节数(不含'\0')，空间不足时返回0
+ */
+size_t paramFormatValue(const ParamDescriptor &param, float value, char *out,
+                        size_t cap);
+
+/**
+ * @brief 生成全部参数的值 NAME:VALUE;NAME:VALUE...，即 REPORT_ALL_PARAMS 的负载
+ * @return size_t 写入的字节数(不含'\0')，空间不足时返回0
+ */
+size_t paramFormatAll(const MotionParams &params, char *out, size_t cap);
+
+/**
+ * @brief 生成一页参数说明：<first>,<总数>,<哈希>;NAME,ID,TYPE,MIN,MAX,UNITS,RW;...
+ * TYPE为I/F/B，RW为W(可写)或R(只读)，哈希为8位十六进制，参数表变化时随之变化
+ * 一页放不下时截断，上位机从 first+本页条数 继续请求
+ * @return size_t 写入的字节数(不含'\0')，空间不足时返回0
+ */
+size_t paramFormatSchema(size_t first, char *out, size_t cap);
+
+uint32_t paramSchemaHash();
+
+#endif // __PARAM_REGISTRY_H__
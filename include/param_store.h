@@ -0,0 +1,76 @@
+// --- 文件名: include/param_store.h ---
+// 带版本号的参数存储：记录每个参数最后一次变化时的版本号，上位机只取变化的部分
+//
+// 版本号从1开始，参数每变化一次(一次提交改动的所有参数算一次)加一
+// 纪元号(epoch)每次上电随机生成，上位机据此发现设备重启过、之前的版本号已失效
+//
+// 上位机轮询 PARAM_DELTA:<纪元>,<版本> 时只回复该版本之后变化的参数，
+// 没有变化时只有 <纪元>,<版本> 十几个字节，而 REPORT_ALL_PARAMS 约170字节
+// 纪元不符、版本比设备新或payload为空时回复全部参数
+// 参数变化后设备主动发出的 PARAM_DELTA 通知只含脏位(上次通知后变化)对应的参数；
+// 组播回复时隙内的通知只有 <纪元>,<版本>，上位机再单播PARAM_DELTA取值
+//
+// 参数的比较和格式化都经过参数注册表(param_registry.h)，新增参数不需要修改本模块
+// 本模块不依赖Arduino
+
+#ifndef __PARAM_STORE_H__
+#define __PARAM_STORE_H__
+
+#include "motion_params.h"
+#include "param_registry.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// PARAM_DELTA 负载的最大长度：<纪元>,<版本> 头部加全部参数
+#define PARAM_DELTA_MAX (PARAM_REPORT_MAX + 16)
+#define PARAM_NOTICE_HEADER_MAX 15 // <纪元>,<版本>：4位十六进制,至多10位十进制
+
+class ParamStore {
+  public:
+    ParamStore();
+
+    /**
+     * @brief 以当前参数建立版本1，清空脏位
+     * @param epoch 本次上电的纪元号，不应为0
+     */
+    void begin(const MotionParams &initial, uint16_t epoch);
+
+    /**
+     * @brief 与上次记录的参数比较，有变化时版本号加一并标记脏位
+     * @return bool 有参数变化时返回true
+     */
+    bool update(const MotionParams &now);
+
+    uint16_t epoch() const { return epochId; }
+    uint32_t version() const { return ver; }
+    uint32_t dirtyMask() const { return dirty; } // 按参数ID的位图
+
+    /**
+     * @brief 生成 <纪元>,<版本>;NAME:VALUE;... ，只含since之后变化的参数
+     * 纪元不符或since比当前版本新时含全部参数
+     * @return size_t 写入的字节数(不含'\0')，空间不足时返回0
+     */
+    size_t formatSince(uint16_t epoch, uint32_t since, char *out,
+                       size_t cap) const;
+
+    /**
+     * @brief 生成变化通知，只含脏位对应的参数，成功后清空脏位
+     * @param withValues 为false时只有 <纪元>,<版本>，长度不超过
+     * PARAM_NOTICE_HEADER_MAX，用于放进组播回复时隙
+     * @return size_t 写入的字节数(不含'\0')，没有脏位或空间不足时返回0
+     */
+    size_t takeDirty(char *out, size_t cap, bool withValues = true);
+
+  private:
+    MotionParams current;
+    uint16_t epochId;
+    uint32_t ver;
+    uint32_t dirty;
+    uint32_t fieldVersion[PARAM_ID_LIMIT]; // 按参数ID，最后一次变化时的版本号
+
+    size_t format(uint32_t mask, char *out, size_t cap) const;
+};
+
+extern ParamStore paramStore; // 定义在tasks.cpp，只在LoRa任务中访问
+
+#endif // __PARAM_STORE_H__
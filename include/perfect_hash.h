@@ -0,0 +1,176 @@
+// --- 文件名: include/perfect_hash.h ---
+// 编译期完美哈希：对一组固定的字符串键(命令字)在编译期生成无冲突的槽位表，
+// 运行时查找 = 一次FNV-1a哈希 + 查一次位移表 + 一次strcmp确认
+//
+// 做法为"哈希加位移"：哈希的高位选桶，另一组位(乘法散列)给出初始槽位，
+// 每个桶有一个位移量，桶内所有键的槽位 = (初始槽位 + 位移) & (槽位数-1)
+// 编译期从键最多的桶开始，为每个桶找一个让桶内键都落在空槽的位移；
+// 某个桶找不到时换一个FNV种子重来。槽位数取不小于2N的2的幂，桶数为槽位数/4
+// 键重复或找不到可用种子时，调用方用static_assert在编译期报错，见command_processor.cpp
+// 本模块不依赖Arduino，需要C++17(constexpr)
+
+#ifndef __PERFECT_HASH_H__
+#define __PERFECT_HASH_H__
+
+#include "frame_parser.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PERFECT_HASH_SEED_TRIES 64 // 编译期最多尝试的FNV种子个数
+#define PERFECT_HASH_MIX 0x9E3779B1UL // 由哈希值导出初始槽位的乘数(黄金分割)
+
+constexpr size_t perfectHashSlots(size_t n) {
+    size_t slots = 1;
+    while (slots < 2 * n) {
+        slots <<= 1;
+    }
+    return slots;
+}
+
+constexpr unsigned perfectHashBits(size_t count) {
+    unsigned bits = 0;
+    while (((size_t)1 << bits) < count) {
+        bits++;
+    }
+    return bits;
+}
+
+constexpr size_t constStrLen(const char *s) {
+    size_t n = 0;
+    while (s[n] != '\0') {
+        n++;
+    }
+    return n;
+}
+
+constexpr bool constStrEqual(const char *a, const char *b) {
+    size_t i = 0;
+    while (a[i] != '\0' && a[i] == b[i]) {
+        i++;
+    }
+    return a[i] == b[i];
+}
+
+template <size_t N> struct PerfectHash {
+    static_assert(N > 0 && N < 255, "PerfectHash supports 1..254 keys");
+    static constexpr size_t SLOTS = perfectHashSlots(N);
+    static constexpr unsigned SLOT_BITS = perfectHashBits(SLOTS);
+    static constexpr size_t BUCKETS = SLOTS >= 4 ? SLOTS / 4 : 1;
+    static constexpr unsigned BUCKET_BITS = perfectHashBits(BUCKETS);
+
+    uint32_t seed = 0;
+    bool unique = true; // 没有重复的键
+    bool found = false; // 找到了无冲突的槽位表
+    uint16_t displace[BUCKETS] = {};
+    uint8_t slots[SLOTS] = {}; // 键的序号+1，0表示空槽
+
+    static constexpr size_t bucketOf(uint32_t h) {
+        return BUCKET_BITS == 0 ? 0 : h >> (32 - BUCKET_BITS);
+    }
+    // FNV-1a的低位只由输入的低位决定，先乘法散列再取高位
+    static constexpr size_t baseOf(uint32_t h) {
+        return (uint32_t)(h * PERFECT_HASH_MIX) >> (32 - SLOT_BITS);
+    }
+    constexpr size_t slotOf(uint32_t h) const {
+        return (baseOf(h) + displace[bucketOf(h)]) & (SLOTS - 1);
+    }
+
+    /**
+     * @brief 按哈希找到候选键的序号，调用方再用strcmp确认
+     * @return size_t 槽位为空时返回N
+     */
+    size_t candidate(const char *key, size_t len) const {
+        uint8_t slot = slots[slotOf(fnv1aHash(key, len, seed))];
+        return slot == 0 ? N : (size_t)(slot - 1);
+    }
+    size_t candidate(const char *key) const {
+        return candidate(key, strlen(key));
+    }
+};
+
+/**
+ * @brief 为一个桶找位移量并占用槽位
+ * @return bool 所有位移都有冲突时返回false，槽位表不变
+ */
+template <size_t N>
+constexpr bool perfectHashPlace(PerfectHash<N> &table, const uint32_t *hashes,
+                                size_t bucket) {
+    for (size_t d = 0; d < PerfectHash<N>::SLOTS; d++) {
+        table.displace[bucket] = (uint16_t)d;
+        bool fits = true;
+        size_t placed = 0;
+        for (; placed < N && fits; placed++) {
+            if (PerfectHash<N>::bucketOf(hashes[placed]) != bucket) {
+                continue;
+            }
+            size_t slot = table.slotOf(hashes[placed]);
+            if (table.slots[slot] != 0) {
+                fits = false;
+                break;
+            }
+            table.slots[slot] = (uint8_t)(placed + 1);
+        }
+        if (fits) {
+            return true;
+        }
+        // 撤销本次已占用的槽位，换下一个位移
+        for (size_t i = 0; i < placed; i++) {
+            if (PerfectHash<N>::bucketOf(hashes[i]) == bucket) {
+                table.slots[table.slotOf(hashes[i])] = 0;
+            }
+        }
+    }
+    table.displace[bucket] = 0;
+    return false;
+}
+
+/**
+ * @brief 对entries[i].*name生成完美哈希，只应在constexpr上下文中调用
+ */
+template <typename Entry, size_t N>
+constexpr PerfectHash<N> buildPerfectHash(const Entry (&entries)[N],
+                                          const char *const Entry::*name) {
+    PerfectHash<N> table;
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = i + 1; j < N; j++) {
+            if (constStrEqual(entries[i].*name, entries[j].*name)) {
+                table.unique = false;
+                return table;
+            }
+        }
+    }
+    uint32_t hashes[N] = {};
+    size_t sizes[PerfectHash<N>::BUCKETS] = {};
+    for (uint32_t t = 0; t < PERFECT_HASH_SEED_TRIES; t++) {
+        table.seed = 2166136261UL + t;
+        for (size_t b = 0; b < PerfectHash<N>::BUCKETS; b++) {
+            sizes[b] = 0;
+            table.displace[b] = 0;
+        }
+        for (size_t s = 0; s < PerfectHash<N>::SLOTS; s++) {
+            table.slots[s] = 0;
+        }
+        for (size_t i = 0; i < N; i++) {
+            const char *key = entries[i].*name;
+            hashes[i] = fnv1aHash(key, constStrLen(key), table.seed);
+            sizes[PerfectHash<N>::bucketOf(hashes[i])]++;
+        }
+        // 键多的桶先放，空槽多时更容易找到位移
+        bool ok = true;
+        for (size_t size = N; size > 0 && ok; size--) {
+            for (size_t b = 0; b < PerfectHash<N>::BUCKETS && ok; b++) {
+                if (sizes[b] == size) {
+                    ok = perfectHashPlace(table, hashes, b);
+                }
+            }
+        }
+        if (ok) {
+            table.found = true;
+            return table;
+        }
+    }
+    return table;
+}
+
+#endif // __PERFECT_HASH_H__
@@ -0,0 +1,101 @@
+// --- 文件名: include/relay.h ---
+// 多跳转发：超出上位机直连距离的模块由邻居代为转发
+//
+// 发送者字段的选项 (见 frame_parser.h)：
+//   /T<n> 剩余可转发跳数，没有该选项的帧永远不会被转发 (旧格式不受影响)
+//   /H<n> 已经过的转发跳数
+//   /V<n> 最后一跳转发设备的1字节ID (binaryIdFromName)
+// 例：SR_09:HOST/E7/S5/T2:M_F:  经SR_03转发后变为  SR_09:HOST/E7/S5/T1/H1/V3:M_F:
+// 转发时只改写/T、/H、/V，其他选项(/A、/W、/D等)原样保留
+// 设备回复时会带上 /T<请求经过的跳数>，使回复能沿原路返回
+// 本模块不依赖Arduino，时间由调用者传入(毫秒)
+
+#ifndef __RELAY_H__
+#define __RELAY_H__
+
+#include "frame_parser.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define RELAY_ROUTE_MAX 16        // 路由/邻居缓存条目数
+#define RELAY_ROUTE_EXPIRE_MS 120000 // 超过该时间未再听到则视为失效
+#define RELAY_SEEN_MAX 16         // 最近见过的帧指纹个数，用于抑制重复转发
+// 同一帧经不同中继到达的时间差很小；窗口之外的相同帧视为上位机重传，照常处理
+#define RELAY_SEEN_WINDOW_MS 300
+
+struct RelayRoute {
+    uint8_t id;         // 目标设备1字节ID
+    uint8_t via;        // 下一跳设备ID，等于id时表示直连邻居
+    uint8_t hops;       // 到达目标的跳数
+    uint32_t heardMs;   // 最后一次听到的时间
+};
+
+struct RelayStats {
+    uint32_t forwarded;  // 已转发的帧数
+    uint32_t duplicates; // 因为已见过而未转发/未执行的帧数
+    uint32_t outOfRange; // 路由表显示剩余跳数不够而未转发的帧数
+};
+
+class RelayRouter {
+  public:
+    RelayRouter();
+
+    void setEnabled(bool enable) { enabled = enable; }
+    bool isEnabled() const { return enabled; }
+    // 转发时把下游发给上位机的ACK汇总后再发，见 reply_slot.h
+    void setAggregate(bool enable) { aggregate = enable; }
+    bool isAggregating() const { return enabled && aggregate; }
+
+    /**
+     * @brief 从任意一帧(包括不是发给我的)学习邻居和路由
+     */
+    void learn(const SenderOptions &sender, uint32_t nowMs);
+
+    /**
+     * @brief 帧指纹：接收者、发送者名、序列号、命令和负载，不含转发选项
+     */
+    static uint32_t frameKey(const FrameFields &fields,
+                             const SenderOptions &sender);
+
+    /**
+     * @brief 检查并登记帧指纹
+     * @return bool RELAY_SEEN_WINDOW_MS内已经见过同一帧时返回true
+     */
+    bool seenBefore(uint32_t key, uint32_t nowMs);
+
+    /**
+     * @brief 是否应当转发一帧不是发给我的消息 (调用前应已用seenBefore去重)
+     * @param selfId 本机1字节ID，最后一跳是自己的帧不再转发
+     * @param multicast 组播/广播帧没有单一目标，不查路由表
+     */
+    bool shouldForward(const FrameFields &fields, const SenderOptions &sender,
+                       uint8_t selfId, bool multicast, uint32_t nowMs);
+
+    /**
+     * @brief 生成转发帧：TTL减一、跳数加一、记录本机为最后一跳
+     * 其他选项原样保留；fields.sender须已由parseSenderOptions检查过
+     * @return size_t 写入的字节数(含'\n')，空间不足返回0
+     */
+    static size_t formatForward(const FrameFields &fields,
+                                const SenderOptions &sender, uint8_t selfId,
+                                char *out, size_t cap);
+
+    const RelayRoute *findRoute(uint8_t id, uint32_t nowMs) const;
+    RelayStats getStats() const { return stats; }
+
+  private:
+    void update(uint8_t id, uint8_t via, uint8_t hops, uint32_t nowMs);
+
+    bool enabled;
+    bool aggregate;
+    RelayRoute routes[RELAY_ROUTE_MAX];
+    uint8_t routeCount;
+    uint32_t seen[RELAY_SEEN_MAX];
+    uint32_t seenMs[RELAY_SEEN_MAX];
+    uint8_t seenNext;
+    RelayStats stats;
+};
+
+extern RelayRouter relayRouter; // 定义在tasks.cpp，只在LoRa任务中访问
+
+#endif // __RELAY_H__
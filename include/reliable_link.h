@@ -0,0 +1,221 @@
+// --- 文件名: include/reliable_link.h ---
+// 带序列号的可靠投递：设备端按发送者去重，回复累计ACK；上位机端按RTT自适应重传
+//
+// 发送方在发送者字段附加会话号和序列号：SR_01:HOST/E4821/S17:SWAP_DIR:
+//   - 会话号(/E)：上位机每次启动随机选取的非0数，序列号在每个会话内从1开始
+//   - 设备对每个带序列号的帧(包括重复帧)都回复一次累计ACK：
+//     HOST:SR_01:ACK:SEQ,<累计序号>,<位图>
+//     累计序号：该发送者连续收到的最大序号，之前的全部已执行
+//     位图：十六进制，第i位表示 累计序号+1+i 已乱序收到
+// 重复帧不会被再次执行，所以重传 SWAP_DIR 之类的命令是幂等的
+//
+// 会话同步：设备不知道该会话此前收到过什么(新会话、设备重启、发送者被淘汰)时，
+// 只接受序号1作为会话的开始，其余序号不执行，回复
+//   HOST:SR_01:ACK:SEQ_RESYNC,<会话号>
+// 上位机收到后若本会话的序号1已被确认，说明设备丢失了会话状态，应换一个新会话号
+// 从序号1起重发尚未确认的命令；序号1尚未确认时照常重传即可
+// 不带/E的带序号帧一律按会话0处理，同样遵守上述规则，所以设备绝不会ACK没有执行过的序号
+//
+// 流水线模式：发送者字段再加 /W<n>(n为上位机的发送窗口)，例如 SR_01:HOST/E4821/S18/W8:M_P_F:...
+// 上位机不必等ACK就可以连续发送n条命令：
+//   - 设备严格按序号顺序执行，乱序到达的命令先缓存，空缺补齐后再依次执行
+//   - 处理函数不再单独回复ACK，累计ACK多带一个状态位图：
+//     HOST:SR_01:ACK:SEQ,<累计序号>,<位图>,<失败位图>
+//     失败位图第i位为1表示 累计序号-i 这条命令执行失败(未知命令、参数无效等)
+//   - 累计ACK在最后一帧之后静默LINK_PIPE_ACK_DELAY_MS才发出，新帧到达会把它推迟；
+//     未确认的命令数达到n时立即发出，上位机的窗口不会空等
+// 这样吞吐量只受空中时间限制，而不是每条命令一个往返
+// 本模块不依赖Arduino，上位机可直接编译使用
+
+#ifndef __RELIABLE_LINK_H__
+#define __RELIABLE_LINK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LINK_MAX_PEERS 4        // 设备端同时跟踪的发送者个数，超出时淘汰最久未通信的
+#define LINK_PEER_NAME_MAX 15   // 发送者名的最大长度
+#define LINK_WINDOW_BITS 32     // 乱序接收窗口
+#define LINK_ACK_MAX_LEN 64     // 累计ACK帧的最大长度
+#define LINK_PIPE_BUFFER_MAX 8  // 流水线模式下缓存的乱序命令数
+#define LINK_PIPE_COMMAND_MAX 24 // 缓存命令字的最大长度
+#define LINK_PIPE_ARGS_MAX 256   // 缓存参数的最大长度，与FRAME_MAX_LEN一致
+#define LINK_PIPE_ACK_DELAY_MS 30 // 流水线累计ACK的静默等待时间
+
+enum SeqResult {
+    SEQ_NEW,       // 新帧，应当执行
+    SEQ_DUPLICATE, // 已执行过的重传帧，只回ACK
+    SEQ_TOO_NEW,   // 超出接收窗口，丢弃等待重传
+    SEQ_RESYNC,    // 会话未知且不是序号1，不执行，回复SEQ_RESYNC
+};
+
+/**
+ * @brief 设备端：按发送者维护累计序号和乱序位图
+ */
+class SeqTracker {
+  public:
+    SeqTracker();
+
+    /**
+     * @brief 判断并登记一个收到的序号
+     * @param name 发送者名(不含选项)
+     * @param session 发送者的会话号(/E)，没有时为0
+     */
+    SeqResult accept(const char *name, size_t nameLen, uint32_t session,
+                     uint32_t seq);
+
+    /**
+     * @brief 该发送者当前是否处于这个会话
+     */
+    bool inSession(const char *name, size_t nameLen, uint32_t session);
+
+    /**
+     * @brief 查询该发送者当前的累计序号
+     * @return bool 发送者未知时返回false
+     */
+    bool cumulativeOf(const char *name, size_t nameLen,
+                      uint32_t &cumulative);
+
+    /**
+     * @brief 流水线模式：按执行顺序登记每条命令的结果，用于失败位图
+     */
+    void recordResult(const char *name, size_t nameLen, bool ok);
+
+    /**
+     * @brief 上一次立即发出ACK之后又确认了多少条命令
+     */
+    uint32_t unacked(const char *name, size_t nameLen);
+    void markAcked(const char *name, size_t nameLen); // ACK立即发出时调用
+
+    /**
+     * @brief 生成发给该发送者的累计ACK帧
+     * @param withStatus 流水线模式，附带失败位图
+     * @return size_t 写入的字节数，发送者未知时返回0
+     */
+    size_t formatAck(const char *name, size_t nameLen, const char *selfID,
+                     char *out, size_t cap, bool withStatus = false);
+
+    /**
+     * @brief 生成会话同步请求 ACK:SEQ_RESYNC,<会话号>
+     * @return size_t 写入的字节数，空间不足返回0
+     */
+    static size_t formatResync(const char *name, size_t nameLen,
+                               const char *selfID, uint32_t session, char *out,
+                               size_t cap);
+
+  private:
+    struct Peer {
+        char name[LINK_PEER_NAME_MAX + 1];
+        uint8_t nameLen;
+        bool used;
+        uint32_t session;    // 当前会话号
+        uint32_t cumulative; // 已连续收到的最大序号
+        uint32_t mask;       // cumulative+1 起的乱序接收位图
+        uint32_t failed;     // 流水线模式：第i位为cumulative-i的执行结果
+        uint32_t acked;      // 上一次立即发出的ACK中的累计序号
+        uint32_t lastUsed;   // LRU计数
+    };
+
+    Peer *find(const char *name, size_t nameLen);
+    Peer *claim(const char *name, size_t nameLen);
+
+    Peer peers[LINK_MAX_PEERS];
+    uint32_t useCounter;
+};
+
+// 缓存命令的执行条件，随命令一起保存，取出时按收到这条命令时的条件执行
+struct PipelineTiming {
+    bool hasAt;        // 带/A定时选项
+    uint32_t atUs;     // /A的上位机时间
+    int64_t rxUs;      // 收到这条命令的时刻，运动命令的有效期从这里算起
+    uint32_t maxAgeMs; // /D选项，0表示默认有效期
+};
+
+/**
+ * @brief 设备端：流水线模式下缓存乱序到达的命令，等空缺补齐后按序取出
+ */
+class PipelineBuffer {
+  public:
+    PipelineBuffer();
+
+    bool full() const;
+
+    /**
+     * @brief 缓存一条命令，命令与参数会被拷贝
+     * @return bool 缓存已满或命令过长时返回false
+     */
+    bool store(const char *name, size_t nameLen, uint32_t seq,
+               const char *command, const char *args,
+               const PipelineTiming &timing);
+
+    /**
+     * @brief 取出一条缓存的命令并释放其位置
+     * 返回的指针在下一次store之前有效
+     * @return bool 没有该序号的命令时返回false
+     */
+    bool take(const char *name, size_t nameLen, uint32_t seq,
+              const char *&command, const char *&args,
+              PipelineTiming &timing);
+
+    /**
+     * @brief 丢弃该发送者缓存的全部命令，发送者换了会话时调用
+     */
+    void drop(const char *name, size_t nameLen);
+
+  private:
+    struct Entry {
+        bool used;
+        uint32_t seq;
+        char name[LINK_PEER_NAME_MAX + 1];
+        uint8_t nameLen;
+        PipelineTiming timing;
+        char command[LINK_PIPE_COMMAND_MAX + 1];
+        char args[LINK_PIPE_ARGS_MAX + 1];
+    };
+
+    Entry entries[LINK_PIPE_BUFFER_MAX];
+};
+
+/**
+ * @brief 上位机端：RFC 6298 风格的RTT估计与重传超时计算
+ * 只用未重传过的命令的往返时间更新估计 (Karn算法)
+ */
+class RttEstimator {
+  public:
+    RttEstimator(uint32_t initialRtoMs = 1000, uint32_t minRtoMs = 200,
+                 uint32_t maxRtoMs = 8000);
+
+    void sample(uint32_t rttMs); // 收到未重传命令的ACK时调用
+    void backoff();              // 重传超时时调用，RTO翻倍
+    uint32_t rto() const { return rtoMs; }
+    uint32_t srtt() const { return srttMs; }
+
+  private:
+    bool hasSample;
+    uint32_t srttMs;
+    uint32_t rttvarMs;
+    uint32_t rtoMs;
+    uint32_t minRto;
+    uint32_t maxRto;
+};
+
+/**
+ * @brief 上位机端：解析设备回复的累计ACK负载 "SEQ,<累计序号>,<位图>[,<失败位图>]"
+ * @param failed 非NULL时输出失败位图，非流水线模式的ACK没有该字段，输出0
+ * @return bool 负载格式正确时返回true
+ */
+bool parseCumulativeAck(const char *payload, uint32_t &cumulative,
+                        uint32_t &mask, uint32_t *failed = NULL);
+
+/**
+ * @brief 上位机端：解析会话同步请求 "SEQ_RESYNC,<会话号>"
+ * @return bool 负载格式正确时返回true
+ */
+bool parseSeqResync(const char *payload, uint32_t &session);
+
+/**
+ * @brief 上位机端：判断某个序号是否已被ACK确认
+ */
+bool seqAcknowledged(uint32_t seq, uint32_t cumulative, uint32_t mask);
+
+#endif // __RELIABLE_LINK_H__
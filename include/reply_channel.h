@@ -0,0 +1,36 @@
+// --- 文件名: include/reply_channel.h ---
+// 回复路由：命令从哪个通道收到，处理函数的回复就从哪个通道发回
+//   LoRa      经发送队列、调度器和空中时间预算发出(默认)
+//   USB串口    台架上的上位机直接连Serial(USB_SERIAL_BAUD)，立即写出，与调试输出按行交错
+//   ESP-NOW   发回给邻居或台架适配器，见 espnow_link.h
+// 回复的去向由收到请求的一方放进ReplyContext，随命令一路传给处理函数，不保存在全局变量中
+
+#ifndef __REPLY_CHANNEL_H__
+#define __REPLY_CHANNEL_H__
+
+#include "LORA.h"
+#include <Arduino.h>
+
+enum ReplyChannel {
+    REPLY_VIA_LORA,
+    REPLY_VIA_USB,
+    REPLY_VIA_ESPNOW,
+};
+
+// 一条请求的回复发往哪里、如何发出
+struct ReplyContext {
+    ReplyChannel channel = REPLY_VIA_LORA;
+    LoraTxRoute route; // 转发跳数与时隙，只对LoRa通道有效
+};
+
+/**
+ * @brief 把一帧完整的回复(含'\n')发回命令来源的通道
+ * @param priority 只对LoRa通道有效
+ * @return bool 入队或写出失败时返回false
+ */
+bool sendReply(const ReplyContext &reply, const char *data, size_t len,
+               LoraTxPriority priority = LORA_TX_NORMAL);
+bool sendReply(const ReplyContext &reply, const String &data,
+               LoraTxPriority priority = LORA_TX_NORMAL);
+
+#endif // __REPLY_CHANNEL_H__
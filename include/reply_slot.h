@@ -0,0 +1,80 @@
+// --- 文件名: include/reply_slot.h ---
+// 组播/广播回复分时隙：一帧发给ALL、@组、#区间或$位图时，所有收到的设备
+// 几乎同时处理完毕，若都立即回复ACK会在空中相互碰撞
+// 每台设备按自己的时隙号错开回复：
+//   发送时刻 = 收到请求的时刻 + REPLY_SLOT_LEAD_MS + 时隙号 * 时隙宽度
+//   时隙宽度 = REPLY_SLOT_FRAME_BYTES字节的回复 + REPLY_SLOT_NOTICE_BYTES字节的
+//             参数变化通知，两帧的空中时间 + 保护间隔
+// 时隙号默认取设备号-1 (SR_01 -> 0)，也可用SET_SLOT命令指定并保存到NVS
+// 时隙号各不相同时不会碰撞，上位机在 LEAD + (最大时隙号+1) * 宽度 内收齐回复
+//
+// 中继汇总(RELAY_MODE 2)：中继不再逐帧转发下游发给上位机的ACK，
+// 而是改写为 HOST:<中继>:ACK:@<来源>,<原负载> 并暂存到一个汇总窗口，
+// 窗口结束后在中继自己的时隙内合并为一帧发出，多条之间用'|'分隔
+// 本模块不依赖Arduino，时间由调用者传入(毫秒)
+
+#ifndef __REPLY_SLOT_H__
+#define __REPLY_SLOT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define REPLY_SLOT_AUTO 0xFF          // 未指定时隙号，由设备号推导
+#define REPLY_SLOT_FRAME_BYTES 64     // 按多长的回复计算时隙宽度(整帧)
+#define REPLY_SLOT_NOTICE_BYTES 48    // 只含版本号的 PARAM_DELTA 通知(整帧)
+#define REPLY_SLOT_GUARD_US 4000      // 保护间隔：时钟粒度、AUX与串口延迟
+#define REPLY_SLOT_LEAD_MS 5          // 第一个时隙之前留给所有设备处理请求的时间
+#define REPLY_AGGREGATE_WINDOW_MS 500 // 中继汇总下游ACK的窗口
+#define REPLY_AGGREGATE_ORIGIN '@'    // 汇总负载中来源设备名的前缀
+
+class ReplySlots {
+  public:
+    ReplySlots();
+
+    /**
+     * @brief 设置本机时隙号
+     * @param slot SET_SLOT指定的时隙号，REPLY_SLOT_AUTO表示由deviceNum推导
+     * @param deviceNum 本机1字节ID(binaryIdFromName)
+     */
+    void setIndex(uint8_t slot, uint8_t deviceNum);
+    uint8_t getIndex() const { return index; }
+    bool isAssigned() const { return assigned; }
+
+    void setAirRate(uint32_t airRateBps); // 模块空速改变时调用，重新计算宽度
+    uint32_t widthMs() const { return width; }
+
+    /**
+     * @brief 收到组播请求后，本机回复应当开始发送的时刻
+     */
+    uint32_t dueMs(uint32_t requestMs) const;
+
+    /**
+     * @brief 中继汇总：本条ACK应当暂存到的时刻
+     * 窗口内到达的ACK共用同一时刻，发送时由TxScheduler合并为一帧
+     */
+    uint32_t aggregateDueMs(uint32_t nowMs);
+
+  private:
+    uint8_t index;
+    bool assigned;
+    uint32_t width;
+    uint32_t aggregateUntilMs;
+    bool aggregating;
+};
+
+/**
+ * @brief 把下游发给上位机的ACK改写为本机发出的汇总ACK
+ * 负载中每一项都加上 @<来源>, 前缀，已经带前缀的项(来自更下游的中继)保持不变
+ * @param receiver 原帧的接收者(上位机)
+ * @param origin 原帧发送者名字
+ * @param self 本机名字
+ * @param ttl 发往上位机还需的跳数，0时不带/T选项
+ * @return size_t 写入的字节数(含'\n')，空间不足返回0
+ */
+size_t formatAggregatedAck(const char *receiver, const char *origin,
+                           size_t originLen, const char *self, uint8_t ttl,
+                           const char *payload, char *out, size_t cap);
+
+extern ReplySlots replySlots; // 定义在LORA.cpp
+
+#endif // __REPLY_SLOT_H__
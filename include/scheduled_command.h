@@ -0,0 +1,85 @@
+// --- 文件名: include/scheduled_command.h ---
+// 定时执行：发送者字段带 /A<上位机时间us的低32位> 的命令不立即执行，
+// 而是换算成本地时间后挂到一次性esp_timer上；到点时定时器回调只唤醒LoRa任务，
+// 命令由LoRa任务执行(runDue)，与其他命令一样不会和帧处理并发
+// 例：ALL:HOST/A123456789:M_F:  所有模块在上位机时间123456789us时同时启动
+// 时间基准由SYNC信标建立，见 clock_sync.h
+
+#ifndef __SCHEDULED_COMMAND_H__
+#define __SCHEDULED_COMMAND_H__
+
+#include "clock_sync.h"
+#include "frame_parser.h"
+#include "esp_timer.h"
+#include "reply_channel.h"
+#include <Arduino.h>
+
+#define SCHED_SLOT_MAX 4              // 同时等待执行的命令数
+#define SCHED_COMMAND_MAX_LEN 24      // 命令字最大长度
+#define SCHED_MAX_AHEAD_US 60000000LL // 最多提前60秒安排
+
+struct ScheduledStats {
+    uint32_t armed;    // 已安排的命令数
+    uint32_t late;     // 到达时已过执行时刻而立即执行的命令数
+    uint32_t rejected; // 未同步、过远或槽位已满而拒绝的命令数
+    int32_t lastLagUs; // 最近一次命令实际执行时刻与目标时刻之差
+};
+
+class CommandScheduler {
+  public:
+    CommandScheduler();
+
+    void init(); // 创建定时器，必须在第一次schedule之前调用
+
+    /**
+     * @brief 收到SYNC信标，localUs是收到信标时的本地时间
+     */
+    void onBeacon(uint64_t hostUs, int64_t localUs) {
+        clock.onBeacon(hostUs, localUs);
+    }
+
+    /**
+     * @brief 在上位机时间hostUsLow执行命令，命令与参数会被拷贝
+     * @param reply 请求的回复方式；组播请求的回复在执行时重新按时隙排定
+     * @return bool 未同步、时间过远或槽位已满时返回false，命令不会执行
+     */
+    bool schedule(uint32_t hostUsLow, const char *command, const char *args,
+                  const ReplyContext &reply);
+
+    /**
+     * @brief 执行已到时刻的命令，按目标时刻先后
+     * 只在LoRa任务中调用：定时器回调唤醒LoRa任务后调用一次
+     */
+    void runDue();
+
+    void cancelAll(); // 取消所有尚未执行的命令，用于立即STOP，可跨任务调用
+
+    const ClockSync &getClock() const { return clock; }
+    ScheduledStats getStats() const { return stats; }
+
+  private:
+    enum SlotState : uint8_t {
+        SLOT_FREE,
+        SLOT_ARMED, // 定时器已启动
+        SLOT_FIRED, // 已到时刻，等待LoRa任务执行
+    };
+
+    struct Slot {
+        esp_timer_handle_t timer;
+        volatile SlotState state;
+        int64_t dueUs;
+        ReplyContext reply;
+        char command[SCHED_COMMAND_MAX_LEN + 1];
+        char args[FRAME_MAX_LEN + 1];
+    };
+
+    static void onTimer(void *arg);
+
+    ClockSync clock;
+    Slot slots[SCHED_SLOT_MAX];
+    ScheduledStats stats;
+};
+
+extern CommandScheduler commandScheduler;
+
+#endif // __SCHEDULED_COMMAND_H__
@@ -14,7 +14,9 @@
 // 这样其他文件如果 #include "tasks.h"，就可以访问这些句柄
 
 // 任务句柄
+extern TaskHandle_t xTaskMotionHandle;
 extern TaskHandle_t xTaskLoRaHandle;
+extern TaskHandle_t xTaskLoRaTxHandle;
 extern TaskHandle_t xTaskOTAHandle;
 extern TaskHandle_t xTaskLEDHandle;
 
@@ -39,4 +41,11 @@ void tasks_init();
  */
 void safePrintln(String msg);
 
+/**
+ * @brief 线程安全地打印 前缀+消息，不产生String拼接(无堆分配)
+ * @param prefix 前缀
+ * @param msg 要打印的C字符串
+ */
+void safePrintln(const char *prefix, const char *msg);
+
 #endif // __TASKS_H__
\ No newline at end of file
@@ -0,0 +1,77 @@
+// --- 文件名: include/text_dict.h ---
+// 文本协议的静态字典压缩：负载中反复出现的命令字、参数名用一个字节代替
+// 码字为 TEXT_DICT_CODE_BASE + 词条序号(0x80起)，纯ASCII的文本帧中不会出现这些字节，
+// 所以接收端总是可以直接展开，不认识字典的旧上位机发来的帧不受影响
+// 词条表由 Command.h 中的命令字和参数注册表(param_registry.cpp)中的参数名生成，
+// 码字按顺序分配：只能在末尾追加词条，不能删除或调整顺序，否则两端会错位
+// 接收端在 FrameBuffer::push 中逐字节展开，不需要额外缓冲区
+// 本模块不依赖Arduino，上位机可直接编译使用(textDictMeasure用于统计抓包数据的压缩率)
+
+#ifndef __TEXT_DICT_H__
+#define __TEXT_DICT_H__
+
+#include "Command.h"
+#include "binary_frame.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define TEXT_DICT_CODE_BASE 0x80
+#define TEXT_DICT_MIN_WORD 3 // 更短的词替换后收益不到1字节
+
+// clang-format off
+#define TEXT_DICT_WORDS(X)                                                     \
+    X(SET_BATCH_PARAMS) X(REPORT_ALL_PARAMS) X(LINK_STATS) X(ENABLE_STEP_MODE) \
+    X(SWAP_DIRECTION) X(OTA_ENABLE) X(OTA_DISABLE) X(RELAY_MODE)               \
+    X(SET_GROUPS) X(SET_SLOT) X(LORA_CFG) X(AIRTIME) X(VOLTAGE) X(MOV_PAR_F)   \
+    X(MOV_PAR_B) X(GET_IP) X(PING) X(PONG) X(SYNC) X(STOP) X(ACK)              \
+    X("REPORT_IP") X("BATCH_OK") X("HOST")                                     \
+    X("DUTY") X("FWD_FREQ") X("FWD_PHASE") X("BWD_FREQ") X("BWD_PHASE")        \
+    X("STEP_TIME_MS") X("STILL_TIME_MS") X("STEP_MODE_ENABLED")                \
+    X("direction_reversed") X("ENABLED") X("DISABLED") X("REVERSED")           \
+    X("NORMAL") X("SEQ,") X(".00;") X(DICT_MODE) X("BATCH_FAIL")               \
+    X(PARAM_DELTA)
+// clang-format on
+
+#define TEXT_DICT_ENTRY(word) word,
+static constexpr const char *textDictWords[] = {
+    TEXT_DICT_WORDS(TEXT_DICT_ENTRY)};
+#undef TEXT_DICT_ENTRY
+
+#define TEXT_DICT_SIZE (sizeof(textDictWords) / sizeof(textDictWords[0]))
+
+// 码字不能与二进制帧的同步字节冲突，否则以码字开头的文本帧会被当成二进制帧
+static_assert(TEXT_DICT_CODE_BASE + TEXT_DICT_SIZE <= BIN_FRAME_SYNC,
+              "Text dictionary codes collide with BIN_FRAME_SYNC");
+
+/**
+ * @brief 码字对应的词条
+ * @return const char* 不是码字时返回NULL
+ */
+const char *textDictWord(uint8_t code, size_t &len);
+
+/**
+ * @brief 原地压缩一帧文本：每个位置取最长的匹配词条替换为码字
+ * 输出不会比输入长，所以可以原地进行
+ * @return size_t 压缩后的长度
+ */
+size_t textDictCompress(char *data, size_t len);
+
+/**
+ * @brief 展开到out，用于上位机；设备接收路径在FrameBuffer中逐字节展开
+ * @return size_t 写入的字节数，空间不足返回0
+ */
+size_t textDictExpand(const char *in, size_t len, char *out, size_t cap);
+
+struct TextDictStats {
+    uint32_t frames;
+    uint32_t rawBytes;
+    uint32_t compressedBytes;
+};
+
+/**
+ * @brief 上位机：统计一段抓包文本(未压缩，每帧以'\n'结尾)的压缩效果
+ * 结果累加到stats，压缩率 = compressedBytes / rawBytes
+ */
+void textDictMeasure(const char *capture, size_t len, TextDictStats &stats);
+
+#endif // __TEXT_DICT_H__
@@ -0,0 +1,87 @@
+// --- 文件名: include/tx_scheduler.h ---
+// LoRa发送调度：按空中时间预算发送，合并同一目标的ACK，丢弃被新状态覆盖的上报，
+// 组播回复暂存到本机时隙再发送(见 reply_slot.h)
+// "同一目标"指接收者和发送者名(不含选项)都相同：转发的帧只与同一来源的帧合并
+// 本模块不依赖Arduino，时间由调用者传入(毫秒)
+
+#ifndef __TX_SCHEDULER_H__
+#define __TX_SCHEDULER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LORA_TX_FRAME_MAX 256 // 单个待发送帧的最大字节数
+#define TX_STAGE_MAX 16       // 调度器内部暂存的最大帧数
+#define TX_ACK_SEPARATOR '|'  // 合并后的ACK负载之间的分隔符
+
+// 已格式化好的待发送帧，整帧拷贝进队列，调用者无需保留原数据
+struct LoraTxFrame {
+    uint8_t priority; // LoraTxPriority，数值越小越先发送
+    bool held;        // 为true时在dueMs之前不发送
+    uint32_t dueMs;
+    uint16_t len;
+    char data[LORA_TX_FRAME_MAX + 1];
+};
+
+struct TxSchedulerStats {
+    uint32_t coalesced;       // 被合并进其他ACK帧的帧数
+    uint32_t superseded;      // 被更新的状态上报覆盖而未发送的帧数
+    uint32_t throttled;       // 因空中时间预算不足而推迟发送的次数
+    uint32_t slotted;         // 暂存到时隙后发送的帧数
+    uint64_t airtimeUs;       // 累计空中时间
+    uint32_t dutyPermille;    // 上一个统计窗口的占空比(千分比)
+    uint32_t budgetPermille;  // 配置的占空比上限(千分比)
+};
+
+class TxScheduler {
+  public:
+    /**
+     * @param airRateBps 空中速率
+     * @param dutyPermille 允许的最大占空比(千分比)，例如100表示10%
+     * @param windowMs 占空比统计窗口，同时也是预算桶的容量
+     */
+    TxScheduler(uint32_t airRateBps, uint32_t dutyPermille, uint32_t windowMs);
+
+    /**
+     * @brief 暂存一帧；状态上报和序号ACK会覆盖同一目标尚未发送的旧帧
+     * @return bool 暂存区已满时返回false
+     */
+    bool stage(const LoraTxFrame &frame);
+
+    /**
+     * @brief 取出下一帧：已到时刻的帧中优先级最高的最早一帧，
+     * ACK会与同一目标的其他已到时刻的ACK合并
+     * @param nowMs 当前时间
+     * @param waitMs 预算不足或帧未到时刻时输出需要等待的时间
+     * @return bool 没有可发送的帧、帧未到时刻或预算不足时返回false
+     */
+    bool next(uint32_t nowMs, LoraTxFrame &out, uint32_t &waitMs);
+
+    uint32_t airtimeUs(size_t len) const; // 估算一帧的空中时间
+    void setAirRate(uint32_t airRateBps) { airRate = airRateBps; } // 模块空速改变时调用
+    bool empty() const { return count == 0; }
+    bool full() const { return count >= TX_STAGE_MAX; }
+    TxSchedulerStats getStats(uint32_t nowMs);
+
+  private:
+    void refill(uint32_t nowMs);
+    void remove(int index);
+    bool due(int index, uint32_t nowMs) const;
+
+    LoraTxFrame staged[TX_STAGE_MAX];
+    int count;
+
+    uint32_t airRate;
+    uint32_t duty;
+    uint32_t window;
+
+    uint32_t tokensUs;    // 当前可用的空中时间
+    uint32_t lastRefillMs;
+    uint32_t windowStartMs;
+    uint32_t windowUsedUs;
+    bool started;
+
+    TxSchedulerStats stats;
+};
+
+#endif // __TX_SCHEDULER_H__
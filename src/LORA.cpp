@@ -3,13 +3,21 @@
 #include "LORA.h"
 #include "Command.h"
 #include "Pins.h"
+#include "address_filter.h"
+#include "frame_parser.h"
+#include "reply_slot.h"
+#include "text_dict.h"
 #include "tasks.h"
 #include <HardwareSerial.h>
 #include <Preferences.h>
+#include <stdio.h>
 
 LORA lora; // 全局变量定义
 String deviceID = "";
 String hostID = "HOST";
+uint8_t deviceNum = 0;
+AddressFilter addressFilter;
+ReplySlots replySlots;
 
 String LORA::getDeviceID() {
     Preferences prefs;
@@ -31,6 +39,36 @@ String LORA::getDeviceID() {
     }
 }
 
+String LORA::getGroups() {
+    Preferences prefs;
+    prefs.begin("robot", true);
+    String groups = prefs.getString("GROUPS", "");
+    prefs.end();
+    return groups;
+}
+
+void LORA::saveGroups(const char *groups) {
+    Preferences prefs;
+    prefs.begin("robot", false);
+    prefs.putString("GROUPS", groups);
+    prefs.end();
+}
+
+uint8_t LORA::loadReplySlot() {
+    Preferences prefs;
+    prefs.begin("robot", true);
+    uint8_t slot = prefs.getUChar("REPLY_SLOT", REPLY_SLOT_AUTO);
+    prefs.end();
+    return slot;
+}
+
+void LORA::saveReplySlot(uint8_t slot) {
+    Preferences prefs;
+    prefs.begin("robot", false);
+    prefs.putUChar("REPLY_SLOT", slot);
+    prefs.end();
+}
+
 void LORA::sendHexCommand(const char *hexString, HardwareSerial &serialPort) {
     int len = strlen(hexString) / 2;
     uint8_t sendBuffer[len];
@@ -53,71 +91,623 @@ void LORA::sendHexCommand(const char *hexString, HardwareSerial &serialPort) {
     Serial.println();
 }
 
+// 正在等待AUX的任务，由AUX上升沿中断通知
+static volatile TaskHandle_t auxWaiter = NULL;
+
+static void IRAM_ATTR onAuxRising() {
+    TaskHandle_t waiter = auxWaiter;
+    if (waiter != NULL) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(waiter, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
 // 等待AUX引脚高电平，表示模块准备就绪
-static void waitAUXReady() {
-    while (digitalRead(AUX) == LOW)
-        ;      // 等待模块处理完
-    delay(20); // 稳定延迟
+bool LORA::waitAUXReady(uint32_t &waitedUs) {
+    int64_t start = esp_timer_get_time();
+    bool ready = true;
+
+    if (digitalRead(AUX) == LOW) {
+        auxWaiter = xTaskGetCurrentTaskHandle();
+        ulTaskNotifyTake(pdTRUE, 0); // 清掉残留的通知
+        // 注册之后重新检查电平，避免注册前已变高而错过边沿
+        while (digitalRead(AUX) == LOW) {
+            uint32_t elapsedMs = (esp_timer_get_time() - start) / 1000;
+            if (elapsedMs >= auxTimeoutMs ||
+                ulTaskNotifyTake(pdTRUE,
+                                 pdMS_TO_TICKS(auxTimeoutMs - elapsedMs)) == 0) {
+                ready = (digitalRead(AUX) == HIGH);
+                break;
+            }
+        }
+        auxWaiter = NULL;
+    }
+
+    waitedUs = (uint32_t)(esp_timer_get_time() - start);
+    auxStats.totalWaitUs += waitedUs;
+    if (!ready) {
+        auxStats.timeouts++;
+        return false;
+    }
+    if (auxSettleMs > 0) {
+        vTaskDelay(pdMS_TO_TICKS(auxSettleMs)); // 稳定延迟
+    }
+    return true;
+}
+
+bool LORA::resetModule() {
+    safePrintln("LoRa module not ready, resetting via MD0/MD1...");
+    auxStats.resets++;
+    // 进入深度睡眠再回到正常工作模式，模块会重新自检
+    digitalWrite(MD0, HIGH);
+    digitalWrite(MD1, HIGH);
+    vTaskDelay(pdMS_TO_TICKS(LORA_MODE_SWITCH_MS));
+    digitalWrite(MD0, HIGH);
+    digitalWrite(MD1, LOW);
+    vTaskDelay(pdMS_TO_TICKS(LORA_MODE_SWITCH_MS));
+
+    uint32_t waitedUs;
+    return waitAUXReady(waitedUs);
+}
+
+bool LORA::enterConfigMode() {
+    uint32_t waitedUs;
+    waitAUXReady(waitedUs);
+    digitalWrite(MD0, LOW);
+    digitalWrite(MD1, LOW);
+    vTaskDelay(pdMS_TO_TICKS(LORA_MODE_SWITCH_MS));
+    bool ready = waitAUXReady(waitedUs);
+    if (rxLock != NULL) {
+        // configuring已置位，等正在进行的一次搬运结束，此后回调不再读Serial1
+        xSemaphoreTake(rxLock, portMAX_DELAY);
+        xSemaphoreGive(rxLock);
+    }
+    while (Serial1.available()) {
+        Serial1.read(); // 丢掉切换前收到的残留数据，避免混进回复里
+    }
+    return ready;
+}
+
+bool LORA::leaveConfigMode(uint32_t &waitedUs) {
+    waitAUXReady(waitedUs);
+    digitalWrite(MD0, HIGH);
+    digitalWrite(MD1, LOW);
+    vTaskDelay(pdMS_TO_TICKS(LORA_MODE_SWITCH_MS));
+    return waitAUXReady(waitedUs);
+}
+
+bool LORA::readReply(uint8_t *buf, size_t len) {
+    size_t got = 0;
+    uint32_t start = millis();
+    while (got < len && millis() - start < LORA_CONFIG_REPLY_MS) {
+        if (Serial1.available()) {
+            got += Serial1.read(buf + got, len - got);
+        } else {
+            vTaskDelay(1);
+        }
+    }
+    return got == len;
+}
+
+bool LORA::writeRegisters(uint8_t offset, const uint8_t *data, uint8_t len) {
+    uint8_t frame[LORA_CMD_HEADER_LEN + LORA_REG_COUNT];
+    uint8_t reply[LORA_CMD_HEADER_LEN + LORA_REG_COUNT];
+    if (len > LORA_REG_COUNT) {
+        return false;
+    }
+    frame[0] = LORA_CMD_WRITE;
+    frame[1] = LORA_REG_BASE + offset;
+    frame[2] = len;
+    memcpy(frame + LORA_CMD_HEADER_LEN, data, len);
+    Serial1.write(frame, LORA_CMD_HEADER_LEN + len);
+    // 模块写入成功后原样回显
+    return readReply(reply, LORA_CMD_HEADER_LEN + len) &&
+           memcmp(reply, frame, LORA_CMD_HEADER_LEN + len) == 0;
+}
+
+int LORA::syncRegisters(const uint8_t *desired, bool force) {
+    uint8_t current[LORA_REG_COUNT];
+    LoraRegRun runs[LORA_REG_RUN_MAX];
+    size_t count;
+    if (!force && loadRegisters(current)) {
+        count = loraRegDiff(current, desired, runs, LORA_REG_RUN_MAX);
+    } else {
+        runs[0].offset = 0;
+        runs[0].len = LORA_REG_COUNT;
+        count = 1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!writeRegisters(runs[i].offset, desired + runs[i].offset,
+                            runs[i].len)) {
+            saveRegisters(NULL); // 模块内容已不确定，下次整块写入
+            return -1;
+        }
+    }
+    if (count > 0) {
+        saveRegisters(desired);
+    }
+    return (int)count;
+}
+
+bool LORA::loadRegisters(uint8_t *regs) {
+    Preferences prefs;
+    prefs.begin("robot", true);
+    bool ok = prefs.getBytesLength("LORA_REGS") == LORA_REG_COUNT &&
+              prefs.getBytes("LORA_REGS", regs, LORA_REG_COUNT) ==
+                  LORA_REG_COUNT;
+    prefs.end();
+    return ok;
+}
+
+void LORA::saveRegisters(const uint8_t *regs) {
+    Preferences prefs;
+    prefs.begin("robot", false);
+    if (regs != NULL) {
+        prefs.putBytes("LORA_REGS", regs, LORA_REG_COUNT);
+    } else {
+        prefs.remove("LORA_REGS");
+    }
+    prefs.end();
+}
+
+bool LORA::pingHost() {
+    static FrameBuffer reply; // 只在配置期间使用，接收任务此时不读Serial1
+    String ping = hostID + ":" + deviceID + ":" + PING + ":" + String(uartBaud) +
+                  "\n";
+    for (int attempt = 0; attempt < LORA_PING_ATTEMPTS; attempt++) {
+        vTaskDelay(pdMS_TO_TICKS(esp_random() % LORA_PING_JITTER_MS));
+        transmit(ping.c_str(), ping.length());
+
+        reply.reset();
+        uint32_t start = millis();
+        while (millis() - start < LORA_PING_TIMEOUT_MS) {
+            if (!Serial1.available()) {
+                vTaskDelay(1);
+                continue;
+            }
+            if (reply.push((char)Serial1.read()) != FRAME_READY) {
+                continue;
+            }
+            // 等待期间收到的其他帧直接丢弃
+            FrameFields fields;
+            bool pong = tokenizeFrame(reply.data(), reply.length(), fields) &&
+                        fields.receiver.equals(deviceID.c_str(),
+                                               deviceID.length()) &&
+                        fields.command.equals(PONG);
+            reply.reset();
+            if (pong) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+LoraConfigResult LORA::applyConfig(uint8_t *desired, bool force) {
+    uint32_t waitedUs;
+    Serial1.updateBaudRate(LORA_CONFIG_BAUD); // 配置模式下串口固定为9600
+    bool ok = enterConfigMode() && syncRegisters(desired, force) >= 0;
+    leaveConfigMode(waitedUs);
+    if (!ok) {
+        Serial1.updateBaudRate(uartBaud);
+        return LORA_CONFIG_FAILED;
+    }
+    radio = loraGetRadio(desired);
+    fixedMode = loraIsFixed(desired); // 此后发出的帧(包括PING)带帧头
+    txScheduler.setAirRate(loraAirRateBps(radio.airRate));
+    replySlots.setAirRate(loraAirRateBps(radio.airRate));
+
+    // 波特率寄存器已随回显逐字节核对(或与上次核对过的副本一致)，
+    // 模块回到正常模式后按新波特率工作，串口跟着切换
+    uartBaud = loraGetBaud(desired);
+    Serial1.updateBaudRate(uartBaud);
+    return LORA_CONFIG_APPLIED;
+}
+
+LoraConfigResult LORA::confirmBaud(uint8_t *desired) {
+    if (uartBaud == LORA_CONFIG_BAUD || pingHost()) {
+        return LORA_CONFIG_APPLIED;
+    }
+
+    // 新波特率下联系不上上位机：模块和串口都退回9600
+    uint32_t waitedUs;
+    safePrintln("LORA ping failed at new UART baud, falling back to 9600.");
+    loraSetBaud(desired, LORA_CONFIG_BAUD);
+    uartBaud = LORA_CONFIG_BAUD;
+    Serial1.updateBaudRate(LORA_CONFIG_BAUD);
+    if (enterConfigMode()) {
+        syncRegisters(desired, false);
+    }
+    leaveConfigMode(waitedUs);
+    return LORA_CONFIG_FALLBACK;
 }
 
 void LORA::initLORA() {
     // 1. 基础硬件和串口初始化
-    Serial1.begin(9600, SERIAL_8N1, U1RXD, U1TXD);
+    // 接收缓冲区必须在begin之前设置，保证LoRa任务批量读取前数据不溢出
+    Serial1.setRxBufferSize(LORA_RX_BUFFER_SIZE);
+    Serial1.begin(LORA_CONFIG_BAUD, SERIAL_8N1, U1RXD, U1TXD);
     pinMode(MD0, OUTPUT);
     pinMode(MD1, OUTPUT);
     pinMode(AUX, INPUT);
+    attachInterrupt(digitalPinToInterrupt(AUX), onAuxRising, RISING);
+    uint32_t waitedUs;
+
+    // 2. 目标配置 = LORA_DEFAULT_CONFIG + NVS中保存的运行时无线参数和串口波特率
+    LoraRegisters desired = LORA_DEFAULT_CONFIG.registers();
+    LoraRadioParams saved;
+    if (loadConfig(saved)) {
+        loraSetRadio(desired.data(), saved);
+    }
+    loraSetBaud(desired.data(), loadUartBaud());
+    bool fixed = loadFixedMode();
+    setAddressing(desired.data(), fixed);
 
-    // 2. 检查手动配置开关
 #if FORCE_LORA_CONFIG == true
-    // --- 如果开关为 true, 执行完整的配置流程 ---
-    Serial.println(
-        "FORCE_LORA_CONFIG is true. Performing full LoRa configuration...");
+    // 强制配置：不管模块当前内容，整块写入
+    Serial.println("FORCE_LORA_CONFIG is true. Writing full LoRa "
+                   "configuration...");
+    LoraConfigResult r = applyConfig(desired.data(), true);
+#else
+    // 与上次写入的副本比较，只写入不同的段；一致时不写，避免磨损模块存储
+    LoraConfigResult r = applyConfig(desired.data(), false);
+#endif
+    if (r == LORA_CONFIG_FAILED) {
+        Serial.println("LORA configuration not verified.");
+    } else {
+        saveConfig();
+        Serial.println("LORA configured, UART " + String(uartBaud) + " baud" +
+                       (fixedMode ? ", fixed-point addressing." : "."));
+    }
 
-    waitAUXReady();
+    // 3. 确认已处于正常工作模式
+    if (!waitAUXReady(waitedUs)) {
+        Serial.println("LORA AUX timeout after mode switch.");
+    } else {
+        // 打印实测的就绪时间，用于标定稳定延时
+        Serial.println("LORA switched to normal working mode, AUX ready in " +
+                       String(waitedUs) + " us.");
+    }
+}
 
-    digitalWrite(MD0, LOW);
-    digitalWrite(MD1, LOW);
-    delay(100);
+bool LORA::loadConfig(LoraRadioParams &saved) {
+    Preferences prefs;
+    prefs.begin("robot", true);
+    uint16_t word = prefs.getUShort("LORA_RADIO", 0xFFFF);
+    prefs.end();
+    if (word == 0xFFFF) {
+        return false;
+    }
+    saved = loraUnpackRadio(word);
+    return loraRadioValid(saved);
+}
 
-    sendHexCommand(LoraCMD, Serial1);
-    delay(500);
+bool LORA::loadFixedMode() {
+    Preferences prefs;
+    prefs.begin("robot", true);
+    bool fixed = prefs.getBool("LORA_FIXED", LORA_FIXED_MODE_DEFAULT);
+    prefs.end();
+    return fixed;
+}
 
-    while (Serial1.available()) {
-        uint8_t byteIn = Serial1.read();
-        Serial.print("模块回复: 0x");
-        if (byteIn < 0x10)
-            Serial.print("0");
-        Serial.println(byteIn, HEX);
+void LORA::setAddressing(uint8_t *regs, bool fixed) {
+    if (fixed && deviceNum != BIN_ID_HOST && deviceNum != BIN_ID_BROADCAST) {
+        loraSetFixed(regs, GroupNum, deviceNum);
     }
+}
 
-    Serial.println("LORA configuration complete.");
+uint32_t LORA::loadUartBaud() {
+    Preferences prefs;
+    prefs.begin("robot", true);
+    uint32_t baud = prefs.getUInt("UART_BAUD", LORA_UART_BAUD);
+    prefs.end();
+    return loraBaudValid(baud) ? baud : LORA_CONFIG_BAUD;
+}
 
-#else
-    // --- 如果开关为 false, 直接跳过 ---
-    Serial.println("FORCE_LORA_CONFIG is false. Skipping LoRa configuration.");
-#endif
+void LORA::saveConfig() {
+    Preferences prefs;
+    prefs.begin("robot", false);
+    prefs.putUShort("LORA_RADIO", loraPackRadio(radio));
+    prefs.putUInt("UART_BAUD", uartBaud);
+    prefs.putBool("LORA_FIXED", fixedMode);
+    prefs.end();
+}
 
-    // 3. 无论如何，最后都切换到正常工作模式
-    waitAUXReady();
-    digitalWrite(MD0, HIGH);
-    digitalWrite(MD1, LOW);
-    delay(100);
-    Serial.println("LORA switched to normal working mode.");
+bool LORA::requestRadioConfig(const LoraRadioParams &next, uint32_t baud,
+                              bool fixed, const LoraTxRoute &route) {
+    if (!loraRadioValid(next) || !loraBaudValid(baud)) {
+        return false;
+    }
+    // 定点传输以设备号作为模块地址，上位机和广播地址不能用作本机地址
+    if (fixed && (deviceNum == BIN_ID_HOST || deviceNum == BIN_ID_BROADCAST)) {
+        return false;
+    }
+    pendingRadio = next;
+    pendingBaud = baud;
+    pendingFixed = fixed;
+    pendingRoute = route;
+    pendingRoute.held = false; // 切换耗时不定，完成后立即回复
+    radioPending = true;
+    if (txWake != NULL) {
+        xSemaphoreGive(txWake); // 唤醒发送任务执行切换
+    }
+    return true;
 }
 
-void LORA::sendData(const String &data) {
+void LORA::applyPendingRadio() {
+    radioPending = false;
+
+    LoraRegisters desired = LORA_DEFAULT_CONFIG.registers();
+    loraSetRadio(desired.data(), pendingRadio);
+    loraSetBaud(desired.data(), pendingBaud);
+    setAddressing(desired.data(), pendingFixed);
+
+    // 配置和ping期间接收任务不读Serial1，模块的回复只由这里读取
+    // 上位机刚发来LORA_CFG、正在等待回复，此时可以用PING确认新波特率
+    uint32_t previousBaud = uartBaud;
+    configuring = true;
+    LoraConfigResult r = applyConfig(desired.data(), false);
+    if (r == LORA_CONFIG_APPLIED && uartBaud != previousBaud) {
+        r = confirmBaud(desired.data());
+    }
+    configuring = false;
+
+    if (r != LORA_CONFIG_FAILED) {
+        saveConfig();
+    }
+    static const char *const resultNames[] = {"APPLIED", "FALLBACK", "FAILED"};
+    String response = hostID + ":" + deviceID + ":" + ACK + ":" + LORA_CFG +
+                      "," + resultNames[r] + "," + String(radio.channel) + "," +
+                      String(radio.power) + "," + String(radio.airRate) + "," +
+                      String(uartBaud) + "," + String(fixedMode ? 1 : 0) + "\n";
+    sendData(response, LORA_TX_HIGH, pendingRoute);
+}
+
+// 串口接收事件回调，运行在UART事件任务中
+// Arduino不开放UART接收中断本身，这是驱动中断之后最早能拿到数据的地方
+static void onLoraReceive() { lora.pumpRx(); }
+
+void LORA::enableRxEvents() {
+    rxStream = xStreamBufferCreate(LORA_RX_BUFFER_SIZE, 1);
+    rxLock = xSemaphoreCreateMutex();
+    Serial1.setRxTimeout(LORA_RX_TIMEOUT_SYMBOLS);
+    Serial1.onReceive(onLoraReceive);
+}
+
+void LORA::pumpRx() {
+    if (configuring || rxStream == NULL ||
+        xSemaphoreTake(rxLock, 0) != pdTRUE) {
+        return;
+    }
+    int64_t eventUs = esp_timer_get_time();
+    int available;
+    while (!configuring && (available = Serial1.available()) > 0) {
+        // 只读出接收流放得下的部分，其余留在Serial1中，等LoRa任务取走后再搬
+        size_t space = xStreamBufferSpacesAvailable(rxStream);
+        size_t toRead = (size_t)available < space ? available : space;
+        if (toRead > sizeof(rxPumpChunk)) {
+            toRead = sizeof(rxPumpChunk);
+        }
+        if (toRead == 0) {
+            break;
+        }
+        size_t n = Serial1.read(rxPumpChunk, toRead);
+        for (size_t i = 0; i < n; i++) {
+            if (stopDetector.push(rxPumpChunk[i]) && stopHandler != NULL) {
+                stopHandler();
+                uint32_t us = (uint32_t)(esp_timer_get_time() - eventUs);
+                fastStopStats.count++;
+                fastStopStats.lastUs = us;
+                if (us > fastStopStats.maxUs) {
+                    fastStopStats.maxUs = us;
+                }
+            }
+        }
+        xStreamBufferSend(rxStream, rxPumpChunk, n, 0);
+    }
+    xSemaphoreGive(rxLock);
+    if (xTaskLoRaHandle != NULL) {
+        xTaskNotifyGive(xTaskLoRaHandle);
+    }
+}
+
+size_t LORA::readRx(uint8_t *buf, size_t cap) {
+    if (rxStream == NULL) {
+        return 0;
+    }
+    size_t n = xStreamBufferReceive(rxStream, buf, cap, 0);
+    if (n == 0 && !configuring && Serial1.available() > 0) {
+        pumpRx(); // 事件丢失，或上次接收流已满有数据留在Serial1中
+        n = xStreamBufferReceive(rxStream, buf, cap, 0);
+    }
+    return n;
+}
+
+void LORA::initTxQueue() {
+    for (int i = 0; i < LORA_TX_PRIORITY_COUNT; i++) {
+        txQueues[i] = xQueueCreate(LORA_TX_QUEUE_DEPTH, sizeof(LoraTxFrame));
+    }
+    txWake = xSemaphoreCreateBinary();
+}
+
+/**
+ * @brief 在发送者字段末尾插入/T<n>，使中继设备把帧转发回上位机
+ * 空间不足或字段中已有T选项时保持原样
+ */
+static void addReplyTtl(LoraTxFrame &frame, uint8_t ttl) {
+    char *first = (char *)memchr(frame.data, ':', frame.len);
+    if (first == NULL) {
+        return;
+    }
+    char *end = frame.data + frame.len;
+    char *second = (char *)memchr(first + 1, ':', end - first - 1);
+    if (second == NULL) {
+        return;
+    }
+    for (char *p = first + 1; p + 1 < second; p++) {
+        if (p[0] == '/' && p[1] == SENDER_OPT_TTL) {
+            return;
+        }
+    }
+    char opt[6];
+    int n = snprintf(opt, sizeof(opt), "/%c%u", SENDER_OPT_TTL, ttl);
+    if (n <= 0 || frame.len + n > LORA_TX_FRAME_MAX) {
+        return;
+    }
+    memmove(second + n, second, end - second + 1); // 连同结尾的'\0'
+    memcpy(second, opt, n);
+    frame.len += n;
+}
+
+bool LORA::sendData(const String &data, LoraTxPriority priority,
+                    const LoraTxRoute &route) {
+    return sendData(data.c_str(), data.length(), priority, route);
+}
+
+bool LORA::sendData(const char *data, size_t len, LoraTxPriority priority,
+                    const LoraTxRoute &route) {
+    if (txWake == NULL) {
+        // 发送任务尚未建立(启动阶段)，退化为直接发送
+        transmit(data, len);
+        return true;
+    }
+    if (len > LORA_TX_FRAME_MAX) {
+        txStats.dropped[priority]++;
+        return false;
+    }
+
+    // 帧在栈上组装后整帧拷贝进队列；超时为0，调用者永不阻塞
+    LoraTxFrame frame;
+    frame.priority = priority;
+    frame.len = len;
+    memcpy(frame.data, data, len);
+    frame.data[len] = '\0';
+    if (route.ttl > 0) {
+        addReplyTtl(frame, route.ttl);
+    }
+    frame.held = route.held;
+    frame.dueMs = route.dueMs;
+    if (xQueueSend(txQueues[priority], &frame, 0) != pdTRUE) {
+        txStats.dropped[priority]++;
+        return false;
+    }
+    uint32_t depth = uxQueueMessagesWaiting(txQueues[priority]);
+    if (depth > txStats.maxDepth[priority]) {
+        txStats.maxDepth[priority] = depth;
+    }
+    xSemaphoreGive(txWake);
+    return true;
+}
+
+void LORA::drainTxQueues() {
+    static LoraTxFrame frame; // 只有发送任务访问，放静态区节省任务栈
+    for (int i = 0; i < LORA_TX_PRIORITY_COUNT; i++) {
+        // 调度器满时把帧留在队列里，由队列本身负责背压和丢弃统计
+        while (!txScheduler.full() &&
+               xQueueReceive(txQueues[i], &frame, 0) == pdTRUE) {
+            txScheduler.stage(frame);
+        }
+    }
+}
+
+bool LORA::processTxQueue(TickType_t timeout) {
+    if (txScheduler.empty() && xSemaphoreTake(txWake, timeout) != pdTRUE) {
+        return false;
+    }
+    if (radioPending) {
+        applyPendingRadio(); // 在两帧之间切换，不会打断正在发送的帧
+    }
+    drainTxQueues();
+
+    static LoraTxFrame frame;
+    uint32_t waitMs;
+    if (!txScheduler.next(millis(), frame, waitMs)) {
+        // 空中时间预算不足：等预算恢复，或者等新帧到来再参与合并
+        if (waitMs > 0) {
+            xSemaphoreTake(txWake, pdMS_TO_TICKS(waitMs));
+        }
+        return false;
+    }
+    if (dictTx && (uint8_t)frame.data[0] != BIN_FRAME_SYNC) {
+        // 字典压缩放在合并与预算之后，调度器只处理明文
+        static char packed[LORA_TX_FRAME_MAX + 1];
+        memcpy(packed, frame.data, frame.len);
+        size_t packedLen = textDictCompress(packed, frame.len);
+        transmit(packed, packedLen, frame.data);
+    } else {
+        transmit(frame.data, frame.len);
+    }
+    txStats.sent++;
+    return true;
+}
+
+LoraTxStats LORA::getTxStats() {
+    LoraTxStats stats = txStats;
+    for (int i = 0; i < LORA_TX_PRIORITY_COUNT; i++) {
+        stats.queued[i] =
+            txQueues[i] != NULL ? uxQueueMessagesWaiting(txQueues[i]) : 0;
+    }
+    return stats;
+}
+
+void LORA::transmit(const char *data, size_t len, const char *text) {
     // 确保是正常工作模式 0
     digitalWrite(MD0, HIGH);
     digitalWrite(MD1, LOW);
 
-    waitAUXReady();
+    uint32_t beforeUs = 0;
+    uint32_t afterUs = 0;
+    if (!waitAUXReady(beforeUs) && !resetModule()) {
+        txStats.failed++;
+        safePrintln("LoRa module still busy after reset, frame dropped.");
+        return;
+    }
+
+    if (fixedMode) {
+        // 帧头按明文的接收者计算，压缩不改变接收者字段
+        uint8_t address = text != NULL ? fixedModeAddress(text, strlen(text))
+                                       : fixedModeAddress(data, len);
+        uint8_t header[LORA_FIXED_HEADER_LEN];
+        loraFixedHeader(GroupNum, address, header);
+        Serial1.write(header, sizeof(header));
+    }
+    Serial1.write((const uint8_t *)data, len); // 直接发送字符串
+
+    if (!waitAUXReady(afterUs)) {
+        resetModule(); // 本帧可能没有完整发出，至少保证下一帧可用
+    }
 
-    Serial1.print(data); // 直接发送字符串
+    // 记录每帧花在AUX上的时间
+    uint32_t frameWaitUs = beforeUs + afterUs;
+    auxStats.lastFrameWaitUs = frameWaitUs;
+    if (frameWaitUs > auxStats.maxFrameWaitUs) {
+        auxStats.maxFrameWaitUs = frameWaitUs;
+    }
+    auxStats.frames++;
+
+    safePrintln("Send: ", text != NULL ? text : data);
+}
+
+TxSchedulerStats LORA::getSchedulerStats() {
+    return txScheduler.getStats(millis());
+}
 
-    waitAUXReady();
-    safePrintln("Send: " + data);
+LoraAuxStats LORA::getAuxStats() {
+    LoraAuxStats stats = auxStats;
+    stats.settleMs = auxSettleMs;
+    return stats;
 }
 
-LORA::LORA() {}
+LORA::LORA()
+    : txQueues(), txWake(NULL), txStats(),
+      txScheduler(LORA_AIR_RATE_BPS, LORA_DUTY_CYCLE_PERMILLE,
+                  LORA_DUTY_WINDOW_MS),
+      auxStats(), auxTimeoutMs(LORA_AUX_TIMEOUT_MS),
+      auxSettleMs(LORA_AUX_SETTLE_MS), dictTx(TEXT_DICT_TX_DEFAULT), radio(),
+      pendingRadio(), pendingBaud(LORA_CONFIG_BAUD), pendingRoute(),
+      uartBaud(LORA_CONFIG_BAUD), fixedMode(false), pendingFixed(false),
+      radioPending(false), configuring(false), rxStream(NULL), rxLock(NULL),
+      rxPumpChunk(), stopDetector(), stopHandler(NULL), fastStopStats() {}
 
 LORA::~LORA() {}
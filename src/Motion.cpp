@@ -10,7 +10,29 @@
 Motion motion;
 Pwm pwm;
 
+// 在作用域内持有Motion的锁；init之前锁尚未创建，此时只有setup在运行，不加锁
+class MotionLock {
+  public:
+    explicit MotionLock(const Motion &m) : lock(m._lock) {
+        if (lock != NULL) {
+            xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+        }
+    }
+    ~MotionLock() {
+        if (lock != NULL) {
+            xSemaphoreGiveRecursive(lock);
+        }
+    }
+
+  private:
+    SemaphoreHandle_t lock;
+};
+
 void Motion::init() {
+    if (_lock == NULL) {
+        _lock = xSemaphoreCreateRecursiveMutex();
+    }
+    MotionLock guard(*this);
     this->global_voltage = 0;
 
     pinMode(CTRL_PWM, OUTPUT);
@@ -28,9 +50,10 @@ Motion::Motion()
     : global_voltage(DEFAULT_VOLTAGE), global_duty_cycle(DEFAULT_DUTY_CYCLE),
       forward_freq(DEFAULT_FWD_FREQ), forward_phase_deg(DEFAULT_FWD_PHASE),
       backward_freq(DEFAULT_BWD_FREQ), backward_phase_deg(DEFAULT_BWD_PHASE),
-      _isDirectionReversed(false), _step_time_ms(100), _still_time_ms(100),
-      _is_step_mode_enabled(false), step_timer_handle(NULL),
-      isCurrentlyStepping(false) {}
+      _isDirectionReversed(false), _state(MOTION_IDLE), _stopEpoch(0),
+      _step_time_ms(100), _still_time_ms(100), _step_time_us(100000),
+      _still_time_us(100000), _is_step_mode_enabled(false),
+      step_timer_handle(NULL), isCurrentlyStepping(false), _lock(NULL) {}
 Motion::~Motion() {
     if (step_timer_handle != NULL) {
         esp_timer_stop(step_timer_handle);
@@ -39,6 +62,15 @@ Motion::~Motion() {
 }
 
 void Motion::stop() {
+    MotionLock guard(*this);
+    haltOutputs();
+    safePrintln("Motion stopped.");
+}
+
+// 只操作定时器和GPIO，不打印、不取锁，可在串口接收回调中调用
+void Motion::haltOutputs() {
+    _stopEpoch++; // 先记下停止，正在启动的运动看到后不再打开输出
+
     // 如果高精度定时器正在运行，则停止它
     if (step_timer_handle != NULL && esp_timer_is_active(step_timer_handle)) {
         esp_timer_stop(step_timer_handle);
@@ -48,46 +80,44 @@ void Motion::stop() {
     digitalWrite(Amp_en, LOW); // 关闭运放
     digitalWrite(4, LOW);
     isCurrentlyStepping = false; // 重置状态
-    safePrintln("Motion stopped.");
+    _state = MOTION_IDLE;
 }
 
-void Motion::moveForward() {
-    // 1. 应用高频PWM参数
-    if (_isDirectionReversed) {
-        _applyMovementParams(backward_freq, backward_phase_deg);
-    } else {
+void Motion::_applyDirectionParams(bool forward) {
+    if (forward != _isDirectionReversed) {
         _applyMovementParams(forward_freq, forward_phase_deg);
+    } else {
+        _applyMovementParams(backward_freq, backward_phase_deg);
     }
+}
+
+void Motion::moveForward() {
+    MotionLock guard(*this);
+    uint32_t epoch = _stopEpoch;
+    // 1. 应用高频PWM参数
+    _applyDirectionParams(true);
+    _state = MOTION_FORWARD;
 
     // 2. 根据模式启动运动
-    if (_is_step_mode_enabled) {
-        if (step_timer_handle == NULL)
-            return;
-        safePrintln("Starting Step Motion...");
-        digitalWrite(Amp_en, HIGH); // 持续使能运放
-        digitalWrite(4, HIGH);
-        _internal_start_mcpwm(); // 开始第一个“步进”
-        isCurrentlyStepping = true;
-        // 使用 esp_timer_start_once 启动高精度定时器
-        // 定时器周期直接使用微秒 _step_time_us
-        esp_timer_start_once(step_timer_handle, _step_time_us);
-    } else {
-        safePrintln("Starting Continuous Motion...");
-        digitalWrite(Amp_en, HIGH); // 使能运放
-        digitalWrite(4, HIGH);
-        _internal_start_mcpwm(); // 启动高频PWM
-    }
+    _startOutputs(epoch);
 }
 
 void Motion::moveBackward() {
+    MotionLock guard(*this);
+    uint32_t epoch = _stopEpoch;
     // 1. 应用高频PWM参数
-    if (_isDirectionReversed) {
-        _applyMovementParams(forward_freq, forward_phase_deg);
-    } else {
-        _applyMovementParams(backward_freq, backward_phase_deg);
-    }
+    _applyDirectionParams(false);
+    _state = MOTION_BACKWARD;
 
     // 2. 根据模式启动运动
+    _startOutputs(epoch);
+}
+
+void Motion::_startOutputs(uint32_t epoch) {
+    if (epoch != _stopEpoch) {
+        haltOutputs(); // 设置参数期间已紧急停止，_state恢复为停止
+        return;
+    }
     if (_is_step_mode_enabled) {
         if (step_timer_handle == NULL)
             return;
@@ -97,6 +127,7 @@ void Motion::moveBackward() {
         _internal_start_mcpwm(); // 开始第一个“步进”
         isCurrentlyStepping = true;
         // 使用 esp_timer_start_once 启动高精度定时器
+        // 定时器周期直接使用微秒 _step_time_us
         esp_timer_start_once(step_timer_handle, _step_time_us);
     } else {
         safePrintln("Starting Continuous Motion...");
@@ -104,6 +135,10 @@ void Motion::moveBackward() {
         digitalWrite(4, HIGH);
         _internal_start_mcpwm(); // 启动高频PWM
     }
+    // 停止发生在检查之后、输出打开之前时，输出又被打开了，再关一次
+    if (epoch != _stopEpoch) {
+        haltOutputs();
+    }
 }
 
 void Motion::_step_timer_init() {
@@ -121,8 +156,8 @@ void Motion::_step_timer_init() {
 void Motion::stepTimerCallback(void *arg) {
     // 从参数中获取Motion实例指针
     Motion *motion_ptr = (Motion *)arg;
-    if (motion_ptr == NULL)
-        return;
+    if (motion_ptr == NULL || motion_ptr->_state == MOTION_IDLE)
+        return; // 已停止：不再打开输出，也不再定时
 
     if (motion_ptr->isCurrentlyStepping) {
         // 当前是“步进”状态，现在切换到“静止”状态
@@ -143,6 +178,9 @@ void Motion::stepTimerCallback(void *arg) {
         // 使用 esp_timer_start_once 启动下一次定时
         esp_timer_start_once(motion_ptr->step_timer_handle,
                              motion_ptr->_step_time_us);
+        if (motion_ptr->_state == MOTION_IDLE) {
+            motion_ptr->haltOutputs(); // 重启输出时恰好被停止
+        }
     }
 }
 
@@ -157,58 +195,80 @@ void Motion::_internal_stop_mcpwm() {
 }
 
 // 方向切换
-void Motion::swapDirection() { _isDirectionReversed = !_isDirectionReversed; }
+void Motion::swapDirection() {
+    MotionLock guard(*this);
+    _isDirectionReversed = !_isDirectionReversed;
+}
 
 // 获取方向状态
 bool Motion::isDirectionReversed() const { return _isDirectionReversed; }
 
-// --- 参数设置函数的实现 ---
-bool Motion::setGlobalVoltage(int voltage) {
-    if (voltage < 0 || voltage > 80) {
-        return false; // 超出范围
-    }
-    this->global_voltage = voltage;
-    _applyVoltage();
-    return true;
+// --- 参数读写的实现 ---
+MotionParams Motion::getParams() const {
+    MotionLock guard(*this); // 不会读到applyParams提交了一半的参数
+    MotionParams p;
+    p.voltage = global_voltage;
+    p.dutyCycle = global_duty_cycle;
+    p.forwardFreq = forward_freq;
+    p.forwardPhase = forward_phase_deg;
+    p.backwardFreq = backward_freq;
+    p.backwardPhase = backward_phase_deg;
+    p.stepTimeMs = _step_time_ms;
+    p.stillTimeMs = _still_time_ms;
+    p.stepMode = _is_step_mode_enabled;
+    p.directionReversed = _isDirectionReversed;
+    return p;
 }
 
-bool Motion::setGlobalDutyCycle(float dutyCycle) {
-    if (dutyCycle < 0.1f || dutyCycle > 99.9f)
-        return false;
-    this->global_duty_cycle = dutyCycle;
-
-    return true;
-}
-
-bool Motion::setForwardFreq(uint32_t freq) {
-    if (freq < 100 || freq > 50000)
-        return false;
-    this->forward_freq = freq;
-
-    return true;
-}
-
-bool Motion::setForwardPhase(float phase) {
-    if (phase < 0.0f || phase > 360.0f)
-        return false;
-    this->forward_phase_deg = phase;
-
-    return true;
+static bool paramsInRange(const MotionParams &p) {
+    return p.voltage >= VOLTAGE_MIN && p.voltage <= VOLTAGE_MAX &&
+           p.dutyCycle >= DUTY_MIN && p.dutyCycle <= DUTY_MAX &&
+           p.forwardFreq >= FREQ_MIN && p.forwardFreq <= FREQ_MAX &&
+           p.forwardPhase >= PHASE_MIN && p.forwardPhase <= PHASE_MAX &&
+           p.backwardFreq >= FREQ_MIN && p.backwardFreq <= FREQ_MAX &&
+           p.backwardPhase >= PHASE_MIN && p.backwardPhase <= PHASE_MAX &&
+           p.stepTimeMs >= 0 && p.stepTimeMs <= STEP_TIME_MAX_MS &&
+           p.stillTimeMs >= 0 && p.stillTimeMs <= STEP_TIME_MAX_MS;
 }
 
-bool Motion::setBackwardFreq(uint32_t freq) {
-    if (freq < 100 || freq > 50000)
-        return false;
-    this->backward_freq = freq;
-
-    return true;
+// 毫秒换算为定时器微秒；大于0但不足1微秒时取1微秒，0表示没有该段时间
+static uint32_t timerUsFromMs(float ms) {
+    uint32_t us = (uint32_t)(ms * 1000.0f);
+    return (ms > 0 && us == 0) ? 1 : us;
 }
 
-bool Motion::setBackwardPhase(float phase) {
-    if (phase < 0.0f || phase > 360.0f)
+bool Motion::applyParams(const MotionParams &next) {
+    if (!paramsInRange(next)) {
         return false;
-    this->backward_phase_deg = phase;
-
+    }
+    // 运动任务此时不会在启动运动，_state和MCPWM的设置不会交错
+    MotionLock guard(*this);
+    bool voltageChanged = next.voltage != global_voltage;
+    bool pwmChanged = next.dutyCycle != global_duty_cycle ||
+                      next.forwardFreq != forward_freq ||
+                      next.forwardPhase != forward_phase_deg ||
+                      next.backwardFreq != backward_freq ||
+                      next.backwardPhase != backward_phase_deg;
+
+    global_voltage = next.voltage;
+    global_duty_cycle = next.dutyCycle;
+    forward_freq = next.forwardFreq;
+    forward_phase_deg = next.forwardPhase;
+    backward_freq = next.backwardFreq;
+    backward_phase_deg = next.backwardPhase;
+    // 步进定时器在下一次定时时读取新的时间
+    _step_time_ms = next.stepTimeMs;
+    _still_time_ms = next.stillTimeMs;
+    _step_time_us = timerUsFromMs(next.stepTimeMs);
+    _still_time_us = timerUsFromMs(next.stillTimeMs);
+
+    if (voltageChanged) {
+        _applyVoltage();
+    }
+    MotionState state = _state;
+    if (pwmChanged && state != MOTION_IDLE) {
+        _applyDirectionParams(state == MOTION_FORWARD);
+    }
     return true;
 }
 
@@ -284,6 +344,7 @@ void Motion::setupMCPWM() {
 }
 
 void Motion::enableStepMode(bool enable) {
+    MotionLock guard(*this);
     if (_is_step_mode_enabled == enable)
         return;
     _is_step_mode_enabled = enable;
@@ -293,48 +354,3 @@ void Motion::enableStepMode(bool enable) {
 }
 
 bool Motion::isStepModeEnabled() const { return _is_step_mode_enabled; }
-
-// ************************步进模式************************
-bool Motion::setStepTime(float step_time_ms) {
-    if (step_time_ms < 0) { // 等于0是允许的，表示没有步进时间
-        safePrintln("Error: Step time must be non-negative.");
-        return false;
-    }
-    _step_time_us = (uint32_t)(step_time_ms * 1000.0f);
-    if (step_time_ms > 0 && _step_time_us == 0) {
-        // 对于大于0但小于1微秒的输入，强制设为1微秒
-        _step_time_us = 1;
-        safePrintln("Warning: Step time is less than 1us, setting to 1us.");
-    }
-    return true;
-}
-bool Motion::setStillTime(float still_time_ms) {
-    if (still_time_ms < 0) {
-        safePrintln("Error: Still time must be non-negative.");
-        return false;
-    }
-    _still_time_us = (uint32_t)(still_time_ms * 1000.0f);
-    if (still_time_ms > 0 && _still_time_us == 0) {
-        _still_time_us = 1;
-        safePrintln("Warning: Still time is less than 1us, setting to 1us.");
-    }
-    return true;
-}
-
-String Motion::getAllParamsAsString() {
-    String params = "";
-    params += "VOLTAGE:" + String(this->global_voltage) + ";";
-    params += "DUTY:" + String(this->global_duty_cycle, 2) + ";";
-    params += "FWD_FREQ:" + String(this->forward_freq) + ";";
-    params += "FWD_PHASE:" + String(this->forward_phase_deg, 2) + ";";
-    params += "BWD_FREQ:" + String(this->backward_freq) + ";";
-    params += "BWD_PHASE:" + String(this->backward_phase_deg, 2) + ";";
-    params += "STEP_TIME_MS:" + String(this->_step_time_ms, 2) + ";";
-    params += "STILL_TIME_MS:" + String(this->_still_time_ms, 2) + ";";
-    params +=
-        "STEP_MODE_ENABLED:" + String(this->_is_step_mode_enabled ? "1" : "0") +
-        ";";
-    params +=
-        "direction_reversed:" + String(this->_isDirectionReversed ? "1" : "0");
-    return params;
-}
\ No newline at end of file
@@ -0,0 +1,158 @@
+// --- 文件名: src/address_filter.cpp ---
+
+#include "address_filter.h"
+#include "binary_frame.h"
+#include "frame_parser.h"
+#include "lora_config.h"
+
+AddressFilter::AddressFilter()
+    : selfHash(0), selfLen(0), selfNum(BIN_ID_BROADCAST), groupHash(),
+      groups(0) {}
+
+void AddressFilter::setSelf(const char *name, size_t len, uint8_t num) {
+    selfHash = fnv1aHash(name, len);
+    selfLen = len;
+    selfNum = num;
+}
+
+bool AddressFilter::setGroups(const char *csv, size_t len) {
+    uint32_t hashes[ADDR_GROUP_MAX];
+    uint8_t count = 0;
+    size_t start = 0;
+    for (size_t i = 0; i <= len; i++) {
+        if (i < len && csv[i] != ADDR_GROUP_SEPARATOR) {
+            continue;
+        }
+        size_t nameLen = i - start;
+        if (nameLen > ADDR_GROUP_NAME_MAX) {
+            return false;
+        }
+        if (nameLen > 0) {
+            if (count >= ADDR_GROUP_MAX) {
+                return false;
+            }
+            hashes[count++] = fnv1aHash(csv + start, nameLen);
+        }
+        start = i + 1;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        groupHash[i] = hashes[i];
+    }
+    groups = count;
+    return true;
+}
+
+// 读一个十进制数，返回读到的位数
+static size_t readNumber(const char *s, size_t len, uint32_t &value) {
+    size_t i = 0;
+    value = 0;
+    while (i < len && s[i] >= '0' && s[i] <= '9') {
+        if (value < 1000) {
+            value = value * 10 + (s[i] - '0');
+        }
+        i++;
+    }
+    return i;
+}
+
+bool AddressFilter::inRanges(const char *list, size_t len) const {
+    size_t i = 0;
+    while (i < len) {
+        uint32_t lo, hi;
+        size_t n = readNumber(list + i, len - i, lo);
+        if (n == 0) {
+            return false;
+        }
+        i += n;
+        hi = lo;
+        if (i < len && list[i] == '-') {
+            n = readNumber(list + i + 1, len - i - 1, hi);
+            if (n == 0) {
+                return false;
+            }
+            i += n + 1;
+        }
+        if (selfNum >= lo && selfNum <= hi) {
+            return true;
+        }
+        if (i < len && list[i] != ADDR_GROUP_SEPARATOR) {
+            return false;
+        }
+        i++;
+    }
+    return false;
+}
+
+bool AddressFilter::inMask(const char *hex, size_t len) const {
+    size_t digit = selfNum / 4;
+    if (digit >= len) {
+        return false;
+    }
+    char c = hex[len - 1 - digit]; // 最后一个十六进制位对应设备号0-3
+    uint8_t v;
+    if (c >= '0' && c <= '9') {
+        v = c - '0';
+    } else if (c >= 'A' && c <= 'F') {
+        v = c - 'A' + 10;
+    } else if (c >= 'a' && c <= 'f') {
+        v = c - 'a' + 10;
+    } else {
+        return false;
+    }
+    return (v >> (selfNum % 4)) & 1;
+}
+
+AddressMatch AddressFilter::match(const char *receiver, size_t len) const {
+    if (len == 0) {
+        return ADDR_OTHER;
+    }
+    bool member;
+    switch (receiver[0]) {
+    case ADDR_GROUP_PREFIX: {
+        uint32_t h = fnv1aHash(receiver + 1, len - 1);
+        member = false;
+        for (uint8_t i = 0; i < groups && !member; i++) {
+            member = groupHash[i] == h;
+        }
+        break;
+    }
+    case ADDR_RANGE_PREFIX:
+        member = inRanges(receiver + 1, len - 1);
+        break;
+    case ADDR_MASK_PREFIX:
+        member = inMask(receiver + 1, len - 1);
+        break;
+    default:
+        if (len == 3 && memcmp(receiver, "ALL", 3) == 0) {
+            return ADDR_GROUP_MEMBER;
+        }
+        return (len == selfLen && fnv1aHash(receiver, len) == selfHash)
+                   ? ADDR_SELF
+                   : ADDR_OTHER;
+    }
+    return member ? ADDR_GROUP_MEMBER : ADDR_GROUP_OTHER;
+}
+
+static_assert(BIN_ID_BROADCAST == LORA_ADDR_BROADCAST,
+              "Fixed-mode broadcast must match the binary broadcast ID");
+
+uint8_t fixedModeAddress(const char *frame, size_t len) {
+    StrView rest = {frame, len};
+    StrView receiver, sender;
+    if (len == 0 || (uint8_t)frame[0] == BIN_FRAME_SYNC ||
+        !nextToken(rest, ':', receiver) || !nextToken(rest, ':', sender) ||
+        receiver.empty()) {
+        return LORA_ADDR_BROADCAST;
+    }
+    SenderOptions options;
+    if (parseSenderOptions(sender, options) && options.has(SENDER_OPT_TTL)) {
+        return LORA_ADDR_BROADCAST; // 中继要能听到
+    }
+    char first = receiver.data[0];
+    if (first == ADDR_GROUP_PREFIX || first == ADDR_RANGE_PREFIX ||
+        first == ADDR_MASK_PREFIX) {
+        return LORA_ADDR_BROADCAST;
+    }
+    // ALL和不含设备号的名字也映射为BIN_ID_BROADCAST，与LORA_ADDR_BROADCAST相同
+    return binaryIdFromName(receiver.data, receiver.len);
+}
@@ -0,0 +1,604 @@
+// --- 文件名: src/binary_frame.cpp ---
+
+#include "binary_frame.h"
+#include "Command.h"
+#include "param_registry.h"
+#include <stdlib.h>
+#include <string.h>
+
+// --- 操作码表 ---
+
+struct OpcodeEntry {
+    uint8_t opcode;
+    const char *commandName;
+    BinaryArgKind args;
+};
+
+static const OpcodeEntry opcodeTable[] = {
+    {BIN_OP_FORWARD, Forward, BIN_ARGS_NONE},
+    {BIN_OP_BACKWARD, Backward, BIN_ARGS_NONE},
+    {BIN_OP_STOP, STOP, BIN_ARGS_NONE},
+    {BIN_OP_OTA_ENABLE, OTA_ENABLE, BIN_ARGS_NONE},
+    {BIN_OP_OTA_DISABLE, OTA_DISABLE, BIN_ARGS_NONE},
+    {BIN_OP_SWAP_DIRECTION, SWAP_DIRECTION, BIN_ARGS_NONE},
+    {BIN_OP_STEP_MODE, ENABLE_STEP_MODE, BIN_ARGS_VALUE},
+    {BIN_OP_SET_BATCH_PARAMS, SET_BATCH_PARAMS, BIN_ARGS_PARAM_LIST},
+    {BIN_OP_REPORT_ALL_PARAMS, REPORT_ALL_PARAMS, BIN_ARGS_PARAM_LIST},
+    {BIN_OP_GET_PARAM, GET_PARAM, BIN_ARGS_PARAM_ID},
+    {BIN_OP_PARAM_SCHEMA, PARAM_SCHEMA, BIN_ARGS_VALUE},
+    {BIN_OP_PARAM_DELTA, PARAM_DELTA, BIN_ARGS_VERSION},
+    {BIN_OP_LINK_STATS, LINK_STATS, BIN_ARGS_PAGE}};
+
+// LINK_STATS 的页名，下标即线上的页号，只能在末尾追加
+static const char *const linkStatsPages[] = {"TX", "AUX", "NET"};
+
+#define LINK_STATS_PAGE_COUNT                                                  \
+    (sizeof(linkStatsPages) / sizeof(linkStatsPages[0]))
+
+static const OpcodeEntry *findOpcode(uint8_t opcode) {
+    for (const auto &entry : opcodeTable) {
+        if (entry.opcode == opcode) {
+            return &entry;
+        }
+    }
+    return NULL;
+}
+
+// 每种参数形式最多携带的参数个数
+static uint8_t maxParams(BinaryArgKind kind) {
+    switch (kind) {
+    case BIN_ARGS_NONE:
+        return 0;
+    case BIN_ARGS_VERSION:
+        return 2;
+    case BIN_ARGS_PARAM_LIST:
+        return BIN_MAX_PARAMS;
+    default:
+        return 1;
+    }
+}
+
+static bool hasParamIds(BinaryArgKind kind) {
+    return kind == BIN_ARGS_PARAM_LIST || kind == BIN_ARGS_PARAM_ID;
+}
+
+static bool hasValues(BinaryArgKind kind) {
+    return kind != BIN_ARGS_NONE && kind != BIN_ARGS_PARAM_ID;
+}
+
+// 浮点参数放大100倍传输，其余原样
+static BinaryParamScale paramScale(const ParamDescriptor &param) {
+    return param.type == PARAM_FLOAT ? BIN_PARAM_SCALE_CENTI
+                                     : BIN_PARAM_SCALE_UNIT;
+}
+
+const char *binaryOpcodeName(uint8_t opcode) {
+    const OpcodeEntry *entry = findOpcode(opcode);
+    return entry ? entry->commandName : NULL;
+}
+
+bool binaryOpcodeFromName(const char *command, uint8_t &opcode) {
+    for (const auto &entry : opcodeTable) {
+        if (strcmp(command, entry.commandName) == 0) {
+            opcode = entry.opcode;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *binaryParamName(uint8_t id) {
+    const ParamDescriptor *param = paramFindById(id);
+    return param ? param->name : NULL;
+}
+
+bool binaryParamFromName(const char *name, size_t len, uint8_t &id) {
+    const ParamDescriptor *param = paramFind(name, len);
+    if (param == NULL) {
+        return false;
+    }
+    id = param->id;
+    return true;
+}
+
+uint8_t binaryIdFromName(const char *name) {
+    return binaryIdFromName(name, strlen(name));
+}
+
+uint8_t binaryIdFromName(const char *name, size_t len) {
+    if (len == 4 && memcmp(name, "HOST", 4) == 0) {
+        return BIN_ID_HOST;
+    }
+    if (len == 3 && memcmp(name, "ALL", 3) == 0) {
+        return BIN_ID_BROADCAST;
+    }
+    // 取名字末尾的连续数字，例如 SR_01 -> 1
+    size_t start = len;
+    while (start > 0 && name[start - 1] >= '0' && name[start - 1] <= '9') {
+        start--;
+    }
+    if (start == len) {
+        return BIN_ID_BROADCAST;
+    }
+    uint32_t num = 0;
+    for (size_t i = start; i < len && num < BIN_ID_BROADCAST; i++) {
+        num = num * 10 + (name[i] - '0');
+    }
+    if (num <= BIN_ID_HOST || num >= BIN_ID_BROADCAST) {
+        return BIN_ID_BROADCAST;
+    }
+    return (uint8_t)num;
+}
+
+// --- CRC / varint / COBS ---
+
+uint16_t binaryCrc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021)
+                                 : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static bool putVarint(uint8_t *buf, size_t cap, size_t &pos, uint32_t v) {
+    do {
+        if (pos >= cap) {
+            return false;
+        }
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        buf[pos++] = v ? (b | 0x80) : b;
+    } while (v);
+    return true;
+}
+
+static bool getVarint(const uint8_t *buf, size_t len, size_t &pos,
+                      uint32_t &v) {
+    v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= len) {
+            return false;
+        }
+        uint8_t b = buf[pos++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false; // 超过5字节，非法
+}
+
+static uint32_t zigzagEncode(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t zigzagDecode(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// COBS编码：输出不含0x00，返回写入字节数，空间不足返回0
+static size_t cobsEncode(const uint8_t *in, size_t len, uint8_t *out,
+                         size_t cap) {
+    size_t codePos = 0;
+    size_t outPos = 1;
+    uint8_t code = 1;
+    if (cap == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[codePos] = code;
+            codePos = outPos++;
+            code = 1;
+        } else {
+            if (outPos >= cap) {
+                return 0;
+            }
+            out[outPos++] = in[i];
+            code++;
+            if (code == 0xFF) {
+                out[codePos] = code;
+                codePos = outPos++;
+                code = 1;
+            }
+        }
+        if (outPos > cap) {
+            return 0;
+        }
+    }
+    out[codePos] = code;
+    return outPos;
+}
+
+static size_t cobsDecode(const uint8_t *in, size_t len, uint8_t *out,
+                         size_t cap) {
+    size_t inPos = 0;
+    size_t outPos = 0;
+    while (inPos < len) {
+        uint8_t code = in[inPos++];
+        if (code == 0) {
+            return 0;
+        }
+        for (uint8_t i = 1; i < code; i++) {
+            if (inPos >= len || outPos >= cap || in[inPos] == 0) {
+                return 0;
+            }
+            out[outPos++] = in[inPos++];
+        }
+        if (code != 0xFF && inPos < len) {
+            if (outPos >= cap) {
+                return 0;
+            }
+            out[outPos++] = 0;
+        }
+    }
+    return outPos;
+}
+
+// --- 帧编解码 ---
+
+size_t encodeBinaryFrame(const BinaryFrame &frame, uint8_t *out, size_t cap) {
+    const OpcodeEntry *op = findOpcode(frame.opcode);
+    if (op == NULL || frame.paramCount > BIN_MAX_PARAMS) {
+        return 0;
+    }
+
+    uint8_t body[BIN_MAX_BODY_LEN];
+    size_t pos = 0;
+    body[pos++] = frame.receiver;
+    body[pos++] = frame.sender;
+    body[pos++] = frame.opcode;
+
+    if (frame.paramCount > maxParams(op->args)) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < frame.paramCount; i++) {
+        if (hasParamIds(op->args) &&
+            !putVarint(body, sizeof(body) - 2, pos, frame.params[i].id)) {
+            return 0;
+        }
+        if (hasValues(op->args) &&
+            !putVarint(body, sizeof(body) - 2, pos,
+                       zigzagEncode(frame.params[i].value))) {
+            return 0;
+        }
+    }
+
+    uint16_t crc = binaryCrc16(body, pos);
+    body[pos++] = crc >> 8;
+    body[pos++] = crc & 0xFF;
+
+    if (cap < 3) {
+        return 0;
+    }
+    out[0] = BIN_FRAME_SYNC;
+    size_t n = cobsEncode(body, pos, out + 1, cap - 2);
+    if (n == 0) {
+        return 0;
+    }
+    out[1 + n] = BIN_FRAME_DELIMITER;
+    return n + 2;
+}
+
+bool decodeBinaryFrame(const uint8_t *wire, size_t len, BinaryFrame &out) {
+    uint8_t body[BIN_MAX_BODY_LEN];
+    size_t n = cobsDecode(wire, len, body, sizeof(body));
+    if (n < 5) { // 三个头字节 + CRC
+        return false;
+    }
+    uint16_t crc = ((uint16_t)body[n - 2] << 8) | body[n - 1];
+    if (binaryCrc16(body, n - 2) != crc) {
+        return false;
+    }
+
+    out.receiver = body[0];
+    out.sender = body[1];
+    out.opcode = body[2];
+    out.paramCount = 0;
+
+    const OpcodeEntry *op = findOpcode(out.opcode);
+    if (op == NULL) {
+        return false;
+    }
+
+    size_t pos = 3;
+    size_t end = n - 2;
+    while (pos < end) {
+        if (out.paramCount >= maxParams(op->args)) {
+            return false;
+        }
+        BinaryParam &param = out.params[out.paramCount++];
+        uint32_t id = 0;
+        uint32_t raw = 0;
+        // 参数ID必须在注册表中，否则整帧无效
+        if (hasParamIds(op->args) &&
+            (!getVarint(body, end, pos, id) || id > 0xFF ||
+             paramFindById((uint8_t)id) == NULL)) {
+            return false;
+        }
+        if (hasValues(op->args) && !getVarint(body, end, pos, raw)) {
+            return false;
+        }
+        param.id = (uint8_t)id;
+        param.value = zigzagDecode(raw);
+    }
+    // 版本查询要么为空，要么纪元和版本都有
+    return op->args != BIN_ARGS_VERSION || out.paramCount != 1;
+}
+
+// --- 与文本PAYLOAD互转 ---
+
+// 解析 "12.5" 这类十进制文本为放大后的整数，不依赖printf/scanf浮点支持
+static bool parseScaled(const char *s, size_t len, BinaryParamScale scale,
+                        int32_t &value) {
+    char buf[24];
+    if (len == 0 || len >= sizeof(buf)) {
+        return false;
+    }
+    memcpy(buf, s, len);
+    buf[len] = '\0';
+    char *endptr;
+    double v = strtod(buf, &endptr);
+    if (*endptr != '\0') {
+        return false;
+    }
+    v *= (int)scale;
+    value = (int32_t)(v < 0 ? v - 0.5 : v + 0.5);
+    return true;
+}
+
+// 输出放大后的整数为十进制文本，返回写入字符数，空间不足返回0
+static size_t formatScaled(int32_t value, BinaryParamScale scale, char *out,
+                           size_t cap) {
+    char tmp[16];
+    size_t n = 0;
+    bool negative = value < 0;
+    uint32_t mag = negative ? (uint32_t)(-(int64_t)value) : (uint32_t)value;
+    int decimals = (scale == BIN_PARAM_SCALE_CENTI) ? 2 : 0;
+    do {
+        tmp[n++] = '0' + mag % 10;
+        mag /= 10;
+        if (decimals > 0 && n == (size_t)decimals) {
+            tmp[n++] = '.';
+            if (mag == 0) {
+                tmp[n++] = '0';
+            }
+        }
+    } while (mag > 0 || n <= (size_t)decimals);
+    if (negative) {
+        tmp[n++] = '-';
+    }
+    if (n > cap) {
+        return 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        out[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+// 解析十进制或十六进制无符号整数，整段都必须是数字
+static bool parseUnsigned(const char *s, size_t len, int base,
+                          uint32_t &value) {
+    char buf[12];
+    if (len == 0 || len >= sizeof(buf)) {
+        return false;
+    }
+    memcpy(buf, s, len);
+    buf[len] = '\0';
+    char *endptr;
+    value = (uint32_t)strtoul(buf, &endptr, base);
+    return *endptr == '\0';
+}
+
+// 输出无符号整数，width>0时用十六进制大写并补齐到width位
+static size_t formatUnsigned(uint32_t value, int width, char *out,
+                             size_t cap) {
+    static const char digits[] = "0123456789ABCDEF";
+    char tmp[12];
+    size_t n = 0;
+    uint32_t base = width > 0 ? 16 : 10;
+    do {
+        tmp[n++] = digits[value % base];
+        value /= base;
+    } while (value > 0 || n < (size_t)width);
+    if (n > cap) {
+        return 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        out[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+static bool paramListFromText(const char *args, BinaryFrame &frame) {
+    const char *p = args;
+    while (*p != '\0') {
+        const char *pairEnd = strchr(p, ';');
+        size_t pairLen = pairEnd ? (size_t)(pairEnd - p) : strlen(p);
+        if (pairLen > 0) {
+            const char *sep = (const char *)memchr(p, ':', pairLen);
+            const ParamDescriptor *param =
+                sep ? paramFind(p, sep - p) : NULL;
+            if (param == NULL || frame.paramCount >= BIN_MAX_PARAMS) {
+                return false;
+            }
+            BinaryParam &out = frame.params[frame.paramCount++];
+            out.id = param->id;
+            if (!parseScaled(sep + 1, pairLen - (sep + 1 - p),
+                             paramScale(*param), out.value)) {
+                return false;
+            }
+        }
+        p += pairLen;
+        if (*p == ';') {
+            p++;
+        }
+    }
+    return true;
+}
+
+bool binaryArgsFromText(uint8_t opcode, const char *args, BinaryFrame &frame) {
+    const OpcodeEntry *op = findOpcode(opcode);
+    frame.opcode = opcode;
+    frame.paramCount = 0;
+    if (op == NULL) {
+        return false;
+    }
+    size_t len = strlen(args);
+    if (op->args == BIN_ARGS_NONE) {
+        return true;
+    }
+    if (op->args == BIN_ARGS_PARAM_LIST) {
+        return paramListFromText(args, frame);
+    }
+    if (op->args == BIN_ARGS_PARAM_ID) {
+        const ParamDescriptor *param = paramFind(args, len);
+        frame.paramCount = 1;
+        frame.params[0].id = param ? param->id : 0;
+        frame.params[0].value = 0;
+        return param != NULL;
+    }
+    if (len == 0) {
+        return true; // 其余形式都允许空负载
+    }
+
+    BinaryParam &first = frame.params[frame.paramCount++];
+    first.id = 0;
+    if (op->args == BIN_ARGS_VALUE) {
+        return parseScaled(args, len, BIN_PARAM_SCALE_UNIT, first.value);
+    }
+    if (op->args == BIN_ARGS_PAGE) {
+        for (size_t i = 0; i < LINK_STATS_PAGE_COUNT; i++) {
+            if (strcmp(args, linkStatsPages[i]) == 0) {
+                first.value = (int32_t)i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // BIN_ARGS_VERSION：<纪元(十六进制)>,<版本>
+    const char *comma = strchr(args, ',');
+    uint32_t epoch;
+    uint32_t version;
+    if (comma == NULL || !parseUnsigned(args, comma - args, 16, epoch) ||
+        !parseUnsigned(comma + 1, strlen(comma + 1), 10, version)) {
+        return false;
+    }
+    BinaryParam &second = frame.params[frame.paramCount++];
+    first.value = (int32_t)epoch;
+    second.id = 0;
+    second.value = (int32_t)version;
+    return true;
+}
+
+// 逐个参数输出 NAME:VALUE;...，返回写入字符数，失败返回0
+static size_t paramListToText(const BinaryFrame &frame, char *out,
+                              size_t cap) {
+    size_t pos = 0;
+    for (uint8_t i = 0; i < frame.paramCount; i++) {
+        const ParamDescriptor *param = paramFindById(frame.params[i].id);
+        if (param == NULL) {
+            return 0;
+        }
+        size_t nameLen = strlen(param->name);
+        // 名字 + ':' + 至少一位数字 + ';' + '\0'
+        if (pos + nameLen + 4 > cap) {
+            return 0;
+        }
+        if (i > 0) {
+            out[pos++] = ';';
+        }
+        memcpy(out + pos, param->name, nameLen);
+        pos += nameLen;
+        out[pos++] = ':';
+        size_t n = formatScaled(frame.params[i].value, paramScale(*param),
+                                out + pos, cap - pos - 1);
+        if (n == 0) {
+            return 0;
+        }
+        pos += n;
+    }
+    return pos;
+}
+
+// 按参数形式输出PAYLOAD，cap不含'\0'，返回写入字符数；失败时ok置为false
+static size_t argsToText(const OpcodeEntry &op, const BinaryFrame &frame,
+                         char *out, size_t cap, bool &ok) {
+    const BinaryParam *params = frame.params;
+    ok = true;
+    if (frame.paramCount == 0) {
+        // 参数ID形式不能为空，其余形式空负载都合法
+        ok = op.args != BIN_ARGS_PARAM_ID;
+        return 0;
+    }
+    size_t n = 0;
+    switch (op.args) {
+    case BIN_ARGS_VALUE:
+        n = formatScaled(params[0].value, BIN_PARAM_SCALE_UNIT, out, cap);
+        break;
+    case BIN_ARGS_PARAM_LIST:
+        // paramListToText 自己预留'\0'
+        n = paramListToText(frame, out, cap + 1);
+        break;
+    case BIN_ARGS_PARAM_ID: {
+        const char *name = binaryParamName(params[0].id);
+        n = name ? strlen(name) : 0;
+        if (n > cap) {
+            n = 0;
+        } else if (n > 0) {
+            memcpy(out, name, n);
+        }
+        break;
+    }
+    case BIN_ARGS_PAGE:
+        if ((uint32_t)params[0].value < LINK_STATS_PAGE_COUNT) {
+            const char *page = linkStatsPages[params[0].value];
+            n = strlen(page);
+            if (n <= cap) {
+                memcpy(out, page, n);
+            } else {
+                n = 0;
+            }
+        }
+        break;
+    case BIN_ARGS_VERSION:
+        // 纪元为4位十六进制，与 PARAM_DELTA 的回复一致
+        n = frame.paramCount == 2
+                ? formatUnsigned((uint32_t)params[0].value, 4, out, cap)
+                : 0;
+        if (n > 0 && n < cap) {
+            out[n++] = ',';
+            size_t m =
+                formatUnsigned((uint32_t)params[1].value, 0, out + n, cap - n);
+            n = m ? n + m : 0;
+        } else {
+            n = 0;
+        }
+        break;
+    default:
+        break; // BIN_ARGS_NONE 却带参数
+    }
+    ok = n > 0;
+    return n;
+}
+
+bool binaryArgsToText(const BinaryFrame &frame, char *out, size_t cap) {
+    if (cap == 0) {
+        return false;
+    }
+    out[0] = '\0';
+    const OpcodeEntry *op = findOpcode(frame.opcode);
+    if (op == NULL || frame.paramCount > maxParams(op->args)) {
+        return false;
+    }
+    bool ok;
+    size_t n = argsToText(*op, frame, out, cap - 1, ok);
+    out[ok ? n : 0] = '\0';
+    return ok;
+}
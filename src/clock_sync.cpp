@@ -0,0 +1,44 @@
+// --- 文件名: src/clock_sync.cpp ---
+
+#include "clock_sync.h"
+
+ClockSync::ClockSync()
+    : refHost(0), refLocal(0), drift(0), lastError(0), beacons(0) {}
+
+void ClockSync::onBeacon(uint64_t hostUs, int64_t localUs) {
+    if (beacons > 0) {
+        int64_t localSpan = localUs - refLocal;
+        lastError = (int32_t)((int64_t)(hostUs - localToHost(localUs)));
+        if (localSpan >= CLOCK_DRIFT_MIN_SPAN_US) {
+            int64_t hostSpan = (int64_t)(hostUs - refHost);
+            int64_t measured =
+                (hostSpan - localSpan) * 1000000000LL / localSpan;
+            if (measured > -CLOCK_DRIFT_MAX_PPB &&
+                measured < CLOCK_DRIFT_MAX_PPB) {
+                // 指数平滑，抑制单个信标的接收延迟抖动
+                drift = beacons == 1 ? (int32_t)measured
+                                     : (int32_t)((3LL * drift + measured) / 4);
+            }
+        }
+    }
+    refHost = hostUs;
+    refLocal = localUs;
+    beacons++;
+}
+
+uint64_t ClockSync::localToHost(int64_t localUs) const {
+    int64_t dt = localUs - refLocal;
+    return refHost + dt + dt * drift / 1000000000LL;
+}
+
+int64_t ClockSync::hostToLocal(uint64_t hostUs) const {
+    int64_t dt = (int64_t)(hostUs - refHost);
+    return refLocal + dt - dt * drift / 1000000000LL;
+}
+
+int64_t ClockSync::hostLowToLocal(uint32_t hostUsLow,
+                                  int64_t nowLocalUs) const {
+    uint64_t nowHost = localToHost(nowLocalUs);
+    int32_t ahead = (int32_t)(hostUsLow - (uint32_t)nowHost);
+    return hostToLocal(nowHost + ahead);
+}
@@ -4,176 +4,570 @@
 
 // 包含所有命令具体实现所需要的模块
 #include "Command.h"
-#include "LED_Status.h"
 #include "LORA.h"
+#include "address_filter.h"
+#include "espnow_radio.h"
 #include "Motion.h"
+#include "motion_queue.h"
+#include "frame_parser.h"
+#include "param_registry.h"
+#include "param_store.h"
+#include "perfect_hash.h"
+#include "relay.h"
+#include "reply_channel.h"
+#include "reply_slot.h"
+#include "scheduled_command.h"
 #include <WiFi.h>
+#include <cstdio>
 #include <cstdlib>
 
 /**
- * @brief 安全地将String转换为long
+ * @brief 安全地将C字符串转换为long
  * @param s 输入字符串
  * @param result 输出转换后的long值
  * @return bool 转换是否成功
  */
-static bool parseStringToInt(const String &s, long &result) {
+static bool parseStringToInt(const char *s, long &result) {
     char *endptr;
     // 使用 strtol，它比 .toInt() 更健壮
-    result = strtol(s.c_str(), &endptr, 10);
+    result = strtol(s, &endptr, 10);
     // 如果 endptr 指向字符串末尾的'\0'，说明整个字符串都是有效的数字
-    return (*endptr == '\0');
+    return (*s != '\0' && *endptr == '\0');
 }
 
 /**
- * @brief 安全地将String转换为float
- * @param s 输入字符串
- * @param result 输出转换后的float值
- * @return bool 转换是否成功
+ * @brief 回复 ACK:<payload>；流水线执行期间不回复，见 reliable_link.h
  */
-static bool parseStringToFloat(const String &s, float &result) {
-    char *endptr;
-    // 使用 strtof，它比 .toFloat() 更健壮
-    result = strtof(s.c_str(), &endptr);
-    return (*endptr == '\0');
+static void sendAck(const CommandContext &ctx, const String &payload) {
+    if (!ctx.ack) {
+        return;
+    }
+    String response =
+        hostID + ":" + deviceID + ":" + ACK + ":" + payload + "\n";
+    sendReply(ctx.reply, response, LORA_TX_HIGH);
 }
 
 // --- 1. 定义所有命令的具体处理函数 ---
 
-static void handle_Forward(const String &args) {
-    ledStatus.setStatus(LED_MOTION_ACTIVE);
-    motion.moveForward();
+// 运动命令只放入运动队列，由运动任务执行，见 motion_queue.h
+// 截止时刻从收到命令的时刻ctx.rxUs算起
+static bool queueMotion(MotionOp op, const CommandContext &ctx) {
+    if (!motionQueuePush(op, ctx.rxUs, ctx.maxAgeMs)) {
+        safePrintln("Motion queue full, command dropped.");
+        return false;
+    }
+    return true;
 }
 
-static void handle_Backward(const String &args) {
-    ledStatus.setStatus(LED_MOTION_ACTIVE);
-    motion.moveBackward();
+static bool handle_Forward(const char *args, const CommandContext &ctx) {
+    return queueMotion(MOTION_OP_FORWARD, ctx);
 }
 
-static void handle_Stop(const String &args) {
-    ledStatus.setStatus(LED_STANDBY);
-    motion.stop();
+static bool handle_Backward(const char *args, const CommandContext &ctx) {
+    return queueMotion(MOTION_OP_BACKWARD, ctx);
 }
 
-static void handle_OtaEnable(const String &args) {
+static bool handle_Stop(const char *args, const CommandContext &ctx) {
+    return queueMotion(MOTION_OP_STOP, ctx);
+}
+
+static bool handle_OtaEnable(const char *args, const CommandContext &ctx) {
     xEventGroupSetBits(xOtaEventGroup, OTA_START_BIT);
+    return true;
 }
 
-static void handle_OtaDisable(const String &args) {
+static bool handle_OtaDisable(const char *args, const CommandContext &ctx) {
     xEventGroupSetBits(xOtaEventGroup, OTA_STOP_BIT);
+    return true;
 }
 
-static void processSingleParam(const String &paramPair) {
-    int separatorIndex = paramPair.indexOf(':');
-    if (separatorIndex == -1) {
-        safePrintln("Invalid batch param format: " + paramPair);
-        return;
-    }
-
-    String paramName = paramPair.substring(0, separatorIndex);
-    String paramValueStr = paramPair.substring(separatorIndex + 1);
+// 仅用于出错日志：把视图拷贝成String
+static String viewToString(const StrView &v) {
+    String s;
+    s.concat(v.data, v.len);
+    return s;
+}
 
-    // --- 这里是您原来 handle_SetParams 中的核心判断逻辑，可以直接复用 ---
-    bool success = false;
-    long intValue;
-    float floatValue;
+// 先把整批参数暂存进快照副本并逐条检查，全部通过才一次提交给Motion，
+// 否则整批不生效；ACK按出现顺序给出每个参数的结果码，见 param_registry.h
+static bool handle_SetBatchParams(const char *args, const CommandContext &ctx) {
+    StrView rest = {args, strlen(args)};
+    StrView paramPair;
 
-    if (paramName == "VOLTAGE") {
-        if (parseStringToInt(paramValueStr, intValue)) {
-            success = motion.setGlobalVoltage((int)intValue);
-        }
-    } else if (paramName == "DUTY") {
-        if (parseStringToFloat(paramValueStr, floatValue)) {
-            success = motion.setGlobalDutyCycle(floatValue);
-        }
-    } else if (paramName == "FWD_FREQ") {
-        if (parseStringToInt(paramValueStr, intValue)) {
-            success = motion.setForwardFreq((uint32_t)intValue);
+    ParamBatch batch;
+    paramBatchBegin(batch, motion.getParams());
+    while (nextToken(rest, ';', paramPair)) {
+        if (paramPair.len == 0) {
+            continue;
         }
-    } else if (paramName == "FWD_PHASE") {
-        if (parseStringToFloat(paramValueStr, floatValue)) {
-            success = motion.setForwardPhase(floatValue);
+        ParamResult result =
+            paramBatchStage(batch, paramPair.data, paramPair.len);
+        if (result != PARAM_OK) {
+            safePrintln("Rejected batch param '" + viewToString(paramPair) +
+                        "', code " + String((char)result));
         }
-    } else if (paramName == "BWD_FREQ") {
-        if (parseStringToInt(paramValueStr, intValue)) {
-            success = motion.setBackwardFreq((uint32_t)intValue);
-        }
-    } else if (paramName == "BWD_PHASE") {
-        if (parseStringToFloat(paramValueStr, floatValue)) {
-            success = motion.setBackwardPhase(floatValue);
-        }
-    } else if (paramName == "STEP_TIME_MS") {
-        if (parseStringToFloat(paramValueStr, floatValue)) {
-            success = motion.setStepTime(floatValue);
-        }
-    } else if (paramName == "STILL_TIME_MS") {
-        if (parseStringToFloat(paramValueStr, floatValue)) {
-            success = motion.setStillTime(floatValue);
-        }
-    } else {
-        safePrintln("Unknown parameter name in batch: " + paramName);
-        success = false;
     }
 
-    if (!success) {
-        safePrintln("Failed to set param in batch '" + paramName +
-                    "'. Value '" + paramValueStr + "' may be invalid.");
+    bool committed = batch.valid && motion.applyParams(batch.shadow);
+    if (!committed) {
+        safePrintln("Batch not applied, parameters unchanged.");
     }
+    sendAck(ctx,
+            String(committed ? "BATCH_OK:" : "BATCH_FAIL:") + batch.results);
+    return committed;
 }
 
-static void handle_SetBatchParams(const String &args) {
-    String currentArgs = args;
-    int separatorIndex;
+static bool handle_GetParam(const char *args, const CommandContext &ctx) {
+    const ParamDescriptor *param = paramFind(args, strlen(args));
+    if (param == NULL) {
+        safePrintln("Unknown parameter for GET_PARAM: " + String(args));
+        return false;
+    }
+    char value[PARAM_VALUE_MAX_LEN];
+    paramFormatValue(*param, param->get(motion.getParams()), value,
+                     sizeof(value));
+    String response = hostID + ":" + deviceID + ":" + GET_PARAM + ":" +
+                      param->name + ":" + value + "\n";
+    sendReply(ctx.reply, response);
+    return true;
+}
 
-    // 循环处理由分号分隔的每个参数对
-    while ((separatorIndex = currentArgs.indexOf(';')) != -1) {
-        String paramPair = currentArgs.substring(0, separatorIndex);
-        processSingleParam(paramPair); // 调用一个辅助函数来处理单个参数
-        currentArgs = currentArgs.substring(separatorIndex + 1);
+static bool handle_ReportAllParams(const char *args,
+                                   const CommandContext &ctx) {
+    char params[PARAM_REPORT_MAX + 1];
+    if (paramFormatAll(motion.getParams(), params, sizeof(params)) == 0) {
+        safePrintln("Parameter report exceeds PARAM_REPORT_MAX.");
+        return false;
     }
-    // 处理最后一个参数对（或者如果只有一个参数对的情况）
-    if (currentArgs.length() > 0) {
-        processSingleParam(currentArgs);
+    String response = hostID + ":" + deviceID + ":" + REPORT_ALL_PARAMS + ":" +
+                      params + "\n";
+    sendReply(ctx.reply, response, LORA_TX_LOW);
+    return true;
+}
+
+// 参数说明分页下载，payload为起始序号，空表示从0开始
+static bool handle_ParamSchema(const char *args, const CommandContext &ctx) {
+    long first = 0;
+    if (args[0] != '\0' &&
+        (!parseStringToInt(args, first) || first < 0 ||
+         (size_t)first > paramCount())) {
+        safePrintln("Invalid payload for PARAM_SCHEMA: " + String(args));
+        return false;
     }
+    char page[PARAM_SCHEMA_PAGE_MAX + 1];
+    paramFormatSchema((size_t)first, page, sizeof(page));
+    String response =
+        hostID + ":" + deviceID + ":" + PARAM_SCHEMA + ":" + page + "\n";
+    sendReply(ctx.reply, response, LORA_TX_LOW);
+    return true;
+}
 
-    // 所有参数处理完毕后，发送一个总的ACK
-    String ackPayload = "BATCH_OK";
+// 回复上位机已知版本之后变化的参数，payload: <纪元>,<版本>，空表示全部
+static bool handle_ParamDelta(const char *args, const CommandContext &ctx) {
+    unsigned long epoch = 0;
+    unsigned long since = 0;
+    if (args[0] != '\0') {
+        char *end;
+        epoch = strtoul(args, &end, 16);
+        bool ok = *end == ',';
+        if (ok) {
+            const char *version = end + 1;
+            since = strtoul(version, &end, 10);
+            ok = *version != '\0' && *end == '\0';
+        }
+        if (!ok) {
+            safePrintln("Invalid payload for PARAM_DELTA: " + String(args));
+            return false;
+        }
+    }
+    paramStore.update(motion.getParams());
+    char delta[PARAM_DELTA_MAX + 1];
+    paramStore.formatSince((uint16_t)epoch, since, delta, sizeof(delta));
     String response =
-        hostID + ":" + deviceID + ":" + ACK + ":" + ackPayload + "\n";
-    lora.sendData(response);
+        hostID + ":" + deviceID + ":" + PARAM_DELTA + ":" + delta + "\n";
+    sendReply(ctx.reply, response, LORA_TX_LOW);
+    return true;
 }
 
-static void handle_SwapDirection(const String &args) {
+void reportParamChanges(const ReplyContext &reply) {
+    if (!paramStore.update(motion.getParams()) || !PARAM_NOTIFY_DEFAULT) {
+        return;
+    }
+    // 组播回复时隙只留了一条短通知的空间(REPLY_SLOT_NOTICE_BYTES)，
+    // 此时只告知新版本号，上位机再单播 PARAM_DELTA 取变化的值
+    char delta[PARAM_DELTA_MAX + 1];
+    if (paramStore.takeDirty(delta, sizeof(delta), !reply.route.held) == 0) {
+        return;
+    }
+    String notice =
+        hostID + ":" + deviceID + ":" + PARAM_DELTA + ":" + delta + "\n";
+    sendReply(reply, notice, LORA_TX_LOW);
+}
+
+static bool handle_SwapDirection(const char *args, const CommandContext &ctx) {
     motion.swapDirection(); // 调用 motion 对象的函数来切换方向
 
     // 回复一个 ACK 消息，并告知当前的状态
     String currentState = motion.isDirectionReversed() ? "REVERSED" : "NORMAL";
     String ackPayload = "SWAP_DIR," + currentState;
-    String response =
-        hostID + ":" + deviceID + ":" + ACK + ":" + ackPayload + "\n";
-    lora.sendData(response);
+    sendAck(ctx, ackPayload);
+    return true;
 }
 
-static void handle_EnableStepMode(const String &args) {
-    if (args == "1") {
+static bool handle_EnableStepMode(const char *args, const CommandContext &ctx) {
+    if (strcmp(args, "1") == 0) {
         motion.enableStepMode(true);
-    } else if (args == "0") {
+    } else if (strcmp(args, "0") == 0) {
         motion.enableStepMode(false);
     } else {
-        safePrintln("Invalid payload for STEP_MODE: " + args);
-        return;
+        safePrintln("Invalid payload for STEP_MODE: " + String(args));
+        return false;
     }
 
     // 回复ACK
     String currentState = motion.isStepModeEnabled() ? "ENABLED" : "DISABLED";
     String ackPayload = "STEP_MODE," + currentState;
+    sendAck(ctx, ackPayload);
+    return true;
+}
+
+static bool handle_RelayMode(const char *args, const CommandContext &ctx) {
+    if (strcmp(args, "2") == 0) {
+        relayRouter.setEnabled(true);
+        relayRouter.setAggregate(true);
+    } else if (strcmp(args, "1") == 0) {
+        relayRouter.setEnabled(true);
+        relayRouter.setAggregate(false);
+    } else if (strcmp(args, "0") == 0) {
+        relayRouter.setEnabled(false);
+    } else {
+        safePrintln("Invalid payload for RELAY_MODE: " + String(args));
+        return false;
+    }
+
+    String currentState = relayRouter.isAggregating() ? "AGGREGATE"
+                          : relayRouter.isEnabled()   ? "ENABLED"
+                                                      : "DISABLED";
+    sendAck(ctx, String(RELAY_MODE) + "," + currentState);
+    return true;
+}
+
+static bool handle_DictMode(const char *args, const CommandContext &ctx) {
+    if (strcmp(args, "1") == 0) {
+        lora.setDictCompression(true);
+    } else if (strcmp(args, "0") == 0) {
+        lora.setDictCompression(false);
+    } else {
+        safePrintln("Invalid payload for DICT_MODE: " + String(args));
+        return false;
+    }
+
+    String currentState = lora.isDictCompression() ? "ENABLED" : "DISABLED";
+    sendAck(ctx, String(DICT_MODE) + "," + currentState);
+    return true;
+}
+
+static bool handle_EspNow(const char *args, const CommandContext &ctx) {
+    if (strcmp(args, "PEERS") == 0) {
+        char peers[ESPNOW_PEER_MAX * 4 + 1];
+        espNowLink.formatPeers(peers, sizeof(peers));
+        EspNowStats st = espNowLink.getStats();
+        String report = "PEERS:" + String(peers);
+        report += ";TX:" + String(st.sent) + "," + String(st.broadcast) + "," +
+                  String(st.sendFailed);
+        report += ";RX:" + String(st.received) + "," +
+                  String(st.dropped + espNowRxOverflow());
+        String response =
+            hostID + ":" + deviceID + ":" + ESPNOW + ":" + report + "\n";
+        sendReply(ctx.reply, response, LORA_TX_LOW);
+        return true;
+    }
+    bool ok;
+    if (strcmp(args, "1") == 0) {
+        ok = espNowSetEnabled(true);
+    } else if (strcmp(args, "0") == 0) {
+        ok = espNowSetEnabled(false);
+    } else {
+        safePrintln("Invalid payload for ESPNOW: " + String(args));
+        return false;
+    }
+
+    String currentState = espNowIsEnabled() ? "ENABLED" : "DISABLED";
+    sendAck(ctx, String(ESPNOW) + "," + currentState);
+    return ok;
+}
+
+// payload: <接收者>:<命令>:<负载>，本机作为发送者组成一帧经ESP-NOW发出
+static bool handle_EspNowSend(const char *args, const CommandContext &ctx) {
+    const char *sep = strchr(args, ':');
+    if (sep == NULL || sep == args || strchr(sep + 1, ':') == NULL) {
+        safePrintln("Invalid payload for ESPNOW_SEND: " + String(args));
+        return false;
+    }
+    char frame[ESPNOW_FRAME_MAX + 1];
+    int n = snprintf(frame, sizeof(frame), "%.*s:%s:%s\n", (int)(sep - args),
+                     args, deviceID.c_str(), sep + 1);
+    bool ok = n > 0 && (size_t)n < sizeof(frame) && espNowLink.send(frame, n);
+    sendAck(ctx, String(ESPNOW_SEND) + "," + (ok ? "OK" : "FAILED"));
+    return ok;
+}
+
+static bool handle_SetGroups(const char *args, const CommandContext &ctx) {
+    if (!addressFilter.setGroups(args, strlen(args))) {
+        safePrintln("Invalid payload for SET_GROUPS: " + String(args));
+        return false;
+    }
+    lora.saveGroups(args);
+
+    sendAck(ctx,
+            String(SET_GROUPS) + "," + String(addressFilter.groupCount()));
+    return true;
+}
+
+static bool handle_SetSlot(const char *args, const CommandContext &ctx) {
+    uint8_t slot = REPLY_SLOT_AUTO;
+    if (strcmp(args, "AUTO") != 0) {
+        long value;
+        if (!parseStringToInt(args, value) || value < 0 ||
+            value >= REPLY_SLOT_AUTO) {
+            safePrintln("Invalid payload for SET_SLOT: " + String(args));
+            return false;
+        }
+        slot = (uint8_t)value;
+    }
+    replySlots.setIndex(slot, deviceNum);
+    lora.saveReplySlot(slot);
+
+    sendAck(ctx, String(SET_SLOT) + "," + String(replySlots.getIndex()) + "," +
+            String(replySlots.widthMs()));
+    return true;
+}
+
+static bool handle_Sync(const char *args, const CommandContext &ctx) {
+    int64_t localUs = esp_timer_get_time(); // 尽早取本地时间，减少处理延迟
+    char *endptr;
+    unsigned long long hostUs = strtoull(args, &endptr, 10);
+    if (*args == '\0' || *endptr != '\0') {
+        safePrintln("Invalid payload for SYNC: " + String(args));
+        return false;
+    }
+    commandScheduler.onBeacon(hostUs, localUs);
+    return true;
+}
+
+static bool handle_LoraConfig(const char *args, const CommandContext &ctx) {
+    LoraRadioParams next = lora.getRadio();
+    uint32_t baud = lora.getUartBaud();
+    bool fixed = lora.isFixedMode();
+    StrView rest = {args, strlen(args)};
+    StrView item;
+    while (nextToken(rest, ';', item)) {
+        if (item.len == 0) {
+            continue;
+        }
+        const char *sep = (const char *)memchr(item.data, ':', item.len);
+        if (sep == NULL) {
+            safePrintln("Invalid LORA_CFG item: " + viewToString(item));
+            return false;
+        }
+        StrView name = {item.data, (size_t)(sep - item.data)};
+        char valueBuf[PARAM_VALUE_MAX_LEN + 1];
+        size_t valueLen = item.data + item.len - sep - 1;
+        long value;
+        if (valueLen > PARAM_VALUE_MAX_LEN) {
+            safePrintln("LORA_CFG value too long: " + viewToString(item));
+            return false;
+        }
+        memcpy(valueBuf, sep + 1, valueLen);
+        valueBuf[valueLen] = '\0';
+        if (!parseStringToInt(valueBuf, value) || value < 0) {
+            safePrintln("Invalid LORA_CFG value: " + viewToString(item));
+            return false;
+        }
+        if (value > 255 && !name.equals("BAUD")) {
+            safePrintln("LORA_CFG out of range: " + viewToString(item));
+            return false;
+        }
+        if (name.equals("CH")) {
+            next.channel = (uint8_t)value;
+        } else if (name.equals("PWR")) {
+            next.power = (uint8_t)value;
+        } else if (name.equals("AIR")) {
+            next.airRate = (uint8_t)value;
+        } else if (name.equals("BAUD")) {
+            baud = (uint32_t)value;
+        } else if (name.equals("FIXED") && value <= 1) {
+            fixed = value == 1;
+        } else {
+            safePrintln("Unknown LORA_CFG item: " + viewToString(item));
+            return false;
+        }
+    }
+    // 实际切换由发送任务完成，完成后回复ACK
+    if (!lora.requestRadioConfig(next, baud, fixed, ctx.reply.route)) {
+        safePrintln("LORA_CFG out of range: " + String(args));
+        return false;
+    }
+    return true;
+}
+
+static bool handle_Ping(const char *args, const CommandContext &ctx) {
     String response =
-        hostID + ":" + deviceID + ":" + ACK + ":" + ackPayload + "\n";
-    lora.sendData(response);
+        hostID + ":" + deviceID + ":" + PONG + ":" + String(args) + "\n";
+    sendReply(ctx.reply, response, LORA_TX_HIGH);
+    return true;
+}
+
+// LINK_STATS按页回复，全部字段放在一帧里会超过LORA_TX_FRAME_MAX
+static String linkStatsTxPage() {
+    LoraTxStats tx = lora.getTxStats();
+    TxSchedulerStats sched = lora.getSchedulerStats();
+
+    String stats = "SENT:" + String(tx.sent);
+    stats += ";FAILED:" + String(tx.failed);
+    stats += ";DROP:" + String(tx.dropped[LORA_TX_HIGH]) + "," +
+             String(tx.dropped[LORA_TX_NORMAL]) + "," +
+             String(tx.dropped[LORA_TX_LOW]);
+    stats += ";QMAX:" + String(tx.maxDepth[LORA_TX_HIGH]) + "," +
+             String(tx.maxDepth[LORA_TX_NORMAL]) + "," +
+             String(tx.maxDepth[LORA_TX_LOW]);
+    stats += ";COALESCED:" + String(sched.coalesced);
+    stats += ";SUPERSEDED:" + String(sched.superseded);
+    stats += ";THROTTLED:" + String(sched.throttled);
+    stats += ";AIRTIME_MS:" + String((unsigned long)(sched.airtimeUs / 1000));
+    stats += ";DUTY_PERMILLE:" + String(sched.dutyPermille) + "/" +
+             String(sched.budgetPermille);
+    return stats;
+}
+
+static String linkStatsAuxPage() {
+    LoraAuxStats aux = lora.getAuxStats();
+
+    String stats = "AUX_LAST_US:" + String(aux.lastFrameWaitUs);
+    stats += ";AUX_MAX_US:" + String(aux.maxFrameWaitUs);
+    stats += ";AUX_TIMEOUTS:" + String(aux.timeouts);
+    stats += ";AUX_RESETS:" + String(aux.resets);
+    stats += ";AUX_SETTLE_MS:" + String(aux.settleMs);
+    stats += ";UART_BAUD:" + String(lora.getUartBaud());
+    LoraFastStopStats fast = lora.getFastStopStats();
+    stats += ";FAST_STOP:" + String(fast.count) + "," + String(fast.lastUs) +
+             "," + String(fast.maxUs);
+    MotionQueueStats mq = motionQueueStats();
+    stats += ";MOTION_Q:" + String(mq.executed) + "," + String(mq.stale) + "," +
+             String(mq.flushed) + "," + String(mq.overflow) + "," +
+             String(mq.maxLatencyUs);
+    return stats;
+}
+
+static String linkStatsNetPage() {
+    RelayStats relay = relayRouter.getStats();
+    const ClockSync &clock = commandScheduler.getClock();
+    ScheduledStats timed = commandScheduler.getStats();
+
+    String stats = "RELAYED:" + String(relay.forwarded);
+    stats += ";RELAY_DUP:" + String(relay.duplicates);
+    stats += ";RELAY_RANGE:" + String(relay.outOfRange);
+    stats += ";CLK_BEACONS:" + String(clock.beaconCount());
+    stats += ";CLK_ERR_US:" + String(clock.lastErrorUs());
+    stats += ";CLK_DRIFT_PPB:" + String(clock.driftPpb());
+    stats += ";SCHED:" + String(timed.armed) + "," + String(timed.late) +
+             "," + String(timed.rejected);
+    stats += ";SCHED_LAG_US:" + String(timed.lastLagUs);
+    stats += ";SLOT:" + String(replySlots.getIndex()) + "," +
+             String(replySlots.widthMs()) + "," +
+             String(lora.getSchedulerStats().slotted);
+    return stats;
+}
+
+static bool handle_LinkStats(const char *args, const CommandContext &ctx) {
+    String stats;
+    if (args[0] == '\0' || strcmp(args, "TX") == 0) {
+        stats = linkStatsTxPage();
+    } else if (strcmp(args, "AUX") == 0) {
+        stats = linkStatsAuxPage();
+    } else if (strcmp(args, "NET") == 0) {
+        stats = linkStatsNetPage();
+    } else {
+        safePrintln("Unknown LINK_STATS page: " + String(args));
+        return false;
+    }
+
+    String response =
+        hostID + ":" + deviceID + ":" + LINK_STATS + ":" + stats + "\n";
+    sendReply(ctx.reply, response, LORA_TX_LOW);
+    return true;
+}
+
+// 设备发出的各类帧及其负载的最大长度，用于AIRTIME估算
+// 帧头的收发方ID在运行时取实际长度，这里只列负载
+struct AirtimeFrame {
+    const char *command;
+    uint16_t payloadMax;
+};
+
+static constexpr AirtimeFrame airtimeFrames[] = {
+    {ACK, 40},                             // 普通确认：原命令+参数
+    {"ACK_SEQ", 24},                       // 累计ACK ACK:SEQ,<序号>,<位图>，长度相同
+    {PONG, 16},                            // PING原样返回
+    {REPORT_ALL_PARAMS, PARAM_REPORT_MAX}, // 启动及参数变化时的全部参数
+    {GET_PARAM, 40},                       // 单个参数 NAME:VALUE
+    {PARAM_SCHEMA, PARAM_SCHEMA_PAGE_MAX}, // 参数说明，按页
+    {PARAM_DELTA, PARAM_DELTA_MAX},        // 参数变化，最坏情况为全部参数
+    {LINK_STATS, 200},                     // 单页统计
+    {"REPORT_IP", 16},                     // OTA开启后上报的IP
+};
+
+// 最长的收发方字段：上位机ID + 设备ID + 发送者选项
+#define AIRTIME_HEADER_MAX 40
+
+static constexpr bool airtimeFramesFit() {
+    for (const AirtimeFrame &f : airtimeFrames) {
+        size_t n = 0;
+        while (f.command[n] != '\0') {
+            n++;
+        }
+        // 头 + ':' + 命令 + ':' + 负载 + '\n'
+        if (AIRTIME_HEADER_MAX + 1 + n + 1 + f.payloadMax + 1 >
+            LORA_TX_FRAME_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(airtimeFramesFit(),
+              "A reply frame can exceed LORA_TX_FRAME_MAX");
+
+// 回复 AIRTIME:<bps>;<命令>=<us>;...  payload为空时按当前空速，也可指定空速等级0-7
+static bool handle_Airtime(const char *args, const CommandContext &ctx) {
+    uint8_t airRate = lora.getRadio().airRate;
+    if (args[0] != '\0') {
+        long level;
+        if (!parseStringToInt(args, level) || level < 0 ||
+            level > LORA_AIR_MAX) {
+            safePrintln("Invalid AIRTIME air rate: " + String(args));
+            return false;
+        }
+        airRate = (uint8_t)level;
+    }
+    uint32_t bps = loraAirRateBps(airRate);
+    size_t header = hostID.length() + 1 + deviceID.length();
+
+    String report = String(bps);
+    for (const AirtimeFrame &f : airtimeFrames) {
+        size_t len = header + 1 + strlen(f.command) + 1 + f.payloadMax + 1;
+        report += ";" + String(f.command) + "=" +
+                  String(loraAirtimeUs(bps, len));
+    }
+    String response =
+        hostID + ":" + deviceID + ":" + AIRTIME + ":" + report + "\n";
+    sendReply(ctx.reply, response, LORA_TX_LOW);
+    return true;
 }
 
 // --- 2. 定义命令处理函数的类型别名，方便书写 ---
-//  这个函数指针指向一个函数，该函数接收一个String类型的参数且无返回值
-typedef void (*CommandHandler)(const String &args);
+//  这个函数指针指向一个函数，该函数接收一个C字符串参数和执行环境，返回命令是否执行成功
+typedef bool (*CommandHandler)(const char *args,
+                               const CommandContext &ctx);
 
 // --- 3. 创建命令分派表 ---
 //  这是一个结构体，用于将命令字符串和处理函数绑定在一起
@@ -183,7 +577,7 @@ struct CommandEntry {
 };
 
 //  这就是我们的“表格”，所有命令都在这里注册
-static const CommandEntry commandTable[] = {
+static constexpr CommandEntry commandTable[] = {
     {Forward, handle_Forward},
     {Backward, handle_Backward},
     {STOP, handle_Stop},
@@ -191,17 +585,46 @@ static const CommandEntry commandTable[] = {
     {OTA_DISABLE, handle_OtaDisable},
     {SWAP_DIRECTION, handle_SwapDirection},
     {ENABLE_STEP_MODE, handle_EnableStepMode},
-    {SET_BATCH_PARAMS, handle_SetBatchParams}};
+    {SET_BATCH_PARAMS, handle_SetBatchParams},
+    {GET_PARAM, handle_GetParam},
+    {REPORT_ALL_PARAMS, handle_ReportAllParams},
+    {PARAM_SCHEMA, handle_ParamSchema},
+    {PARAM_DELTA, handle_ParamDelta},
+    {LINK_STATS, handle_LinkStats},
+    {RELAY_MODE, handle_RelayMode},
+    {DICT_MODE, handle_DictMode},
+    {ESPNOW, handle_EspNow},
+    {ESPNOW_SEND, handle_EspNowSend},
+    {SET_GROUPS, handle_SetGroups},
+    {SET_SLOT, handle_SetSlot},
+    {SYNC, handle_Sync},
+    {LORA_CFG, handle_LoraConfig},
+    {PING, handle_Ping},
+    {AIRTIME, handle_Airtime}};
+
+#define COMMAND_COUNT (sizeof(commandTable) / sizeof(commandTable[0]))
+
+//  编译期为命令表生成完美哈希：分派时一次哈希定位候选项，再一次strcmp确认
+static constexpr PerfectHash<COMMAND_COUNT> commandIndex =
+    buildPerfectHash(commandTable, &CommandEntry::commandName);
+static_assert(commandIndex.unique, "Duplicate command name in commandTable");
+static_assert(commandIndex.found,
+              "No collision-free hash seed for commandTable, raise "
+              "PERFECT_HASH_SEED_TRIES");
 
 // --- 4. 实现主分派函数 ---
-void processCommand(const String &command, const String &args) {
-    // 遍历命令表，查找匹配的命令
-    for (const auto &entry : commandTable) {
-        if (command == entry.commandName) {
-            // 调用对应的处理函数，并传入参数
-            entry.handler(args);
-            return; // 处理完成，退出函数
+bool processCommand(const char *command, const char *args,
+                    const CommandContext &ctx) {
+    size_t i = commandIndex.candidate(command);
+    if (i < COMMAND_COUNT && strcmp(command, commandTable[i].commandName) == 0) {
+        // 调用对应的处理函数，并传入参数
+        if (ctx.rxUs != 0) {
+            return commandTable[i].handler(args, ctx);
         }
+        CommandContext now = ctx; // 定时执行：有效期从现在算起
+        now.rxUs = esp_timer_get_time();
+        return commandTable[i].handler(args, now);
     }
-    safePrintln("Unknown command for me: " + command);
+    safePrintln("Unknown command for me: " + String(command));
+    return false;
 }
\ No newline at end of file
@@ -0,0 +1,198 @@
+// --- 文件名: src/espnow_link.cpp ---
+
+#include "espnow_link.h"
+#include "Command.h"
+#include "address_filter.h"
+#include "binary_frame.h"
+#include "frame_parser.h"
+#include <stdio.h>
+#include <string.h>
+
+const uint8_t ESPNOW_BROADCAST_MAC[ESPNOW_MAC_LEN] = {0xFF, 0xFF, 0xFF,
+                                                      0xFF, 0xFF, 0xFF};
+
+EspNowLink::EspNowLink()
+    : radio(NULL), self(""), selfId(BIN_ID_BROADCAST), peers(),
+      nextHelloMs(0), helloSent(false), stats() {
+    for (size_t i = 0; i < ESPNOW_PEER_MAX; i++) {
+        peers[i].id = BIN_ID_BROADCAST;
+    }
+}
+
+void EspNowLink::begin(const EspNowRadio *r, const char *name, uint8_t id) {
+    radio = r;
+    self = name;
+    selfId = id;
+    helloSent = false; // 重新初始化后立即广播一次，邻居尽快重新学到本机
+    for (size_t i = 0; i < ESPNOW_PEER_MAX; i++) {
+        peers[i].id = BIN_ID_BROADCAST; // 无线层的对端表已随WiFi一起清空
+    }
+}
+
+const EspNowPeer *EspNowLink::findPeer(uint8_t id) const {
+    if (id == BIN_ID_BROADCAST) {
+        return NULL;
+    }
+    for (size_t i = 0; i < ESPNOW_PEER_MAX; i++) {
+        if (peers[i].id == id) {
+            return &peers[i];
+        }
+    }
+    return NULL;
+}
+
+size_t EspNowLink::peerCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < ESPNOW_PEER_MAX; i++) {
+        if (peers[i].id != BIN_ID_BROADCAST) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void EspNowLink::learn(uint8_t id, const uint8_t *mac, uint32_t nowMs) {
+    EspNowPeer *slot = NULL;
+    EspNowPeer *oldest = &peers[0];
+    for (size_t i = 0; i < ESPNOW_PEER_MAX; i++) {
+        EspNowPeer &p = peers[i];
+        if (p.id == id) {
+            slot = &p;
+            break;
+        }
+        if (slot == NULL && p.id == BIN_ID_BROADCAST) {
+            slot = &p; // 继续查找，已有条目优先
+        }
+        if ((int32_t)(p.heardMs - oldest->heardMs) < 0) {
+            oldest = &p;
+        }
+    }
+    if (slot != NULL && slot->id == id) {
+        slot->heardMs = nowMs;
+        if (memcmp(slot->mac, mac, ESPNOW_MAC_LEN) == 0) {
+            return;
+        }
+        radio->removePeer(slot->mac); // 同一设备号换了板子
+    } else {
+        if (slot == NULL) {
+            slot = oldest; // 表满：替换最久没听到的邻居
+        }
+        if (slot->id != BIN_ID_BROADCAST) {
+            radio->removePeer(slot->mac);
+        }
+    }
+    slot->id = BIN_ID_BROADCAST;
+    if (!radio->addPeer(mac)) {
+        return;
+    }
+    slot->id = id;
+    memcpy(slot->mac, mac, ESPNOW_MAC_LEN);
+    slot->heardMs = nowMs;
+}
+
+bool EspNowLink::send(const char *frame, size_t len) {
+    if (radio == NULL) {
+        return false;
+    }
+    if (len > ESPNOW_FRAME_MAX) {
+        stats.dropped++;
+        return false;
+    }
+    // 组播、区间、位图地址末尾也可能是数字，不能按设备号单播
+    StrView rest = {frame, len};
+    StrView receiver;
+    const EspNowPeer *peer = NULL;
+    if (nextToken(rest, ':', receiver) && !receiver.empty() &&
+        receiver.data[0] != ADDR_GROUP_PREFIX &&
+        receiver.data[0] != ADDR_RANGE_PREFIX &&
+        receiver.data[0] != ADDR_MASK_PREFIX) {
+        peer = findPeer(binaryIdFromName(receiver.data, receiver.len));
+    }
+    const uint8_t *mac = peer != NULL ? peer->mac : ESPNOW_BROADCAST_MAC;
+    if (!radio->send(mac, (const uint8_t *)frame, len)) {
+        stats.sendFailed++;
+        return false;
+    }
+    if (peer != NULL) {
+        stats.sent++;
+    } else {
+        stats.broadcast++;
+    }
+    return true;
+}
+
+size_t EspNowLink::receive(const uint8_t *mac, const uint8_t *data, size_t len,
+                           uint32_t nowMs, char *out, size_t cap) {
+    if (radio == NULL) {
+        return 0;
+    }
+    if (len > 0 && data[len - 1] == '\n') {
+        len--;
+    }
+    StrView rest = {(const char *)data, len};
+    StrView receiver, sender, command, name;
+    if (len == 0 || len + 1 > cap || !nextToken(rest, ':', receiver) ||
+        !nextToken(rest, ':', sender) || !nextToken(rest, ':', command)) {
+        stats.dropped++;
+        return 0;
+    }
+    nextToken(sender, '/', name); // 去掉发送者选项
+    uint8_t id = binaryIdFromName(name.data, name.len);
+    if (id == selfId && selfId != BIN_ID_BROADCAST) {
+        return 0; // 回环测试或中继回来的自己的帧
+    }
+    if (id != BIN_ID_BROADCAST) {
+        learn(id, mac, nowMs);
+    }
+    if (command.equals(ESPNOW_HELLO, strlen(ESPNOW_HELLO))) {
+        return 0;
+    }
+    memcpy(out, data, len);
+    out[len] = '\0';
+    stats.received++;
+    return len;
+}
+
+void EspNowLink::poll(uint32_t nowMs) {
+    if (radio == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < ESPNOW_PEER_MAX; i++) {
+        EspNowPeer &p = peers[i];
+        if (p.id != BIN_ID_BROADCAST &&
+            nowMs - p.heardMs > ESPNOW_PEER_EXPIRE_MS) {
+            radio->removePeer(p.mac);
+            p.id = BIN_ID_BROADCAST;
+        }
+    }
+    if (helloSent && (int32_t)(nowMs - nextHelloMs) < 0) {
+        return;
+    }
+    char hello[48];
+    int n = snprintf(hello, sizeof(hello), "ALL:%s:%s:\n", self, ESPNOW_HELLO);
+    if (n > 0 && (size_t)n < sizeof(hello)) {
+        send(hello, n);
+    }
+    helloSent = true;
+    nextHelloMs = nowMs + ESPNOW_HELLO_MS;
+}
+
+size_t EspNowLink::formatPeers(char *out, size_t cap) const {
+    size_t len = 0;
+    if (cap > 0) {
+        out[0] = '\0';
+    }
+    for (size_t i = 0; i < ESPNOW_PEER_MAX; i++) {
+        if (peers[i].id == BIN_ID_BROADCAST) {
+            continue;
+        }
+        int n = snprintf(out + len, cap - len, len == 0 ? "%u" : ",%u",
+                         peers[i].id);
+        if (n <= 0 || len + n >= cap) {
+            out[len] = '\0';
+            break;
+        }
+        len += n;
+    }
+    return len;
+}
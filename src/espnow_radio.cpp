@@ -0,0 +1,123 @@
+// --- 文件名: src/espnow_radio.cpp ---
+
+#include "espnow_radio.h"
+#include "LORA.h"
+#include "tasks.h"
+#include <WiFi.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include <string.h>
+
+EspNowLink espNowLink;
+
+static QueueHandle_t rxQueue = NULL;
+static volatile uint32_t rxOverflow = 0;
+static bool enabled = false;              // 只在LoRa任务中读写
+static volatile bool wifiReleased = false; // OTA关闭了WiFi，需要重新初始化
+
+static bool radioSend(const uint8_t *mac, const uint8_t *data, size_t len) {
+    return esp_now_send(mac, data, len) == ESP_OK;
+}
+
+static bool radioAddPeer(const uint8_t *mac) {
+    if (esp_now_is_peer_exist(mac)) {
+        return true;
+    }
+    esp_now_peer_info_t peer = {};
+    memcpy(peer.peer_addr, mac, ESPNOW_MAC_LEN);
+    peer.channel = 0; // 使用当前信道，OTA连上路由器后跟随路由器的信道
+    peer.ifidx = WIFI_IF_STA;
+    peer.encrypt = false;
+    return esp_now_add_peer(&peer) == ESP_OK;
+}
+
+static void radioRemovePeer(const uint8_t *mac) { esp_now_del_peer(mac); }
+
+static const EspNowRadio espNowRadio = {radioSend, radioAddPeer,
+                                        radioRemovePeer};
+
+// 接收回调，运行在WiFi任务中：只复制数据并唤醒LoRa任务
+static void onEspNowReceive(const uint8_t *mac, const uint8_t *data, int len) {
+    if (len <= 0 || len > ESPNOW_FRAME_MAX) {
+        rxOverflow++;
+        return;
+    }
+    EspNowRxFrame frame;
+    memcpy(frame.mac, mac, ESPNOW_MAC_LEN);
+    frame.len = (uint8_t)len;
+    memcpy(frame.data, data, len);
+    if (xQueueSend(rxQueue, &frame, 0) != pdTRUE) {
+        rxOverflow++;
+        return;
+    }
+    if (xTaskLoRaHandle != NULL) {
+        xTaskNotifyGive(xTaskLoRaHandle);
+    }
+}
+
+static bool radioBegin() {
+    if (rxQueue == NULL) {
+        rxQueue = xQueueCreate(ESPNOW_RX_QUEUE_DEPTH, sizeof(EspNowRxFrame));
+    }
+    WiFi.mode(WIFI_STA);
+    esp_wifi_set_channel(ESPNOW_CHANNEL, WIFI_SECOND_CHAN_NONE);
+    if (esp_now_init() != ESP_OK) {
+        return false;
+    }
+    esp_now_register_recv_cb(onEspNowReceive);
+    if (!radioAddPeer(ESPNOW_BROADCAST_MAC)) {
+        esp_now_deinit();
+        return false;
+    }
+    espNowLink.begin(&espNowRadio, deviceID.c_str(), deviceNum);
+    return true;
+}
+
+bool espNowSetEnabled(bool enable) {
+    if (enable == enabled) {
+        return true;
+    }
+    if (!enable) {
+        espNowLink.end();
+        esp_now_deinit();
+        enabled = false;
+        return true;
+    }
+    if (!radioBegin()) {
+        safePrintln("ESP-NOW init failed.");
+        return false;
+    }
+    enabled = true;
+    return true;
+}
+
+bool espNowIsEnabled() { return enabled; }
+
+void espNowWifiReleased() {
+    wifiReleased = true;
+    if (xTaskLoRaHandle != NULL) {
+        xTaskNotifyGive(xTaskLoRaHandle);
+    }
+}
+
+void espNowService(uint32_t nowMs) {
+    if (wifiReleased) {
+        wifiReleased = false;
+        if (enabled) {
+            // WiFi关闭时ESP-NOW已失效，对端表也被清空，整体重新初始化
+            enabled = false;
+            espNowLink.end();
+            esp_now_deinit();
+            espNowSetEnabled(true);
+        }
+    }
+    if (enabled) {
+        espNowLink.poll(nowMs);
+    }
+}
+
+bool espNowReceive(EspNowRxFrame &frame) {
+    return rxQueue != NULL && xQueueReceive(rxQueue, &frame, 0) == pdTRUE;
+}
+
+uint32_t espNowRxOverflow() { return rxOverflow; }
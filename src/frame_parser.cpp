@@ -0,0 +1,167 @@
+// --- 文件名: src/frame_parser.cpp ---
+
+#include "frame_parser.h"
+#include "text_dict.h"
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// 去掉两端空白，并在新的末尾写入'\0'
+static StrView trimInPlace(char *start, size_t len) {
+    while (len > 0 && isSpace(*start)) {
+        start++;
+        len--;
+    }
+    while (len > 0 && isSpace(start[len - 1])) {
+        len--;
+    }
+    start[len] = '\0';
+    StrView v = {start, len};
+    return v;
+}
+
+FrameBuffer::FrameBuffer() : len(0), overflow(false), binary(false) {
+    buf[0] = '\0';
+}
+
+void FrameBuffer::reset() {
+    len = 0;
+    overflow = false;
+    binary = false;
+    buf[0] = '\0';
+}
+
+FramePushResult FrameBuffer::push(char c) {
+    if (len == 0 && !overflow && !binary && (uint8_t)c == BIN_FRAME_SYNC) {
+        binary = true; // 同步字节本身不存入缓冲区
+        return FRAME_PENDING;
+    }
+    char terminator = binary ? (char)BIN_FRAME_DELIMITER : '\n';
+    if (c == terminator) {
+        if (overflow) {
+            reset();
+            return FRAME_OVERFLOW;
+        }
+        buf[len] = '\0';
+        return binary ? FRAME_READY_BINARY : FRAME_READY;
+    }
+    if (overflow) {
+        return FRAME_PENDING; // 丢弃超长帧剩余部分
+    }
+    if (binary || (uint8_t)c < TEXT_DICT_CODE_BASE) {
+        // 绝大多数字节：不是码字，直接存入
+        if (len + 1 > FRAME_MAX_LEN) {
+            overflow = true;
+            return FRAME_PENDING;
+        }
+        buf[len++] = c;
+        return FRAME_PENDING;
+    }
+    // 文本帧中的字典码字就地展开(见text_dict.h)
+    size_t wordLen = 1;
+    const char *word = textDictWord((uint8_t)c, wordLen);
+    if (word == NULL) {
+        word = &c;
+        wordLen = 1;
+    }
+    if (len + wordLen > FRAME_MAX_LEN) {
+        overflow = true;
+        return FRAME_PENDING;
+    }
+    memcpy(buf + len, word, wordLen);
+    len += wordLen;
+    return FRAME_PENDING;
+}
+
+StopTokenDetector::StopTokenDetector() : matched(0), armed(true) {}
+
+bool StopTokenDetector::push(uint8_t c) {
+    if (c == '\n' || c == BIN_FRAME_DELIMITER) {
+        armed = true;
+        matched = 0;
+        return false;
+    }
+    if (!armed) {
+        return false;
+    }
+    if (c != STOP_TOKEN_BYTE) {
+        armed = false; // 普通帧开始，到下一个帧边界之前不再识别
+        matched = 0;
+        return false;
+    }
+    if (++matched < STOP_TOKEN_LEN) {
+        return false;
+    }
+    armed = false;
+    matched = 0;
+    return true;
+}
+
+bool tokenizeFrame(char *frame, size_t len, FrameFields &out) {
+    char *colons[3];
+    int found = 0;
+    for (size_t i = 0; i < len && found < 3; i++) {
+        if (frame[i] == ':') {
+            colons[found++] = frame + i;
+        }
+    }
+    if (found < 3 || colons[0] == frame) {
+        return false;
+    }
+
+    char *end = frame + len;
+    out.receiver = trimInPlace(frame, colons[0] - frame);
+    out.sender = trimInPlace(colons[0] + 1, colons[1] - colons[0] - 1);
+    out.command = trimInPlace(colons[1] + 1, colons[2] - colons[1] - 1);
+    out.payload = trimInPlace(colons[2] + 1, end - colons[2] - 1);
+    return !out.receiver.empty();
+}
+
+bool nextToken(StrView &rest, char delimiter, StrView &token) {
+    if (rest.len == 0) {
+        return false;
+    }
+    const char *sep = (const char *)memchr(rest.data, delimiter, rest.len);
+    if (sep == NULL) {
+        token = rest;
+        rest.data += rest.len;
+        rest.len = 0;
+    } else {
+        token.data = rest.data;
+        token.len = sep - rest.data;
+        rest.len -= token.len + 1;
+        rest.data = sep + 1;
+    }
+    return true;
+}
+
+bool parseSenderOptions(const StrView &sender, SenderOptions &out) {
+    StrView rest = sender;
+    StrView token;
+    out.present = 0;
+    out.name.data = sender.data;
+    out.name.len = 0;
+    nextToken(rest, '/', out.name);
+    while (nextToken(rest, '/', token)) {
+        if (token.len < 2 || token.len > 1 + SENDER_OPT_MAX_DIGITS ||
+            token.data[0] < 'A' || token.data[0] > 'Z') {
+            return false;
+        }
+        uint64_t value = 0;
+        for (size_t i = 1; i < token.len; i++) {
+            char c = token.data[i];
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            value = value * 10 + (c - '0');
+        }
+        if (value > UINT32_MAX) {
+            return false;
+        }
+        int index = token.data[0] - 'A';
+        out.present |= 1UL << index;
+        out.values[index] = (uint32_t)value;
+    }
+    return !out.name.empty();
+}
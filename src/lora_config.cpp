@@ -0,0 +1,97 @@
+// --- 文件名: src/lora_config.cpp ---
+
+#include "lora_config.h"
+#include <string.h>
+
+uint16_t loraPackRadio(const LoraRadioParams &radio) {
+    return (uint16_t)(radio.channel << 5 | radio.power << 3 | radio.airRate);
+}
+
+LoraRadioParams loraUnpackRadio(uint16_t word) {
+    LoraRadioParams radio;
+    radio.channel = (uint8_t)(word >> 5);
+    radio.power = (uint8_t)((word >> 3) & 0x03);
+    radio.airRate = (uint8_t)(word & 0x07);
+    return radio;
+}
+
+LoraRadioParams loraGetRadio(const uint8_t *regs) {
+    return loraUnpackRadio(
+        (uint16_t)(regs[LORA_REG_RADIO] << 8 | regs[LORA_REG_RADIO + 1]));
+}
+
+void loraSetRadio(uint8_t *regs, const LoraRadioParams &radio) {
+    uint16_t word = loraPackRadio(radio);
+    regs[LORA_REG_RADIO] = (uint8_t)(word >> 8);
+    regs[LORA_REG_RADIO + 1] = (uint8_t)(word & 0xFF);
+}
+
+bool loraRadioValid(const LoraRadioParams &radio) {
+    return radio.channel <= LORA_CHANNEL_MAX && radio.power <= LORA_POWER_MAX &&
+           radio.airRate <= LORA_AIR_MAX;
+}
+
+uint32_t loraGetBaud(const uint8_t *regs) {
+    const uint8_t *p = regs + LORA_REG_BAUD;
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 |
+           p[3];
+}
+
+void loraSetBaud(uint8_t *regs, uint32_t baud) {
+    uint8_t *p = regs + LORA_REG_BAUD;
+    p[0] = (uint8_t)(baud >> 24);
+    p[1] = (uint8_t)(baud >> 16);
+    p[2] = (uint8_t)(baud >> 8);
+    p[3] = (uint8_t)baud;
+}
+
+void loraSetFixed(uint8_t *regs, uint8_t group, uint8_t address) {
+    regs[LORA_REG_MODE] = (uint8_t)((uint16_t)LoraMode::Fixed >> 8);
+    regs[LORA_REG_MODE + 1] = (uint8_t)LoraMode::Fixed;
+    regs[LORA_REG_LOCAL_GROUP] = group;
+    regs[LORA_REG_LOCAL_ADDR] = address;
+}
+
+bool loraIsFixed(const uint8_t *regs) {
+    return (uint16_t)(regs[LORA_REG_MODE] << 8 | regs[LORA_REG_MODE + 1]) ==
+           (uint16_t)LoraMode::Fixed;
+}
+
+size_t loraFixedHeader(uint8_t group, uint8_t address, uint8_t *out) {
+    out[0] = group;
+    out[1] = address;
+    return LORA_FIXED_HEADER_LEN;
+}
+
+size_t loraRegDiff(const uint8_t *current, const uint8_t *desired,
+                   LoraRegRun *runs, size_t maxRuns) {
+    size_t count = 0;
+    size_t i = 0;
+    while (i < LORA_REG_COUNT && count < maxRuns) {
+        if (current[i] == desired[i]) {
+            i++;
+            continue;
+        }
+        size_t start = i;
+        size_t end = i + 1; // 不含
+        while (end < LORA_REG_COUNT) {
+            size_t next = end;
+            while (next < LORA_REG_COUNT && current[next] == desired[next] &&
+                   next - end < LORA_REG_MERGE_GAP) {
+                next++;
+            }
+            if (next >= LORA_REG_COUNT || current[next] == desired[next]) {
+                break; // 后面没有足够近的差异
+            }
+            end = next + 1;
+        }
+        if (count == maxRuns - 1) {
+            end = LORA_REG_COUNT; // 段数用完：余下部分一次写完
+        }
+        runs[count].offset = (uint8_t)start;
+        runs[count].len = (uint8_t)(end - start);
+        count++;
+        i = end;
+    }
+    return count;
+}
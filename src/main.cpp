@@ -11,6 +11,9 @@
 #include "Motion.h"
 #include "MyOTA.h"
 #include "Pins.h"
+#include "address_filter.h"
+#include "binary_frame.h"
+#include "reply_slot.h"
 #include "tasks.h"
 
 // pinMode(4, OUTPUT); // !!!!!!!!!!!!!!!!!注意新板子需要把这个删除
@@ -18,12 +21,21 @@
 // 协议：RECEIVER_ID:SENDER_ID:COMMAND:PAYLOAD\n
 // 例如：SR_01:HOST:REPORT_IP:172.20.10.2  上位机--->下位机SR_01
 // 例如：SR_01:SR_02:MOVE                  下位机SR_02--->下位机SR_01
+// 例如：@legs:HOST:M_F:                    上位机--->legs组的所有下位机
+// 同时支持紧凑二进制帧：0xB5 + COBS(帧体+CRC16) + 0x00，格式见binary_frame.h
+// 同样的帧也可以从USB串口或ESP-NOW收到，回复发回收到命令的通道，见reply_channel.h
 
 void setup() {
-    Serial.begin(9600);
+    Serial.setRxBufferSize(USB_RX_BUFFER_SIZE);
+    Serial.begin(USB_SERIAL_BAUD); // 同时也是台架上位机的命令通道
     // task 配置之前都不允许用safePrintln
 
     deviceID = lora.getDeviceID(); // 获取内部设备ID
+    deviceNum = binaryIdFromName(deviceID.c_str()); // 二进制帧用的短ID
+    addressFilter.setSelf(deviceID.c_str(), deviceID.length(), deviceNum);
+    String groups = lora.getGroups(); // 组播地址，见address_filter.h
+    addressFilter.setGroups(groups.c_str(), groups.length());
+    replySlots.setIndex(lora.loadReplySlot(), deviceNum); // 组播回复时隙
 
     // 初始化硬件和模块
     ledStatus.begin();
@@ -0,0 +1,94 @@
+// --- 文件名: src/motion_queue.cpp ---
+
+#include "motion_queue.h"
+#include "LED_Status.h"
+#include "Motion.h"
+#include "Pins.h"
+#include "tasks.h"
+#include "esp_timer.h"
+#include "freertos/queue.h"
+
+static QueueHandle_t motionQueue = NULL;
+static MotionQueueStats stats = {};
+static volatile uint32_t queueEpoch = 0; // 每次清空加一
+
+void motionQueueInit() {
+    if (motionQueue == NULL) {
+        motionQueue = xQueueCreate(MOTION_QUEUE_DEPTH, sizeof(MotionCommand));
+    }
+}
+
+void motionQueueFlush() {
+    queueEpoch++; // 先换纪元号，运动任务手里的命令随之作废
+    if (motionQueue == NULL) {
+        return;
+    }
+    stats.flushed += uxQueueMessagesWaiting(motionQueue);
+    xQueueReset(motionQueue);
+}
+
+bool motionQueuePush(MotionOp op, int64_t rxUs, uint32_t maxAgeMs) {
+    MotionCommand command;
+    command.op = op;
+    command.rxUs = rxUs;
+    command.deadlineUs = 0;
+    if (op == MOTION_OP_STOP) {
+        motionQueueFlush(); // 停止不排在尚未执行的运动命令后面
+    } else {
+        command.deadlineUs =
+            rxUs + (int64_t)(maxAgeMs > 0 ? maxAgeMs : MOTION_CMD_MAX_AGE_MS) *
+                       1000;
+    }
+    command.epoch = queueEpoch;
+    if (motionQueue == NULL ||
+        xQueueSend(motionQueue, &command, 0) != pdTRUE) {
+        stats.overflow++;
+        return false;
+    }
+    return true;
+}
+
+static void execute(const MotionCommand &command) {
+    switch (command.op) {
+    case MOTION_OP_FORWARD:
+        ledStatus.setStatus(LED_MOTION_ACTIVE);
+        motion.moveForward();
+        break;
+    case MOTION_OP_BACKWARD:
+        ledStatus.setStatus(LED_MOTION_ACTIVE);
+        motion.moveBackward();
+        break;
+    case MOTION_OP_STOP:
+        ledStatus.setStatus(LED_STANDBY);
+        motion.stop();
+        break;
+    }
+}
+
+bool motionQueueServe(TickType_t timeout) {
+    MotionCommand command;
+    if (motionQueue == NULL ||
+        xQueueReceive(motionQueue, &command, timeout) != pdTRUE) {
+        return false;
+    }
+    if (command.epoch != queueEpoch) {
+        stats.flushed++; // 取出之后被紧急停止清空
+        return true;
+    }
+    int64_t now = esp_timer_get_time();
+    if (command.deadlineUs != 0 && now > command.deadlineUs) {
+        stats.stale++;
+        safePrintln("Stale motion command dropped.");
+        return true;
+    }
+    uint32_t latency = (uint32_t)(now - command.rxUs);
+    stats.lastLatencyUs = latency;
+    if (latency > stats.maxLatencyUs) {
+        stats.maxLatencyUs = latency;
+    }
+    execute(command);
+    stats.executed++;
+    return true;
+}
+
+MotionQueueStats motionQueueStats() { return stats; }
@@ -0,0 +1,251 @@
+// --- 文件名: src/param_registry.cpp ---
+
+#include "param_registry.h"
+#include "Pins.h"
+#include "binary_frame.h"
+#include "perfect_hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- 参数表：上报顺序即表中顺序，只能在末尾追加 ---
+
+static constexpr ParamDescriptor paramTable[] = {
+    {"VOLTAGE", BIN_PARAM_VOLTAGE, PARAM_INT, VOLTAGE_MIN, VOLTAGE_MAX, "V",
+     [](MotionParams &p, float v) { p.voltage = (int)v; },
+     [](const MotionParams &p) { return (float)p.voltage; }},
+    {"DUTY", BIN_PARAM_DUTY, PARAM_FLOAT, DUTY_MIN, DUTY_MAX, "%",
+     [](MotionParams &p, float v) { p.dutyCycle = v; },
+     [](const MotionParams &p) { return p.dutyCycle; }},
+    {"FWD_FREQ", BIN_PARAM_FWD_FREQ, PARAM_INT, FREQ_MIN, FREQ_MAX, "Hz",
+     [](MotionParams &p, float v) { p.forwardFreq = (uint32_t)v; },
+     [](const MotionParams &p) { return (float)p.forwardFreq; }},
+    {"FWD_PHASE", BIN_PARAM_FWD_PHASE, PARAM_FLOAT, PHASE_MIN, PHASE_MAX, "deg",
+     [](MotionParams &p, float v) { p.forwardPhase = v; },
+     [](const MotionParams &p) { return p.forwardPhase; }},
+    {"BWD_FREQ", BIN_PARAM_BWD_FREQ, PARAM_INT, FREQ_MIN, FREQ_MAX, "Hz",
+     [](MotionParams &p, float v) { p.backwardFreq = (uint32_t)v; },
+     [](const MotionParams &p) { return (float)p.backwardFreq; }},
+    {"BWD_PHASE", BIN_PARAM_BWD_PHASE, PARAM_FLOAT, PHASE_MIN, PHASE_MAX, "deg",
+     [](MotionParams &p, float v) { p.backwardPhase = v; },
+     [](const MotionParams &p) { return p.backwardPhase; }},
+    {"STEP_TIME_MS", BIN_PARAM_STEP_TIME_MS, PARAM_FLOAT, 0, STEP_TIME_MAX_MS,
+     "ms", [](MotionParams &p, float v) { p.stepTimeMs = v; },
+     [](const MotionParams &p) { return p.stepTimeMs; }},
+    {"STILL_TIME_MS", BIN_PARAM_STILL_TIME_MS, PARAM_FLOAT, 0,
+     STEP_TIME_MAX_MS, "ms",
+     [](MotionParams &p, float v) { p.stillTimeMs = v; },
+     [](const MotionParams &p) { return p.stillTimeMs; }},
+    // 以下两项由 STEP_MODE / SWAP_DIR 命令修改，这里只读
+    {"STEP_MODE_ENABLED", BIN_PARAM_STEP_MODE_ENABLED, PARAM_BOOL, 0, 1, "",
+     NULL, [](const MotionParams &p) { return p.stepMode ? 1.0f : 0.0f; }},
+    {"direction_reversed", BIN_PARAM_DIRECTION_REVERSED, PARAM_BOOL, 0, 1, "",
+     NULL,
+     [](const MotionParams &p) { return p.directionReversed ? 1.0f : 0.0f; }},
+};
+
+#define PARAM_COUNT (sizeof(paramTable) / sizeof(paramTable[0]))
+
+static constexpr PerfectHash<PARAM_COUNT> paramNameIndex =
+    buildPerfectHash(paramTable, &ParamDescriptor::name);
+static_assert(paramNameIndex.unique, "Duplicate parameter name in paramTable");
+static_assert(paramNameIndex.found,
+              "No collision-free hash seed for paramTable, raise "
+              "PERFECT_HASH_SEED_TRIES");
+
+// ID -> 表中序号+1，0表示未使用；ID为0、越界或重复时valid为false
+struct ParamIdIndex {
+    bool valid = true;
+    uint8_t slots[PARAM_ID_LIMIT] = {};
+};
+
+static constexpr ParamIdIndex buildParamIdIndex() {
+    ParamIdIndex index;
+    for (size_t i = 0; i < PARAM_COUNT; i++) {
+        uint8_t id = paramTable[i].id;
+        if (id == 0 || id >= PARAM_ID_LIMIT || index.slots[id] != 0) {
+            index.valid = false;
+            return index;
+        }
+        index.slots[id] = (uint8_t)(i + 1);
+    }
+    return index;
+}
+
+static constexpr ParamIdIndex paramIdIndex = buildParamIdIndex();
+static_assert(paramIdIndex.valid,
+              "Parameter IDs in paramTable must be unique and below "
+              "PARAM_ID_LIMIT");
+static_assert(PARAM_ID_LIMIT <= 32, "ParamBatch::staged is a 32-bit mask");
+
+size_t paramCount() { return PARAM_COUNT; }
+
+const ParamDescriptor *paramAt(size_t index) {
+    return index < PARAM_COUNT ? &paramTable[index] : NULL;
+}
+
+const ParamDescriptor *paramFind(const char *name, size_t len) {
+    size_t i = paramNameIndex.candidate(name, len);
+    if (i >= PARAM_COUNT || strncmp(paramTable[i].name, name, len) != 0 ||
+        paramTable[i].name[len] != '\0') {
+        return NULL;
+    }
+    return &paramTable[i];
+}
+
+const ParamDescriptor *paramFindById(uint8_t id) {
+    if (id >= PARAM_ID_LIMIT || paramIdIndex.slots[id] == 0) {
+        return NULL;
+    }
+    return &paramTable[paramIdIndex.slots[id] - 1];
+}
+
+ParamResult paramParse(const ParamDescriptor &param, const char *text,
+                       size_t len, float &value) {
+    // 拷贝到栈上并补'\0'，供strtol/strtof使用
+    char buf[PARAM_VALUE_MAX_LEN + 1];
+    if (len == 0 || len > PARAM_VALUE_MAX_LEN) {
+        return PARAM_ERR_FORMAT;
+    }
+    memcpy(buf, text, len);
+    buf[len] = '\0';
+
+    char *end;
+    if (param.type == PARAM_FLOAT) {
+        value = strtof(buf, &end);
+    } else {
+        value = (float)strtol(buf, &end, 10);
+    }
+    if (*end != '\0' || value != value) { // value != value 排除NaN
+        return PARAM_ERR_FORMAT;
+    }
+    return (value >= param.min && value <= param.max) ? PARAM_OK
+                                                      : PARAM_ERR_RANGE;
+}
+
+void paramBatchBegin(ParamBatch &batch, const MotionParams &current) {
+    batch.shadow = current;
+    batch.staged = 0;
+    batch.count = 0;
+    batch.valid = true;
+    batch.results[0] = '\0';
+}
+
+static ParamResult stageOne(ParamBatch &batch, const char *pair, size_t len) {
+    const char *sep = (const char *)memchr(pair, ':', len);
+    if (sep == NULL) {
+        return PARAM_ERR_FORMAT;
+    }
+    const ParamDescriptor *param = paramFind(pair, sep - pair);
+    if (param == NULL) {
+        return PARAM_ERR_UNKNOWN;
+    }
+    if (param->set == NULL) {
+        return PARAM_ERR_READONLY;
+    }
+    uint32_t bit = 1UL << param->id;
+    if (batch.staged & bit) {
+        return PARAM_ERR_DUPLICATE;
+    }
+    float value;
+    ParamResult result = paramParse(*param, sep + 1, len - (sep + 1 - pair),
+                                    value);
+    if (result != PARAM_OK) {
+        return result;
+    }
+    param->set(batch.shadow, value);
+    batch.staged |= bit;
+    return PARAM_OK;
+}
+
+ParamResult paramBatchStage(ParamBatch &batch, const char *pair, size_t len) {
+    if (batch.count > PARAM_BATCH_MAX) {
+        return PARAM_ERR_TOO_MANY; // 已经记过一次，不再追加
+    }
+    ParamResult result = batch.count == PARAM_BATCH_MAX
+                             ? PARAM_ERR_TOO_MANY
+                             : stageOne(batch, pair, len);
+    batch.results[batch.count++] = result;
+    batch.results[batch.count] = '\0';
+    if (result != PARAM_OK) {
+        batch.valid = false;
+    }
+    return result;
+}
+
+size_t paramFormatValue(const ParamDescriptor &param, float value, char *out,
+                        size_t cap) {
+    int n;
+    if (param.type == PARAM_FLOAT) {
+        n = snprintf(out, cap, "%.2f", value);
+    } else {
+        n = snprintf(out, cap, "%ld", (long)value);
+    }
+    return (n < 0 || (size_t)n >= cap) ? 0 : (size_t)n;
+}
+
+size_t paramFormatAll(const MotionParams &params, char *out, size_t cap) {
+    size_t pos = 0;
+    for (size_t i = 0; i < PARAM_COUNT; i++) {
+        const ParamDescriptor &param = paramTable[i];
+        int n = snprintf(out + pos, cap - pos, "%s%s:", i == 0 ? "" : ";",
+                         param.name);
+        if (n < 0 || (size_t)n >= cap - pos) {
+            return 0;
+        }
+        pos += n;
+        size_t v =
+            paramFormatValue(param, param.get(params), out + pos, cap - pos);
+        if (v == 0) {
+            return 0;
+        }
+        pos += v;
+    }
+    return pos;
+}
+
+// 一条参数说明 NAME,ID,TYPE,MIN,MAX,UNITS,RW，空间不足时返回0
+static size_t formatSchemaEntry(const ParamDescriptor &param, char *out,
+                                size_t cap) {
+    static const char typeCodes[] = {'I', 'F', 'B'};
+    char minText[PARAM_VALUE_MAX_LEN];
+    char maxText[PARAM_VALUE_MAX_LEN];
+    if (paramFormatValue(param, param.min, minText, sizeof(minText)) == 0 ||
+        paramFormatValue(param, param.max, maxText, sizeof(maxText)) == 0) {
+        return 0;
+    }
+    int n = snprintf(out, cap, "%s,%u,%c,%s,%s,%s,%c", param.name,
+                     (unsigned)param.id, typeCodes[param.type], minText,
+                     maxText, param.units, param.set != NULL ? 'W' : 'R');
+    return (n < 0 || (size_t)n >= cap) ? 0 : (size_t)n;
+}
+
+uint32_t paramSchemaHash() {
+    char entry[PARAM_SCHEMA_PAGE_MAX];
+    uint32_t h = 2166136261UL;
+    for (size_t i = 0; i < PARAM_COUNT; i++) {
+        size_t n = formatSchemaEntry(paramTable[i], entry, sizeof(entry));
+        h = fnv1aHash(entry, n, h);
+    }
+    return h;
+}
+
+size_t paramFormatSchema(size_t first, char *out, size_t cap) {
+    int n = snprintf(out, cap, "%u,%u,%08lx", (unsigned)first,
+                     (unsigned)PARAM_COUNT, (unsigned long)paramSchemaHash());
+    if (n < 0 || (size_t)n >= cap) {
+        return 0;
+    }
+    size_t pos = n;
+    for (size_t i = first; i < PARAM_COUNT && pos + 1 < cap; i++) {
+        size_t len = formatSchemaEntry(paramTable[i], out + pos + 1,
+                                       cap - pos - 1);
+        if (len == 0) {
+            break; // 本页放不下，上位机从这一条继续请求
+        }
+        out[pos] = ';';
+        pos += 1 + len;
+    }
+    out[pos] = '\0';
+    return pos;
+}
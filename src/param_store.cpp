@@ -0,0 +1,91 @@
+// --- 文件名: src/param_store.cpp ---
+
+#include "param_store.h"
+#include <stdio.h>
+#include <string.h>
+
+ParamStore::ParamStore()
+    : current(), epochId(0), ver(0), dirty(0), fieldVersion() {}
+
+void ParamStore::begin(const MotionParams &initial, uint16_t epoch) {
+    current = initial;
+    epochId = epoch;
+    ver = 1;
+    dirty = 0;
+    for (size_t i = 0; i < PARAM_ID_LIMIT; i++) {
+        fieldVersion[i] = ver;
+    }
+}
+
+bool ParamStore::update(const MotionParams &now) {
+    uint32_t changed = 0;
+    for (size_t i = 0; i < paramCount(); i++) {
+        const ParamDescriptor *param = paramAt(i);
+        if (param->get(now) != param->get(current)) {
+            changed |= 1UL << param->id;
+        }
+    }
+    current = now;
+    if (changed == 0) {
+        return false;
+    }
+    ver++;
+    for (size_t id = 0; id < PARAM_ID_LIMIT; id++) {
+        if (changed & (1UL << id)) {
+            fieldVersion[id] = ver;
+        }
+    }
+    dirty |= changed;
+    return true;
+}
+
+// 头部 <纪元>,<版本>，随后是mask中的参数，按注册表顺序
+size_t ParamStore::format(uint32_t mask, char *out, size_t cap) const {
+    int n = snprintf(out, cap, "%04x,%lu", (unsigned)epochId,
+                     (unsigned long)ver);
+    if (n < 0 || (size_t)n >= cap) {
+        return 0;
+    }
+    size_t pos = n;
+    for (size_t i = 0; i < paramCount(); i++) {
+        const ParamDescriptor *param = paramAt(i);
+        if (!(mask & (1UL << param->id))) {
+            continue;
+        }
+        n = snprintf(out + pos, cap - pos, ";%s:", param->name);
+        if (n < 0 || (size_t)n >= cap - pos) {
+            return 0;
+        }
+        pos += n;
+        size_t v = paramFormatValue(*param, param->get(current), out + pos,
+                                    cap - pos);
+        if (v == 0) {
+            return 0;
+        }
+        pos += v;
+    }
+    return pos;
+}
+
+size_t ParamStore::formatSince(uint16_t epoch, uint32_t since, char *out,
+                               size_t cap) const {
+    bool full = epoch != epochId || since > ver;
+    uint32_t mask = 0;
+    for (size_t id = 0; id < PARAM_ID_LIMIT; id++) {
+        if (full || fieldVersion[id] > since) {
+            mask |= 1UL << id;
+        }
+    }
+    return format(mask, out, cap);
+}
+
+size_t ParamStore::takeDirty(char *out, size_t cap, bool withValues) {
+    if (dirty == 0) {
+        return 0;
+    }
+    size_t n = format(withValues ? dirty : 0, out, cap);
+    if (n > 0) {
+        dirty = 0;
+    }
+    return n;
+}
@@ -0,0 +1,155 @@
+// --- 文件名: src/relay.cpp ---
+
+#include "relay.h"
+#include "binary_frame.h"
+#include <stdio.h>
+#include <string.h>
+
+RelayRouter::RelayRouter()
+    : enabled(false), aggregate(false), routes(), routeCount(0), seen(), seenMs(),
+      seenNext(0), stats() {}
+
+void RelayRouter::update(uint8_t id, uint8_t via, uint8_t hops,
+                         uint32_t nowMs) {
+    if (id == BIN_ID_BROADCAST) {
+        return; // 名字无法映射为ID
+    }
+    RelayRoute *slot = NULL;
+    for (uint8_t i = 0; i < routeCount; i++) {
+        if (routes[i].id == id) {
+            slot = &routes[i];
+            break;
+        }
+    }
+    if (slot != NULL) {
+        // 已有更短且仍有效的路由时不被更长的路由覆盖
+        bool fresh = nowMs - slot->heardMs < RELAY_ROUTE_EXPIRE_MS;
+        if (fresh && slot->hops < hops) {
+            return;
+        }
+    } else if (routeCount < RELAY_ROUTE_MAX) {
+        slot = &routes[routeCount++];
+    } else {
+        // 表满：替换最久没有听到的条目
+        slot = &routes[0];
+        for (uint8_t i = 1; i < routeCount; i++) {
+            if (nowMs - routes[i].heardMs > nowMs - slot->heardMs) {
+                slot = &routes[i];
+            }
+        }
+    }
+    slot->id = id;
+    slot->via = via;
+    slot->hops = hops;
+    slot->heardMs = nowMs;
+}
+
+void RelayRouter::learn(const SenderOptions &sender, uint32_t nowMs) {
+    uint8_t origin = binaryIdFromName(sender.name.data, sender.name.len);
+    if (sender.has(SENDER_OPT_VIA)) {
+        // 转发来的帧：最后一跳是直连邻居，源头经它可达
+        uint8_t via = (uint8_t)sender.get(SENDER_OPT_VIA);
+        uint32_t prior =
+            sender.has(SENDER_OPT_HOPS) ? sender.get(SENDER_OPT_HOPS) : 0;
+        uint8_t hops = (uint8_t)(prior + 1);
+        update(via, via, 1, nowMs);
+        update(origin, via, hops, nowMs);
+    } else {
+        update(origin, origin, 1, nowMs);
+    }
+}
+
+uint32_t RelayRouter::frameKey(const FrameFields &fields,
+                               const SenderOptions &sender) {
+    uint32_t seq = sender.has(SENDER_OPT_SEQ) ? sender.get(SENDER_OPT_SEQ) : 0;
+    uint32_t h = fnv1aHash(fields.receiver.data, fields.receiver.len);
+    h = fnv1aHash(sender.name.data, sender.name.len, h);
+    h = fnv1aHash((const char *)&seq, sizeof(seq), h);
+    h = fnv1aHash(fields.command.data, fields.command.len, h);
+    return fnv1aHash(fields.payload.data, fields.payload.len, h);
+}
+
+bool RelayRouter::seenBefore(uint32_t key, uint32_t nowMs) {
+    for (uint8_t i = 0; i < RELAY_SEEN_MAX; i++) {
+        if (seen[i] == key && key != 0 &&
+            nowMs - seenMs[i] < RELAY_SEEN_WINDOW_MS) {
+            stats.duplicates++;
+            return true;
+        }
+    }
+    seen[seenNext] = key;
+    seenMs[seenNext] = nowMs;
+    seenNext = (seenNext + 1) % RELAY_SEEN_MAX;
+    return false;
+}
+
+const RelayRoute *RelayRouter::findRoute(uint8_t id, uint32_t nowMs) const {
+    for (uint8_t i = 0; i < routeCount; i++) {
+        if (routes[i].id == id &&
+            nowMs - routes[i].heardMs < RELAY_ROUTE_EXPIRE_MS) {
+            return &routes[i];
+        }
+    }
+    return NULL;
+}
+
+bool RelayRouter::shouldForward(const FrameFields &fields,
+                                const SenderOptions &sender, uint8_t selfId,
+                                bool multicast, uint32_t nowMs) {
+    if (!enabled || !sender.has(SENDER_OPT_TTL) ||
+        sender.get(SENDER_OPT_TTL) == 0) {
+        return false;
+    }
+    if (sender.has(SENDER_OPT_VIA) && sender.get(SENDER_OPT_VIA) == selfId) {
+        return false; // 自己转发出去的帧又被听到
+    }
+    if (binaryIdFromName(sender.name.data, sender.name.len) == selfId) {
+        return false; // 自己发出的帧
+    }
+    // 路由表里已知目标、且剩余跳数不够到达时不转发，避免无效占用信道
+    const RelayRoute *route = NULL;
+    if (!multicast) {
+        route = findRoute(
+            binaryIdFromName(fields.receiver.data, fields.receiver.len), nowMs);
+    }
+    if (route != NULL && route->hops > sender.get(SENDER_OPT_TTL)) {
+        stats.outOfRange++;
+        return false;
+    }
+    stats.forwarded++;
+    return true;
+}
+
+size_t RelayRouter::formatForward(const FrameFields &fields,
+                                  const SenderOptions &sender, uint8_t selfId,
+                                  char *out, size_t cap) {
+    unsigned long ttl = sender.get(SENDER_OPT_TTL) - 1;
+    unsigned long hops =
+        (sender.has(SENDER_OPT_HOPS) ? sender.get(SENDER_OPT_HOPS) : 0) + 1;
+    int n = snprintf(out, cap, "%s:%.*s", fields.receiver.data,
+                     (int)sender.name.len, sender.name.data);
+    if (n <= 0 || (size_t)n >= cap) {
+        return 0;
+    }
+    size_t len = n;
+    // 除转发选项外的所有选项(会话号、序列号、定时、窗口、有效期等)按原样保留
+    StrView rest = fields.sender;
+    StrView token;
+    nextToken(rest, '/', token); // 跳过发送者名
+    while (nextToken(rest, '/', token)) {
+        char key = token.data[0];
+        if (key == SENDER_OPT_TTL || key == SENDER_OPT_HOPS ||
+            key == SENDER_OPT_VIA) {
+            continue;
+        }
+        if (len + 1 + token.len >= cap) {
+            return 0;
+        }
+        out[len++] = '/';
+        memcpy(out + len, token.data, token.len);
+        len += token.len;
+    }
+    n = snprintf(out + len, cap - len, "/T%lu/H%lu/V%u:%s:%s\n", ttl, hops,
+                 selfId, fields.command.data, fields.payload.data);
+    return (n > 0 && (size_t)n < cap - len) ? len + (size_t)n : 0;
+}
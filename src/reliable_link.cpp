@@ -0,0 +1,314 @@
+// --- 文件名: src/reliable_link.cpp ---
+
+#include "reliable_link.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- 设备端：序号去重 ---
+
+SeqTracker::SeqTracker() : peers(), useCounter(0) {}
+
+SeqTracker::Peer *SeqTracker::find(const char *name, size_t nameLen) {
+    for (auto &peer : peers) {
+        if (peer.used && peer.nameLen == nameLen &&
+            memcmp(peer.name, name, nameLen) == 0) {
+            return &peer;
+        }
+    }
+    return NULL;
+}
+
+SeqTracker::Peer *SeqTracker::claim(const char *name, size_t nameLen) {
+    Peer *victim = &peers[0];
+    for (auto &peer : peers) {
+        if (!peer.used) {
+            victim = &peer;
+            break;
+        }
+        if (peer.lastUsed < victim->lastUsed) {
+            victim = &peer;
+        }
+    }
+    if (nameLen > LINK_PEER_NAME_MAX) {
+        nameLen = LINK_PEER_NAME_MAX;
+    }
+    memcpy(victim->name, name, nameLen);
+    victim->name[nameLen] = '\0';
+    victim->nameLen = nameLen;
+    victim->used = true;
+    victim->mask = 0;
+    victim->failed = 0;
+    return victim;
+}
+
+SeqResult SeqTracker::accept(const char *name, size_t nameLen,
+                             uint32_t session, uint32_t seq) {
+    if (nameLen > LINK_PEER_NAME_MAX) {
+        nameLen = LINK_PEER_NAME_MAX;
+    }
+    Peer *peer = find(name, nameLen);
+    if (peer == NULL || peer->session != session) {
+        // 不知道该会话此前的序号：只有序号1能确定前面没有漏掉的命令
+        if (seq != 1) {
+            return SEQ_RESYNC;
+        }
+        if (peer == NULL) {
+            peer = claim(name, nameLen);
+        }
+        peer->session = session;
+        peer->cumulative = 0;
+        peer->mask = 0;
+        peer->failed = 0;
+        peer->acked = 0;
+    }
+    peer->lastUsed = ++useCounter;
+
+    int32_t delta = (int32_t)(seq - peer->cumulative);
+    if (delta <= 0) {
+        return SEQ_DUPLICATE;
+    }
+    if (delta > LINK_WINDOW_BITS) {
+        return SEQ_TOO_NEW;
+    }
+
+    uint32_t bit = 1UL << (delta - 1);
+    if (peer->mask & bit) {
+        return SEQ_DUPLICATE;
+    }
+    peer->mask |= bit;
+    // 位图最低位连续为1的部分并入累计序号
+    while (peer->mask & 1) {
+        peer->mask >>= 1;
+        peer->cumulative++;
+    }
+    return SEQ_NEW;
+}
+
+bool SeqTracker::inSession(const char *name, size_t nameLen,
+                           uint32_t session) {
+    if (nameLen > LINK_PEER_NAME_MAX) {
+        nameLen = LINK_PEER_NAME_MAX;
+    }
+    Peer *peer = find(name, nameLen);
+    return peer != NULL && peer->session == session;
+}
+
+bool SeqTracker::cumulativeOf(const char *name, size_t nameLen,
+                              uint32_t &cumulative) {
+    if (nameLen > LINK_PEER_NAME_MAX) {
+        nameLen = LINK_PEER_NAME_MAX;
+    }
+    Peer *peer = find(name, nameLen);
+    if (peer == NULL) {
+        return false;
+    }
+    cumulative = peer->cumulative;
+    return true;
+}
+
+void SeqTracker::recordResult(const char *name, size_t nameLen, bool ok) {
+    if (nameLen > LINK_PEER_NAME_MAX) {
+        nameLen = LINK_PEER_NAME_MAX;
+    }
+    Peer *peer = find(name, nameLen);
+    if (peer != NULL) {
+        peer->failed = peer->failed << 1 | (ok ? 0 : 1);
+    }
+}
+
+uint32_t SeqTracker::unacked(const char *name, size_t nameLen) {
+    if (nameLen > LINK_PEER_NAME_MAX) {
+        nameLen = LINK_PEER_NAME_MAX;
+    }
+    Peer *peer = find(name, nameLen);
+    return peer != NULL ? peer->cumulative - peer->acked : 0;
+}
+
+void SeqTracker::markAcked(const char *name, size_t nameLen) {
+    if (nameLen > LINK_PEER_NAME_MAX) {
+        nameLen = LINK_PEER_NAME_MAX;
+    }
+    Peer *peer = find(name, nameLen);
+    if (peer != NULL) {
+        peer->acked = peer->cumulative;
+    }
+}
+
+size_t SeqTracker::formatAck(const char *name, size_t nameLen,
+                             const char *selfID, char *out, size_t cap,
+                             bool withStatus) {
+    if (nameLen > LINK_PEER_NAME_MAX) {
+        nameLen = LINK_PEER_NAME_MAX;
+    }
+    Peer *peer = find(name, nameLen);
+    if (peer == NULL) {
+        return 0;
+    }
+    int n;
+    if (withStatus) {
+        n = snprintf(out, cap, "%s:%s:ACK:SEQ,%lu,%lx,%lx\n", peer->name,
+                     selfID, (unsigned long)peer->cumulative,
+                     (unsigned long)peer->mask, (unsigned long)peer->failed);
+    } else {
+        n = snprintf(out, cap, "%s:%s:ACK:SEQ,%lu,%lx\n", peer->name, selfID,
+                     (unsigned long)peer->cumulative,
+                     (unsigned long)peer->mask);
+    }
+    return (n > 0 && (size_t)n < cap) ? (size_t)n : 0;
+}
+
+size_t SeqTracker::formatResync(const char *name, size_t nameLen,
+                                const char *selfID, uint32_t session,
+                                char *out, size_t cap) {
+    if (nameLen > LINK_PEER_NAME_MAX) {
+        nameLen = LINK_PEER_NAME_MAX;
+    }
+    int n = snprintf(out, cap, "%.*s:%s:ACK:SEQ_RESYNC,%lu\n", (int)nameLen,
+                     name, selfID, (unsigned long)session);
+    return (n > 0 && (size_t)n < cap) ? (size_t)n : 0;
+}
+
+// --- 设备端：流水线乱序缓存 ---
+
+PipelineBuffer::PipelineBuffer() : entries() {}
+
+bool PipelineBuffer::full() const {
+    for (const auto &entry : entries) {
+        if (!entry.used) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PipelineBuffer::store(const char *name, size_t nameLen, uint32_t seq,
+                           const char *command, const char *args,
+                           const PipelineTiming &timing) {
+    size_t commandLen = strlen(command);
+    size_t argsLen = strlen(args);
+    if (commandLen > LINK_PIPE_COMMAND_MAX || argsLen > LINK_PIPE_ARGS_MAX) {
+        return false;
+    }
+    if (nameLen > LINK_PEER_NAME_MAX) {
+        nameLen = LINK_PEER_NAME_MAX;
+    }
+    for (auto &entry : entries) {
+        if (entry.used) {
+            continue;
+        }
+        entry.used = true;
+        entry.seq = seq;
+        memcpy(entry.name, name, nameLen);
+        entry.name[nameLen] = '\0';
+        entry.nameLen = nameLen;
+        entry.timing = timing;
+        memcpy(entry.command, command, commandLen + 1);
+        memcpy(entry.args, args, argsLen + 1);
+        return true;
+    }
+    return false;
+}
+
+bool PipelineBuffer::take(const char *name, size_t nameLen, uint32_t seq,
+                          const char *&command, const char *&args,
+                          PipelineTiming &timing) {
+    if (nameLen > LINK_PEER_NAME_MAX) {
+        nameLen = LINK_PEER_NAME_MAX;
+    }
+    for (auto &entry : entries) {
+        if (entry.used && entry.seq == seq && entry.nameLen == nameLen &&
+            memcmp(entry.name, name, nameLen) == 0) {
+            entry.used = false;
+            command = entry.command;
+            args = entry.args;
+            timing = entry.timing;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PipelineBuffer::drop(const char *name, size_t nameLen) {
+    if (nameLen > LINK_PEER_NAME_MAX) {
+        nameLen = LINK_PEER_NAME_MAX;
+    }
+    for (auto &entry : entries) {
+        if (entry.used && entry.nameLen == nameLen &&
+            memcmp(entry.name, name, nameLen) == 0) {
+            entry.used = false;
+        }
+    }
+}
+
+// --- 上位机端：RTT估计 ---
+
+RttEstimator::RttEstimator(uint32_t initialRtoMs, uint32_t minRtoMs,
+                           uint32_t maxRtoMs)
+    : hasSample(false), srttMs(0), rttvarMs(0), rtoMs(initialRtoMs),
+      minRto(minRtoMs), maxRto(maxRtoMs) {}
+
+void RttEstimator::sample(uint32_t rttMs) {
+    if (!hasSample) {
+        srttMs = rttMs;
+        rttvarMs = rttMs / 2;
+        hasSample = true;
+    } else {
+        // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|，SRTT = 7/8 SRTT + 1/8 R
+        uint32_t err = srttMs > rttMs ? srttMs - rttMs : rttMs - srttMs;
+        rttvarMs = (3 * rttvarMs + err) / 4;
+        srttMs = (7 * srttMs + rttMs) / 8;
+    }
+    rtoMs = srttMs + 4 * rttvarMs;
+    if (rtoMs < minRto) {
+        rtoMs = minRto;
+    }
+    if (rtoMs > maxRto) {
+        rtoMs = maxRto;
+    }
+}
+
+void RttEstimator::backoff() {
+    rtoMs = rtoMs * 2 > maxRto ? maxRto : rtoMs * 2;
+}
+
+bool parseCumulativeAck(const char *payload, uint32_t &cumulative,
+                        uint32_t &mask, uint32_t *failed) {
+    if (strncmp(payload, "SEQ,", 4) != 0) {
+        return false;
+    }
+    char *endptr;
+    cumulative = strtoul(payload + 4, &endptr, 10);
+    if (*endptr != ',') {
+        return false;
+    }
+    const char *maskStr = endptr + 1;
+    mask = strtoul(maskStr, &endptr, 16);
+    if (endptr == maskStr) {
+        return false;
+    }
+    if (failed != NULL) {
+        *failed = *endptr == ',' ? strtoul(endptr + 1, NULL, 16) : 0;
+    }
+    return true;
+}
+
+bool parseSeqResync(const char *payload, uint32_t &session) {
+    if (strncmp(payload, "SEQ_RESYNC,", 11) != 0) {
+        return false;
+    }
+    char *endptr;
+    session = strtoul(payload + 11, &endptr, 10);
+    return endptr != payload + 11 && *endptr == '\0';
+}
+
+bool seqAcknowledged(uint32_t seq, uint32_t cumulative, uint32_t mask) {
+    int32_t delta = (int32_t)(seq - cumulative);
+    if (delta <= 0) {
+        return true;
+    }
+    if (delta > LINK_WINDOW_BITS) {
+        return false;
+    }
+    return (mask >> (delta - 1)) & 1;
+}
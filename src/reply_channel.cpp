@@ -0,0 +1,33 @@
+// --- 文件名: src/reply_channel.cpp ---
+
+#include "reply_channel.h"
+#include "espnow_link.h"
+#include "tasks.h"
+
+// 与safePrintln共用互斥锁，回复帧不会被调试输出从中间打断
+static bool writeUsb(const char *data, size_t len) {
+    if (xSerialMutex == NULL ||
+        xSemaphoreTake(xSerialMutex, portMAX_DELAY) != pdTRUE) {
+        return false;
+    }
+    size_t written = Serial.write((const uint8_t *)data, len);
+    xSemaphoreGive(xSerialMutex);
+    return written == len;
+}
+
+bool sendReply(const ReplyContext &reply, const char *data, size_t len,
+               LoraTxPriority priority) {
+    switch (reply.channel) {
+    case REPLY_VIA_USB:
+        return writeUsb(data, len);
+    case REPLY_VIA_ESPNOW:
+        return espNowLink.send(data, len);
+    default:
+        return lora.sendData(data, len, priority, reply.route);
+    }
+}
+
+bool sendReply(const ReplyContext &reply, const String &data,
+               LoraTxPriority priority) {
+    return sendReply(reply, data.c_str(), data.length(), priority);
+}
@@ -0,0 +1,90 @@
+// --- 文件名: src/reply_slot.cpp ---
+
+#include "reply_slot.h"
+#include "Command.h"
+#include "binary_frame.h"
+#include "frame_parser.h"
+#include "lora_config.h"
+#include "tx_scheduler.h"
+#include <stdio.h>
+#include <string.h>
+
+ReplySlots::ReplySlots()
+    : index(0), assigned(false), width(0), aggregateUntilMs(0),
+      aggregating(false) {
+    setAirRate(LORA_AIR_RATE_BPS);
+}
+
+void ReplySlots::setIndex(uint8_t slot, uint8_t deviceNum) {
+    assigned = slot != REPLY_SLOT_AUTO;
+    if (assigned) {
+        index = slot;
+    } else if (deviceNum != BIN_ID_HOST && deviceNum != BIN_ID_BROADCAST) {
+        index = deviceNum - 1;
+    } else {
+        index = 0; // 名字中没有设备号，只能与其他同类设备共用时隙0
+    }
+}
+
+void ReplySlots::setAirRate(uint32_t airRateBps) {
+    uint32_t us = loraAirtimeUs(airRateBps, REPLY_SLOT_FRAME_BYTES) +
+                  loraAirtimeUs(airRateBps, REPLY_SLOT_NOTICE_BYTES) +
+                  REPLY_SLOT_GUARD_US;
+    width = (us + 999) / 1000;
+}
+
+uint32_t ReplySlots::dueMs(uint32_t requestMs) const {
+    return requestMs + REPLY_SLOT_LEAD_MS + (uint32_t)index * width;
+}
+
+uint32_t ReplySlots::aggregateDueMs(uint32_t nowMs) {
+    if (!aggregating || (int32_t)(nowMs - aggregateUntilMs) >= 0) {
+        // 新开一个窗口：窗口结束后再等到本机时隙，避免与其他中继的汇总帧碰撞
+        aggregateUntilMs = nowMs + REPLY_AGGREGATE_WINDOW_MS +
+                           REPLY_SLOT_LEAD_MS + (uint32_t)index * width;
+        aggregating = true;
+    }
+    return aggregateUntilMs;
+}
+
+size_t formatAggregatedAck(const char *receiver, const char *origin,
+                           size_t originLen, const char *self, uint8_t ttl,
+                           const char *payload, char *out, size_t cap) {
+    int n;
+    if (ttl > 0) {
+        n = snprintf(out, cap, "%s:%s/%c%u:%s:", receiver, self,
+                     SENDER_OPT_TTL, ttl, ACK);
+    } else {
+        n = snprintf(out, cap, "%s:%s:%s:", receiver, self, ACK);
+    }
+    if (n <= 0 || (size_t)n >= cap) {
+        return 0;
+    }
+    size_t len = n;
+    const char *item = payload;
+    while (true) {
+        const char *end = strchr(item, TX_ACK_SEPARATOR);
+        size_t itemLen = end != NULL ? (size_t)(end - item) : strlen(item);
+        bool tagged = itemLen > 0 && item[0] == REPLY_AGGREGATE_ORIGIN;
+        size_t need = (tagged ? 0 : 1 + originLen + 1) + itemLen + 1;
+        if (len + need + 1 > cap) {
+            return 0;
+        }
+        if (!tagged) {
+            out[len++] = REPLY_AGGREGATE_ORIGIN;
+            memcpy(out + len, origin, originLen);
+            len += originLen;
+            out[len++] = ',';
+        }
+        memcpy(out + len, item, itemLen);
+        len += itemLen;
+        if (end == NULL) {
+            break;
+        }
+        out[len++] = TX_ACK_SEPARATOR;
+        item = end + 1;
+    }
+    out[len++] = '\n';
+    out[len] = '\0';
+    return len;
+}
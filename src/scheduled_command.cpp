@@ -0,0 +1,114 @@
+// --- 文件名: src/scheduled_command.cpp ---
+
+#include "scheduled_command.h"
+#include "command_processor.h"
+#include "reply_slot.h"
+#include "tasks.h"
+
+CommandScheduler commandScheduler; // 全局变量定义
+
+CommandScheduler::CommandScheduler() : clock(), slots(), stats() {}
+
+void CommandScheduler::init() {
+    for (int i = 0; i < SCHED_SLOT_MAX; i++) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = &onTimer,
+            .arg = &slots[i],
+            .name = "sched-cmd"};
+        if (esp_timer_create(&timer_args, &slots[i].timer) != ESP_OK) {
+            safePrintln("FATAL: Failed to create scheduled command timer!");
+            slots[i].timer = NULL;
+        }
+    }
+}
+
+// 定时器回调：在esp_timer任务中运行，只把命令交给LoRa任务
+void CommandScheduler::onTimer(void *arg) {
+    Slot *slot = (Slot *)arg;
+    if (slot->state != SLOT_ARMED) {
+        return; // 已被cancelAll取消
+    }
+    slot->state = SLOT_FIRED;
+    if (xTaskLoRaHandle != NULL) {
+        xTaskNotifyGive(xTaskLoRaHandle);
+    }
+}
+
+void CommandScheduler::runDue() {
+    for (;;) {
+        Slot *slot = NULL;
+        for (int i = 0; i < SCHED_SLOT_MAX; i++) {
+            if (slots[i].state == SLOT_FIRED &&
+                (slot == NULL || slots[i].dueUs < slot->dueUs)) {
+                slot = &slots[i];
+            }
+        }
+        if (slot == NULL) {
+            return;
+        }
+        stats.lastLagUs = (int32_t)(esp_timer_get_time() - slot->dueUs);
+        CommandContext ctx;
+        ctx.reply = slot->reply;
+        if (ctx.reply.route.held) {
+            // 组播请求的回复：以实际执行时刻重新排定本机时隙
+            ctx.reply.route.dueMs = replySlots.dueMs(millis());
+        }
+        processCommand(slot->command, slot->args, ctx);
+        reportParamChanges(ctx.reply); // 与ACK在同一个回复时隙内
+        slot->state = SLOT_FREE;
+    }
+}
+
+bool CommandScheduler::schedule(uint32_t hostUsLow, const char *command,
+                                const char *args, const ReplyContext &reply) {
+    if (!clock.synced() || strlen(command) > SCHED_COMMAND_MAX_LEN ||
+        strlen(args) > FRAME_MAX_LEN) {
+        stats.rejected++;
+        return false;
+    }
+    int64_t now = esp_timer_get_time();
+    int64_t due = clock.hostLowToLocal(hostUsLow, now);
+    if (due - now > SCHED_MAX_AHEAD_US) {
+        stats.rejected++;
+        return false;
+    }
+    Slot *slot = NULL;
+    for (int i = 0; i < SCHED_SLOT_MAX; i++) {
+        if (slots[i].state == SLOT_FREE && slots[i].timer != NULL) {
+            slot = &slots[i];
+            break;
+        }
+    }
+    if (slot == NULL) {
+        stats.rejected++;
+        return false;
+    }
+    strcpy(slot->command, command);
+    strcpy(slot->args, args);
+    slot->reply = reply;
+    slot->dueUs = due;
+    if (due <= now) {
+        // 已经错过执行时刻：不再等定时器，LoRa任务处理完本帧后立即执行
+        stats.late++;
+        slot->state = SLOT_FIRED;
+        return true;
+    }
+    slot->state = SLOT_ARMED;
+    if (esp_timer_start_once(slot->timer, due - now) != ESP_OK) {
+        slot->state = SLOT_FREE;
+        stats.rejected++;
+        return false;
+    }
+    stats.armed++;
+    return true;
+}
+
+void CommandScheduler::cancelAll() {
+    for (int i = 0; i < SCHED_SLOT_MAX; i++) {
+        if (slots[i].state == SLOT_ARMED) {
+            esp_timer_stop(slots[i].timer);
+        }
+        // 已触发但LoRa任务尚未执行的命令同样取消；回调若正在运行，见到FREE后什么也不做
+        slots[i].state = SLOT_FREE;
+    }
+}
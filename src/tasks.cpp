@@ -11,10 +11,24 @@
 #include "Motion.h"
 #include "MyOTA.h"
 #include "Pins.h"
+#include "address_filter.h"
 #include "command_processor.h"
+#include "espnow_radio.h"
+#include "binary_frame.h"
+#include "frame_parser.h"
+#include "motion_queue.h"
+#include "param_registry.h"
+#include "param_store.h"
+#include "reliable_link.h"
+#include "relay.h"
+#include "reply_channel.h"
+#include "reply_slot.h"
+#include "scheduled_command.h"
 
 // --- 全局RTOS句柄定义 (实体) ---
+TaskHandle_t xTaskMotionHandle = NULL;
 TaskHandle_t xTaskLoRaHandle = NULL;
+TaskHandle_t xTaskLoRaTxHandle = NULL;
 TaskHandle_t xTaskOTAHandle = NULL;
 TaskHandle_t xTaskLEDHandle = NULL;
 
@@ -22,17 +36,36 @@ EventGroupHandle_t xOtaEventGroup;
 const int OTA_START_BIT = BIT0;
 const int OTA_STOP_BIT = BIT1;
 
-SemaphoreHandle_t xSerialMutex;
+SemaphoreHandle_t xSerialMutex = NULL;
 
 // --- 任务函数声明 (因为在本文件内使用，也可声明为static) ---
+static void Task_Motion(void *pvParameters);
 static void Task_LoRa(void *pvParameters);
+static void Task_LoRaTx(void *pvParameters);
 static void Task_OTA(void *pvParameters);
 static void Task_LED(void *pvParameters);
 
 // --- 公共函数定义 ---
 
 void safePrintln(String msg) {
+    if (xSerialMutex == NULL) {
+        Serial.println(msg); // 任务创建之前(setup阶段)只有一个执行流
+        return;
+    }
+    if (xSemaphoreTake(xSerialMutex, portMAX_DELAY) == pdTRUE) {
+        Serial.println(msg);
+        xSemaphoreGive(xSerialMutex);
+    }
+}
+
+void safePrintln(const char *prefix, const char *msg) {
+    if (xSerialMutex == NULL) {
+        Serial.print(prefix);
+        Serial.println(msg);
+        return;
+    }
     if (xSemaphoreTake(xSerialMutex, portMAX_DELAY) == pdTRUE) {
+        Serial.print(prefix);
         Serial.println(msg);
         xSemaphoreGive(xSerialMutex);
     }
@@ -45,13 +78,29 @@ void tasks_init() {
     // 创建事件组
     xOtaEventGroup = xEventGroupCreate();
 
+    // 创建LoRa发送队列，此后所有lora.sendData都只入队
+    lora.initTxQueue();
+
+    // 创建定时执行用的一次性定时器
+    commandScheduler.init();
+
+    // 创建运动命令队列，须在LoRa任务开始收帧之前
+    motionQueueInit();
+
     // 创建任务
     xTaskCreatePinnedToCore(Task_LED, "LED_Task", 2048, NULL, 1,
                             &xTaskLEDHandle, 1);
 
+    // 运动任务优先级高于LoRa任务：命令入队后立即执行，执行中等待串口时LoRa任务继续收帧
+    xTaskCreatePinnedToCore(Task_Motion, "Motion_Task", 3072, NULL, 4,
+                            &xTaskMotionHandle, 1);
+
     xTaskCreatePinnedToCore(Task_LoRa, "LoRa_Task", 4096, NULL, 3,
                             &xTaskLoRaHandle, 1);
 
+    xTaskCreatePinnedToCore(Task_LoRaTx, "LoRaTx_Task", 3072, NULL, 3,
+                            &xTaskLoRaTxHandle, 1);
+
     xTaskCreatePinnedToCore(Task_OTA, "OTA_Task", 8192, NULL, 2,
                             &xTaskOTAHandle, 1);
 
@@ -67,9 +116,350 @@ static void Task_LED(void *pvParameters) {
     }
 }
 
+static SeqTracker seqTracker; // 按发送者去重，只在LoRa任务中访问
+static PipelineBuffer pipeline; // 流水线模式的乱序缓存，只在LoRa任务中访问
+RelayRouter relayRouter;      // 多跳转发，只在LoRa任务中访问
+ParamStore paramStore;        // 参数版本，只在LoRa任务中访问
+
+// 运动命令的有效期(/D选项)，0表示使用默认值，见 motion_queue.h
+static uint32_t maxAgeOf(const SenderOptions &sender) {
+    return sender.has(SENDER_OPT_DEADLINE) ? sender.get(SENDER_OPT_DEADLINE)
+                                           : 0;
+}
+
+/**
+ * @brief 立即执行命令，或带/A选项时按上位机时间安排执行
+ * @param ctx 执行环境，定时执行的命令到点后按同样的方式回复
+ * @return bool 命令执行成功或已成功安排
+ */
+static bool dispatchCommand(const char *command, const char *args, bool hasAt,
+                            uint32_t atUs, const CommandContext &ctx) {
+    if (!hasAt) {
+        if (strcmp(command, STOP) == 0) {
+            commandScheduler.cancelAll(); // 立即停止时不再执行已安排的动作
+        }
+        return processCommand(command, args, ctx);
+    }
+    if (!commandScheduler.schedule(atUs, command, args, ctx.reply)) {
+        safePrintln("Scheduled command rejected: ", command);
+        return false;
+    }
+    return true;
+}
+
+static void dispatchFrame(const FrameFields &fields,
+                          const SenderOptions &sender,
+                          const CommandContext &ctx) {
+    CommandContext frameCtx = ctx;
+    frameCtx.maxAgeMs = maxAgeOf(sender);
+    dispatchCommand(fields.command.data, fields.payload.data,
+                    sender.has(SENDER_OPT_AT), sender.get(SENDER_OPT_AT),
+                    frameCtx);
+}
+
+/**
+ * @brief 流水线模式：按序号顺序执行，前面有空缺时先缓存
+ * 本帧补上空缺后，依次执行已缓存的后续命令并登记结果；
+ * 缓存的命令按各自收到的时刻和/D有效期执行，而不是本帧的
+ */
+static void executePipelined(const FrameFields &fields,
+                             const SenderOptions &sender,
+                             const CommandContext &ctx) {
+    const char *name = sender.name.data;
+    size_t nameLen = sender.name.len;
+    uint32_t seq = sender.get(SENDER_OPT_SEQ);
+    uint32_t cumulative = seq;
+    seqTracker.cumulativeOf(name, nameLen, cumulative);
+    PipelineTiming timing = {sender.has(SENDER_OPT_AT),
+                             sender.get(SENDER_OPT_AT), ctx.rxUs,
+                             maxAgeOf(sender)};
+    if ((int32_t)(cumulative - seq) < 0) {
+        // 缓存失败(命令过长)的序号到时按执行失败处理
+        if (!pipeline.store(name, nameLen, seq, fields.command.data,
+                            fields.payload.data, timing)) {
+            safePrintln("Pipelined command not buffered: ",
+                        fields.command.data);
+        }
+        return;
+    }
+
+    CommandContext cmdCtx = ctx;
+    cmdCtx.ack = false; // 结果由累计ACK的失败位图带回
+    cmdCtx.maxAgeMs = timing.maxAgeMs;
+    bool ok = dispatchCommand(fields.command.data, fields.payload.data,
+                              timing.hasAt, timing.atUs, cmdCtx);
+    seqTracker.recordResult(name, nameLen, ok);
+    for (uint32_t next = seq + 1; (int32_t)(cumulative - next) >= 0; next++) {
+        const char *command;
+        const char *args;
+        ok = false;
+        if (pipeline.take(name, nameLen, next, command, args, timing)) {
+            cmdCtx.rxUs = timing.rxUs;
+            cmdCtx.maxAgeMs = timing.maxAgeMs;
+            ok = dispatchCommand(command, args, timing.hasAt, timing.atUs,
+                                 cmdCtx);
+        }
+        seqTracker.recordResult(name, nameLen, ok);
+    }
+}
+
+/**
+ * @brief 执行一条发给本机的帧：带序列号时先去重并回复累计ACK
+ */
+static void executeFrame(const FrameFields &fields,
+                         const SenderOptions &sender,
+                         const CommandContext &ctx) {
+    if (!sender.has(SENDER_OPT_SEQ)) {
+        // 不带序列号的旧格式：直接交给处理器
+        dispatchFrame(fields, sender, ctx);
+        return;
+    }
+
+    const char *name = sender.name.data;
+    size_t nameLen = sender.name.len;
+    uint32_t seq = sender.get(SENDER_OPT_SEQ);
+    bool pipelined = sender.has(SENDER_OPT_WINDOW);
+    uint32_t cumulative;
+    if (pipelined && pipeline.full() &&
+        seqTracker.cumulativeOf(name, nameLen, cumulative) &&
+        (int32_t)(seq - cumulative) > 1) {
+        // 缓存已满，放不下新的乱序命令：不登记，等上位机重传
+        safePrintln("Pipeline buffer full, dropped: ", fields.sender.data);
+        return;
+    }
+
+    // 带序列号：重复帧只回ACK不执行，保证重传幂等
+    uint32_t session = sender.has(SENDER_OPT_SESSION)
+                           ? sender.get(SENDER_OPT_SESSION)
+                           : 0;
+    bool sameSession = seqTracker.inSession(name, nameLen, session);
+    SeqResult r = seqTracker.accept(name, nameLen, session, seq);
+    if (r == SEQ_TOO_NEW) {
+        safePrintln("Sequence outside window, dropped: ", fields.sender.data);
+        return;
+    }
+    if (r == SEQ_RESYNC) {
+        // 不知道该会话之前的序号，不执行也不确认，请上位机重新开始会话
+        safePrintln("Unknown sequence session, resync: ", fields.sender.data);
+        char resync[LINK_ACK_MAX_LEN];
+        size_t resyncLen = SeqTracker::formatResync(
+            name, nameLen, deviceID.c_str(), session, resync, sizeof(resync));
+        if (resyncLen > 0) {
+            sendReply(ctx.reply, resync, resyncLen, LORA_TX_HIGH);
+        }
+        return;
+    }
+    if (!sameSession) {
+        pipeline.drop(name, nameLen); // 上一个会话缓存的命令不再执行
+    }
+    if (r == SEQ_NEW) {
+        if (pipelined) {
+            executePipelined(fields, sender, ctx);
+        } else {
+            dispatchFrame(fields, sender, ctx);
+        }
+    } else {
+        safePrintln("Duplicate frame, not executed: ", fields.sender.data);
+    }
+
+    // 流水线：新帧的ACK先暂存，静默一段时间或攒够一个窗口再发出；
+    // 重复帧说明上位机在等ACK，立即回复；USB和ESP-NOW不占LoRa信道，也立即回复
+    ReplyContext reply = ctx.reply;
+    bool defer = pipelined && r == SEQ_NEW &&
+                 reply.channel == REPLY_VIA_LORA && !reply.route.held &&
+                 seqTracker.unacked(name, nameLen) <
+                     sender.get(SENDER_OPT_WINDOW);
+    char ack[LINK_ACK_MAX_LEN];
+    size_t ackLen = seqTracker.formatAck(name, nameLen, deviceID.c_str(), ack,
+                                         sizeof(ack), pipelined);
+    if (ackLen == 0) {
+        return;
+    }
+    if (defer) {
+        reply.route.held = true;
+        reply.route.dueMs = millis() + LINK_PIPE_ACK_DELAY_MS;
+    } else {
+        seqTracker.markAcked(name, nameLen);
+    }
+    sendReply(reply, ack, ackLen, LORA_TX_HIGH);
+}
+
+/**
+ * @brief 处理一条完整的LoRa消息 (已去掉结尾的'\n')
+ * 原地分词，整个过程不做堆分配
+ * @param frame 帧缓冲区 RECEIVER:SENDER:COMMAND:PAYLOAD
+ * @param len 帧长度
+ * @param channel 帧从哪个通道收到，回复发回同一通道
+ */
+static void handleLoRaFrame(char *frame, size_t len, ReplyChannel channel) {
+    if (len == 0) {
+        return; // STOP标记前后的空行
+    }
+    CommandContext ctx;
+    ctx.reply.channel = channel;
+    ctx.rxUs = esp_timer_get_time();
+    if (isStopToken(frame, len)) {
+        // 输出已在接收回调中关闭，这里按普通STOP补全其余动作并回复
+        safePrintln("Receive: STOP token");
+        ctx.reply.route.held = true;
+        ctx.reply.route.dueMs = replySlots.dueMs(millis());
+        dispatchCommand(STOP, "", false, 0, ctx);
+        return;
+    }
+    safePrintln("Receive: ", frame);
+
+    // 1. 原地切分四个字段（必须至少有3个冒号）
+    FrameFields fields;
+    if (!tokenizeFrame(frame, len, fields)) {
+        safePrintln("Invalid protocol format received: ", frame);
+        return;
+    }
+
+    SenderOptions sender;
+    if (!parseSenderOptions(fields.sender, sender)) {
+        safePrintln("Invalid sender options: ", fields.sender.data);
+        return;
+    }
+
+    // 2. 任何听到的帧都用来学习邻居和路由；经转发的帧可能收到多份，只处理一次
+    uint32_t nowMs = millis();
+    relayRouter.learn(sender, nowMs);
+    if ((sender.has(SENDER_OPT_TTL) || sender.has(SENDER_OPT_VIA)) &&
+        relayRouter.seenBefore(RelayRouter::frameKey(fields, sender), nowMs)) {
+        return;
+    }
+
+    // 3. 检查是否为本机消息(单播、广播或本机所在的组)
+    AddressMatch target =
+        addressFilter.match(fields.receiver.data, fields.receiver.len);
+    if (AddressFilter::isForMe(target)) {
+        if (sender.name.equals(hostID.c_str(), hostID.length()) &&
+            sender.has(SENDER_OPT_VIA)) {
+            // 回复需要经过与请求相同的跳数才能回到上位机
+            // 只有/V没有/H的帧按经过0跳处理
+            uint32_t hops = sender.has(SENDER_OPT_HOPS)
+                                ? sender.get(SENDER_OPT_HOPS)
+                                : 0;
+            ctx.reply.route.ttl = (uint8_t)(hops + 1);
+        }
+        // 组播请求：所有收到的设备同时处理，回复错开到各自的时隙
+        if (AddressFilter::isMulticast(target)) {
+            ctx.reply.route.held = true;
+            ctx.reply.route.dueMs = replySlots.dueMs(nowMs);
+        }
+        executeFrame(fields, sender, ctx);
+        reportParamChanges(ctx.reply); // 通知与ACK在同一个回复时隙内发出
+    }
+
+    // 4. 不是只发给我的帧：中继模式下TTL减一后转发
+    if (target == ADDR_SELF) {
+        return;
+    }
+    bool multicast = AddressFilter::isMulticast(target);
+    if (relayRouter.shouldForward(fields, sender, deviceNum, multicast,
+                                  nowMs)) {
+        char relayed[LORA_TX_FRAME_MAX + 1];
+        size_t relayedLen;
+        LoraTxRoute route;
+        if (relayRouter.isAggregating() && fields.command.equals(ACK) &&
+            fields.receiver.equals(hostID.c_str(), hostID.length())) {
+            // 下游发给上位机的ACK：改写后暂存，汇总窗口结束时合并成一帧
+            relayedLen = formatAggregatedAck(
+                fields.receiver.data, sender.name.data, sender.name.len,
+                deviceID.c_str(), (uint8_t)(sender.get(SENDER_OPT_TTL) - 1),
+                fields.payload.data, relayed, sizeof(relayed));
+            route.held = true;
+            route.dueMs = replySlots.aggregateDueMs(nowMs);
+        } else {
+            relayedLen = RelayRouter::formatForward(
+                fields, sender, deviceNum, relayed, sizeof(relayed));
+        }
+        if (relayedLen > 0) {
+            lora.sendData(relayed, relayedLen, LORA_TX_NORMAL, route);
+        }
+    } else if (target == ADDR_OTHER) {
+        safePrintln("Ignoring command for other device: ",
+                    fields.receiver.data);
+    }
+}
+
+/**
+ * @brief 处理一条二进制帧：校验CRC后还原为文本命令，复用同一个命令处理器
+ * @param wire 同步字节与结束符之间的COBS数据
+ * @param len 数据长度
+ * @param channel 帧从哪个通道收到，回复发回同一通道
+ */
+static void handleBinaryFrame(const uint8_t *wire, size_t len,
+                              ReplyChannel channel) {
+    BinaryFrame frame;
+    if (!decodeBinaryFrame(wire, len, frame)) {
+        safePrintln("Invalid binary frame (COBS/CRC) dropped.");
+        return;
+    }
+    if (frame.receiver != deviceNum && frame.receiver != BIN_ID_BROADCAST) {
+        return; // 不是发给我的
+    }
+    const char *command = binaryOpcodeName(frame.opcode);
+    char args[FRAME_MAX_LEN + 1];
+    if (!binaryArgsToText(frame, args, sizeof(args))) {
+        safePrintln("Invalid binary arguments dropped: ", command);
+        return;
+    }
+    safePrintln("Receive binary: ", command);
+    CommandContext ctx;
+    ctx.reply.channel = channel;
+    ctx.rxUs = esp_timer_get_time();
+    if (frame.receiver == BIN_ID_BROADCAST) {
+        ctx.reply.route.held = true;
+        ctx.reply.route.dueMs = replySlots.dueMs(millis());
+    }
+    processCommand(command, args, ctx);
+    reportParamChanges(ctx.reply);
+}
+
+// 接收回调识别到STOP标记时调用，运行在UART事件任务中
+// 运动任务可能正在启动运动：haltOutputs记下的停止计数让它不再打开输出
+static void fastStop() {
+    motion.haltOutputs();
+    commandScheduler.cancelAll(); // esp_timer_stop可跨任务调用
+    motionQueueFlush(); // 尚未执行的运动命令(含已取出的)不再执行
+}
+
+/**
+ * @brief 把收到的一段字节逐个送入帧缓冲区，每凑齐一帧立即分派
+ * @param channel 数据来自哪个通道，回复发回同一通道
+ */
+static void pushRxBytes(FrameBuffer &frameBuffer, const uint8_t *data,
+                        size_t n, ReplyChannel channel) {
+    for (size_t i = 0; i < n; i++) {
+        FramePushResult r = frameBuffer.push((char)data[i]);
+        if (r == FRAME_READY) {
+            // 收到一个完整的消息 (以 '\n' 结尾)，立即分派
+            handleLoRaFrame(frameBuffer.data(), frameBuffer.length(), channel);
+            frameBuffer.reset();
+        } else if (r == FRAME_READY_BINARY) {
+            handleBinaryFrame((const uint8_t *)frameBuffer.data(),
+                              frameBuffer.length(), channel);
+            frameBuffer.reset();
+        } else if (r == FRAME_OVERFLOW) {
+            safePrintln("Frame too long, dropped.");
+        }
+    }
+}
+
+// USB串口接收事件回调，只负责唤醒LoRa任务
+static void onUsbReceive() {
+    if (xTaskLoRaHandle != NULL) {
+        xTaskNotifyGive(xTaskLoRaHandle);
+    }
+}
+
 static void Task_LoRa(void *pvParameters) {
-    String receivedData = "";
-    char endMarker = '\n';
+    static FrameBuffer frameBuffer; // 定长帧缓冲区，放在静态区避免占用任务栈
+    static FrameBuffer usbFrameBuffer; // USB串口与LoRa各自组帧，互不打断
+    uint8_t rxChunk[LORA_RX_CHUNK_SIZE];
+    static EspNowRxFrame espNowRx;
+    static char espNowFrame[ESPNOW_FRAME_MAX + 1];
 
     // 检查本机DeviceID是否有效，无效则持续警告且不处理任何指令
     if (deviceID == "" || deviceID == "unknown") {
@@ -82,63 +472,70 @@ static void Task_LoRa(void *pvParameters) {
     }
 
     safePrintln("Device ID is: " + deviceID);
+    relayRouter.setEnabled(RELAY_MODE_DEFAULT);
 
-    String paramsPayload = motion.getAllParamsAsString();
+    // 每次上电换一个纪元号，上位机据此知道之前的参数版本已失效
+    paramStore.begin(motion.getParams(), (uint16_t)(esp_random() % 0xFFFF + 1));
+    char paramsPayload[PARAM_REPORT_MAX + 1];
+    paramFormatAll(motion.getParams(), paramsPayload, sizeof(paramsPayload));
     String reportMsg = hostID + ":" + deviceID + ":" + REPORT_ALL_PARAMS + ":" +
                        paramsPayload + "\n";
-    lora.sendData(reportMsg);
+    lora.sendData(reportMsg, LORA_TX_LOW);
     safePrintln("Initial parameters reported to HOST.");
 
+    // 串口收到数据时由UART事件回调搬运并唤醒本任务，而不是固定周期轮询
+    // STOP标记在回调中就已生效，不必等本任务排队处理
+    lora.setStopHandler(fastStop);
+    lora.enableRxEvents();
+    Serial.onReceive(onUsbReceive);
+    espNowSetEnabled(ESPNOW_DEFAULT); // 与邻居之间的近距离链路，见espnow_link.h
+
     for (;;) {
-        if (Serial1.available() > 0) {
-            char inChar = Serial1.read();
-            if (inChar != endMarker) {
-                receivedData += inChar;
-            } else {
-                // 收到一个完整的消息 (以 '\n' 结尾)
-                safePrintln("Receive: " + receivedData);
-                // 1. 寻找三个分隔符的位置
-                int firstColon = receivedData.indexOf(':');
-                int secondColon = receivedData.indexOf(':', firstColon + 1);
-                int thirdColon = receivedData.indexOf(':', secondColon + 1);
-                // 2. 检查协议格式是否基本正确（必须至少有3个冒号）
-                if (firstColon > 0 && secondColon > firstColon &&
-                    thirdColon > secondColon) {
-
-                    // 3. 提取接收者ID
-                    String receiver = receivedData.substring(0, firstColon);
-
-                    // 4. 检查是否为本机消息
-                    if (receiver == deviceID || receiver == "ALL") {
-
-                        // 是发给我的，继续解析其他部分
-                        String sender =
-                            receivedData.substring(firstColon + 1, secondColon);
-                        String command =
-                            receivedData.substring(secondColon + 1, thirdColon);
-                        String payload = receivedData.substring(thirdColon + 1);
-
-                        // 清理可能存在的空格
-                        command.trim();
-                        payload.trim();
-
-                        // 5. 将分离好的命令和参数交给处理器
-                        processCommand(command, payload);
-
-                    } else {
-                        // 不是发给我的消息，直接忽略 (未来可用于设备间转发)
-                        safePrintln("Ignoring command for other device: " +
-                                    receiver);
-                    }
-                } else {
-                    safePrintln("Invalid protocol format received: " +
-                                receivedData);
-                }
+        // 阻塞等待接收事件；超时只是兜底，正常情况下不会依赖它
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LORA_RX_IDLE_POLL_MS));
+        commandScheduler.runDue(); // 定时器到点唤醒：先执行，再处理收到的帧
+
+        // 只要还有数据就一直批量读取，期间不休眠
+        // 模块处于配置模式时串口上是配置回复，回调不搬运，留给发送任务读取
+        size_t n;
+        while ((n = lora.readRx(rxChunk, sizeof(rxChunk))) > 0) {
+            pushRxBytes(frameBuffer, rxChunk, n, REPLY_VIA_LORA);
+        }
+
+        // 台架上位机经USB串口发来的帧，回复写回USB(见reply_channel.h)
+        int available;
+        while ((available = Serial.available()) > 0) {
+            size_t toRead = available < LORA_RX_CHUNK_SIZE ? available
+                                                           : LORA_RX_CHUNK_SIZE;
+            n = Serial.read(rxChunk, toRead);
+            pushRxBytes(usbFrameBuffer, rxChunk, n, REPLY_VIA_USB);
+        }
 
-                receivedData = "";
+        // 邻居经ESP-NOW发来的帧与LoRa帧走同一个处理流程，回复发回ESP-NOW
+        while (espNowReceive(espNowRx)) {
+            size_t len = espNowLink.receive(espNowRx.mac, espNowRx.data,
+                                            espNowRx.len, millis(), espNowFrame,
+                                            sizeof(espNowFrame));
+            if (len > 0) {
+                handleLoRaFrame(espNowFrame, len, REPLY_VIA_ESPNOW);
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
+        espNowService(millis());
+        commandScheduler.runDue(); // 本轮收到的帧中已错过执行时刻的命令
+    }
+}
+
+// 依次执行运动命令队列中的命令，见 motion_queue.h
+static void Task_Motion(void *pvParameters) {
+    for (;;) {
+        motionQueueServe(portMAX_DELAY);
+    }
+}
+
+// 唯一负责写Serial1的任务：按优先级依次发送队列中的帧
+static void Task_LoRaTx(void *pvParameters) {
+    for (;;) {
+        lora.processTxQueue(portMAX_DELAY);
     }
 }
 
@@ -164,7 +561,7 @@ static void Task_OTA(void *pvParameters) {
                     String ipAddress = WiFi.localIP().toString();
                     String response = hostID + ":" + deviceID +
                                       ":REPORT_IP:" + ipAddress + "\n";
-                    lora.sendData(response);
+                    lora.sendData(response, LORA_TX_LOW);
 
                     while (isOtaRunning) {
                         ota.handle();
@@ -181,6 +578,7 @@ static void Task_OTA(void *pvParameters) {
                     ledStatus.setStatus(LED_ERROR);
                     safePrintln("OTA Task: Failed to connect to WiFi.");
                     ota.end();
+                    espNowWifiReleased();
                 }
             } else {
                 safePrintln("OTA Task: Service is already running.");
@@ -191,6 +589,7 @@ static void Task_OTA(void *pvParameters) {
             if (isOtaRunning) {
                 safePrintln("OTA Task: Stopping service...");
                 ota.end();
+                espNowWifiReleased(); // WiFi已关闭，由LoRa任务重新开启ESP-NOW
                 isOtaRunning = false;
                 ledStatus.setStatus(LED_STANDBY);
                 safePrintln("OTA service stopped.");
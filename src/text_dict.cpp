@@ -0,0 +1,83 @@
+// --- 文件名: src/text_dict.cpp ---
+
+#include "text_dict.h"
+#include "frame_parser.h"
+#include <string.h>
+
+// 词条都是字符串字面量，长度在编译期取得
+#define TEXT_DICT_LEN(word) (uint8_t)(sizeof(word) - 1),
+static constexpr uint8_t textDictLens[] = {TEXT_DICT_WORDS(TEXT_DICT_LEN)};
+#undef TEXT_DICT_LEN
+
+static size_t wordLen(size_t index) { return textDictLens[index]; }
+
+const char *textDictWord(uint8_t code, size_t &len) {
+    if (code < TEXT_DICT_CODE_BASE ||
+        code >= TEXT_DICT_CODE_BASE + TEXT_DICT_SIZE) {
+        return NULL;
+    }
+    size_t index = code - TEXT_DICT_CODE_BASE;
+    len = wordLen(index);
+    return textDictWords[index];
+}
+
+size_t textDictCompress(char *data, size_t len) {
+    size_t in = 0;
+    size_t out = 0;
+    while (in < len) {
+        size_t best = TEXT_DICT_SIZE;
+        size_t bestLen = 0;
+        for (size_t i = 0; i < TEXT_DICT_SIZE; i++) {
+            size_t n = wordLen(i);
+            if (n > bestLen && n >= TEXT_DICT_MIN_WORD && n <= len - in &&
+                data[in] == textDictWords[i][0] &&
+                memcmp(data + in, textDictWords[i], n) == 0) {
+                best = i;
+                bestLen = n;
+            }
+        }
+        if (best < TEXT_DICT_SIZE) {
+            data[out++] = (char)(TEXT_DICT_CODE_BASE + best);
+            in += bestLen;
+        } else {
+            data[out++] = data[in++];
+        }
+    }
+    return out;
+}
+
+size_t textDictExpand(const char *in, size_t len, char *out, size_t cap) {
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        size_t wordLen;
+        const char *word = textDictWord((uint8_t)in[i], wordLen);
+        if (word == NULL) {
+            word = in + i;
+            wordLen = 1;
+        }
+        if (n + wordLen > cap) {
+            return 0;
+        }
+        memcpy(out + n, word, wordLen);
+        n += wordLen;
+    }
+    return n;
+}
+
+void textDictMeasure(const char *capture, size_t len, TextDictStats &stats) {
+    char frame[FRAME_MAX_LEN + 1];
+    size_t start = 0;
+    while (start < len) {
+        const char *end =
+            (const char *)memchr(capture + start, '\n', len - start);
+        size_t frameLen =
+            (end != NULL ? (size_t)(end - capture) + 1 : len) - start;
+        if (frameLen <= sizeof(frame)) {
+            memcpy(frame, capture + start, frameLen);
+            stats.frames++;
+            stats.rawBytes += frameLen;
+            stats.compressedBytes += textDictCompress(frame, frameLen);
+        }
+        start += frameLen;
+    }
+}
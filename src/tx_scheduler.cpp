@@ -0,0 +1,229 @@
+// --- 文件名: src/tx_scheduler.cpp ---
+
+#include "tx_scheduler.h"
+#include "Command.h"
+#include "lora_config.h"
+#include <string.h>
+
+// 帧头切片：RECEIVER:SENDER:COMMAND:PAYLOAD\n
+struct FrameHead {
+    const char *receiver;
+    size_t receiverLen;
+    const char *sender;
+    size_t senderLen; // 只含发送者名，不含/T等选项
+    const char *command;
+    size_t commandLen;
+    const char *payload;
+    size_t payloadLen; // 不含结尾的'\n'
+};
+
+static bool splitHead(const LoraTxFrame &f, FrameHead &h) {
+    const char *colons[3];
+    int found = 0;
+    for (size_t i = 0; i < f.len && found < 3; i++) {
+        if (f.data[i] == ':') {
+            colons[found++] = f.data + i;
+        }
+    }
+    if (found < 3) {
+        return false;
+    }
+    size_t len = f.len;
+    while (len > 0 && (f.data[len - 1] == '\n' || f.data[len - 1] == '\r')) {
+        len--;
+    }
+    h.receiver = f.data;
+    h.receiverLen = colons[0] - f.data;
+    h.sender = colons[0] + 1;
+    const char *opts = (const char *)memchr(h.sender, '/',
+                                            colons[1] - h.sender);
+    h.senderLen = (opts != NULL ? opts : colons[1]) - h.sender;
+    h.command = colons[1] + 1;
+    h.commandLen = colons[2] - colons[1] - 1;
+    h.payload = colons[2] + 1;
+    h.payloadLen = f.data + len - h.payload;
+    return true;
+}
+
+static bool sliceIs(const char *s, size_t len, const char *word) {
+    return strncmp(s, word, len) == 0 && word[len] == '\0';
+}
+
+// 转发的帧也经过本调度器：发送者不同的帧既不能互相覆盖，也不能合并
+static bool sameRoute(const FrameHead &a, const FrameHead &b) {
+    return a.receiverLen == b.receiverLen &&
+           memcmp(a.receiver, b.receiver, a.receiverLen) == 0 &&
+           a.senderLen == b.senderLen &&
+           memcmp(a.sender, b.sender, a.senderLen) == 0;
+}
+
+static bool sameCommand(const FrameHead &a, const FrameHead &b) {
+    return a.commandLen == b.commandLen &&
+           memcmp(a.command, b.command, a.commandLen) == 0;
+}
+
+// 只有最新一份有意义的状态上报
+// LINK_STATS不在其中：各页(TX/AUX/NET)内容不同，后请求的页不能覆盖前一页
+static bool isStateReport(const FrameHead &h) {
+    return sliceIs(h.command, h.commandLen, REPORT_ALL_PARAMS) ||
+           sliceIs(h.command, h.commandLen, "REPORT_IP");
+}
+
+static bool isAck(const FrameHead &h) {
+    return sliceIs(h.command, h.commandLen, ACK);
+}
+
+// 累计ACK：新的累计序号总是覆盖旧的
+static bool isSeqAck(const FrameHead &h) {
+    return isAck(h) && h.payloadLen >= 4 && memcmp(h.payload, "SEQ,", 4) == 0;
+}
+
+TxScheduler::TxScheduler(uint32_t airRateBps, uint32_t dutyPermille,
+                         uint32_t windowMs)
+    : count(0), airRate(airRateBps), duty(dutyPermille), window(windowMs),
+      tokensUs(0), lastRefillMs(0), windowStartMs(0), windowUsedUs(0),
+      started(false), stats() {
+    stats.budgetPermille = dutyPermille;
+}
+
+uint32_t TxScheduler::airtimeUs(size_t len) const {
+    return loraAirtimeUs(airRate, len);
+}
+
+void TxScheduler::refill(uint32_t nowMs) {
+    uint32_t capacityUs = window * duty; // window(ms) * duty(‰) = 微秒
+    if (!started) {
+        started = true;
+        tokensUs = capacityUs; // 启动时预算是满的
+        lastRefillMs = nowMs;
+        windowStartMs = nowMs;
+    }
+    uint32_t elapsed = nowMs - lastRefillMs;
+    lastRefillMs = nowMs;
+    uint64_t tokens = (uint64_t)tokensUs + (uint64_t)elapsed * duty;
+    tokensUs = tokens > capacityUs ? capacityUs : (uint32_t)tokens;
+
+    // 滚动统计窗口
+    if (nowMs - windowStartMs >= window) {
+        stats.dutyPermille = windowUsedUs / window;
+        windowUsedUs = 0;
+        windowStartMs = nowMs;
+    }
+}
+
+void TxScheduler::remove(int index) {
+    for (int i = index; i < count - 1; i++) {
+        staged[i] = staged[i + 1];
+    }
+    count--;
+}
+
+bool TxScheduler::due(int index, uint32_t nowMs) const {
+    return !staged[index].held || (int32_t)(nowMs - staged[index].dueMs) >= 0;
+}
+
+bool TxScheduler::stage(const LoraTxFrame &frame) {
+    FrameHead head;
+    if (splitHead(frame, head) && (isStateReport(head) || isSeqAck(head))) {
+        for (int i = 0; i < count; i++) {
+            FrameHead old;
+            if (splitHead(staged[i], old) && sameRoute(head, old) &&
+                sameCommand(head, old) && isSeqAck(old) == isSeqAck(head)) {
+                // 用新内容覆盖尚未发送的旧帧，保留原来的排队位置
+                uint8_t priority = staged[i].priority < frame.priority
+                                       ? staged[i].priority
+                                       : frame.priority;
+                staged[i] = frame;
+                staged[i].priority = priority;
+                stats.superseded++;
+                return true;
+            }
+        }
+    }
+    if (full()) {
+        return false;
+    }
+    staged[count++] = frame;
+    return true;
+}
+
+bool TxScheduler::next(uint32_t nowMs, LoraTxFrame &out, uint32_t &waitMs) {
+    waitMs = 0;
+    if (count == 0) {
+        return false;
+    }
+    refill(nowMs);
+
+    // 1. 已到时刻的帧中优先级最高的最早一帧；都没到时刻就等最早的那一帧
+    int best = -1;
+    uint32_t soonestMs = UINT32_MAX;
+    for (int i = 0; i < count; i++) {
+        if (!due(i, nowMs)) {
+            uint32_t left = staged[i].dueMs - nowMs;
+            soonestMs = left < soonestMs ? left : soonestMs;
+        } else if (best < 0 || staged[i].priority < staged[best].priority) {
+            best = i;
+        }
+    }
+    if (best < 0) {
+        waitMs = soonestMs;
+        return false;
+    }
+    out = staged[best];
+    remove(best);
+
+    // 2. ACK：把同一目标的其他ACK负载合并进来，只占一次前导码和报头
+    FrameHead head;
+    if (splitHead(out, head) && isAck(head)) {
+        size_t len = head.payload + head.payloadLen - out.data;
+        for (int i = 0; i < count;) {
+            FrameHead other;
+            // 未到时刻的ACK不能提前合并发出，否则会占用别人的时隙
+            if (due(i, nowMs) && splitHead(staged[i], other) && isAck(other) &&
+                sameRoute(head, other) &&
+                len + 1 + other.payloadLen + 1 <= LORA_TX_FRAME_MAX) {
+                out.data[len++] = TX_ACK_SEPARATOR;
+                memcpy(out.data + len, other.payload, other.payloadLen);
+                len += other.payloadLen;
+                if (staged[i].priority < out.priority) {
+                    out.priority = staged[i].priority;
+                }
+                remove(i);
+                stats.coalesced++;
+            } else {
+                i++;
+            }
+        }
+        out.data[len++] = '\n';
+        out.data[len] = '\0';
+        out.len = len;
+    }
+
+    // 3. 空中时间预算：不足时放回去等待，期间新来的帧还能继续合并
+    // 比整个预算桶还大的帧在预算满时放行，避免永远发不出去
+    uint32_t capacityUs = window * duty;
+    uint32_t cost = airtimeUs(out.len);
+    if (cost > tokensUs && tokensUs < capacityUs) {
+        for (int i = count; i > 0; i--) {
+            staged[i] = staged[i - 1];
+        }
+        staged[0] = out;
+        count++;
+        stats.throttled++;
+        uint32_t needUs = cost < capacityUs ? cost : capacityUs;
+        waitMs = (needUs - tokensUs + duty - 1) / duty;
+        return false;
+    }
+    if (out.held) {
+        stats.slotted++;
+    }
+    tokensUs = cost > tokensUs ? 0 : tokensUs - cost;
+    windowUsedUs += cost;
+    stats.airtimeUs += cost;
+    return true;
+}
+
+TxSchedulerStats TxScheduler::getStats(uint32_t nowMs) {
+    refill(nowMs);
+    return stats;
+}
@@ -0,0 +1,152 @@
+// --- 文件名: test/test_binary_frame/test_binary_frame.cpp ---
+// 二进制帧编解码：往返、参数ID校验，以及还原文本PAYLOAD时的出错处理
+// 运行：pio test -e native -f test_binary_frame
+
+#include "Command.h"
+#include "binary_frame.h"
+#include "param_registry.h"
+#include <string.h>
+#include <unity.h>
+
+void setUp() {}
+void tearDown() {}
+
+// 编码后去掉同步字节和结束符，得到 decodeBinaryFrame 的输入
+static size_t encodeToWire(const BinaryFrame &frame, uint8_t *wire,
+                           size_t cap) {
+    uint8_t out[BIN_MAX_WIRE_LEN];
+    size_t n = encodeBinaryFrame(frame, out, sizeof(out));
+    TEST_ASSERT_TRUE(n >= 3 && n - 2 <= cap);
+    memcpy(wire, out + 1, n - 2);
+    return n - 2;
+}
+
+static void roundTrip(const char *command, const char *args) {
+    BinaryFrame frame = {};
+    uint8_t opcode;
+    TEST_ASSERT_TRUE(binaryOpcodeFromName(command, opcode));
+    TEST_ASSERT_TRUE(binaryArgsFromText(opcode, args, frame));
+    frame.receiver = 0x01;
+    frame.sender = BIN_ID_HOST;
+
+    uint8_t wire[BIN_MAX_WIRE_LEN];
+    size_t len = encodeToWire(frame, wire, sizeof(wire));
+    BinaryFrame decoded;
+    TEST_ASSERT_TRUE(decodeBinaryFrame(wire, len, decoded));
+    TEST_ASSERT_EQUAL_STRING(command, binaryOpcodeName(decoded.opcode));
+
+    char text[128];
+    TEST_ASSERT_TRUE(binaryArgsToText(decoded, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING(args, text);
+}
+
+static void test_round_trip() {
+    roundTrip(Forward, "");
+    roundTrip(ENABLE_STEP_MODE, "1");
+    roundTrip(SET_BATCH_PARAMS, "VOLTAGE:60;DUTY:12.50;FWD_PHASE:90.00");
+    roundTrip(GET_PARAM, "FWD_FREQ");
+    roundTrip(PARAM_SCHEMA, "");
+    roundTrip(PARAM_SCHEMA, "4");
+    roundTrip(PARAM_DELTA, "");
+    roundTrip(PARAM_DELTA, "0A3F,17");
+    roundTrip(LINK_STATS, "AUX");
+    roundTrip(LINK_STATS, "NET");
+}
+
+// 参数名、ID和缩放都来自参数注册表
+static void test_params_follow_registry() {
+    for (size_t i = 0; i < paramCount(); i++) {
+        const ParamDescriptor *param = paramAt(i);
+        uint8_t id = 0;
+        TEST_ASSERT_EQUAL_STRING(param->name, binaryParamName(param->id));
+        TEST_ASSERT_TRUE(
+            binaryParamFromName(param->name, strlen(param->name), id));
+        TEST_ASSERT_EQUAL(param->id, id);
+    }
+}
+
+static void test_rejects_unknown_param_id() {
+    BinaryFrame frame = {};
+    frame.receiver = 0x01;
+    frame.opcode = BIN_OP_SET_BATCH_PARAMS;
+    frame.paramCount = 2;
+    frame.params[0] = {BIN_PARAM_VOLTAGE, 60};
+    frame.params[1] = {0x1F, 5}; // 注册表中没有的ID
+    TEST_ASSERT_NULL(paramFindById(0x1F));
+
+    uint8_t wire[BIN_MAX_WIRE_LEN];
+    size_t len = encodeToWire(frame, wire, sizeof(wire));
+    BinaryFrame decoded;
+    TEST_ASSERT_FALSE(decodeBinaryFrame(wire, len, decoded));
+
+    frame.opcode = BIN_OP_GET_PARAM;
+    frame.paramCount = 1;
+    frame.params[0].id = 0x1F;
+    len = encodeToWire(frame, wire, sizeof(wire));
+    TEST_ASSERT_FALSE(decodeBinaryFrame(wire, len, decoded));
+}
+
+// 失败时输出总是以'\0'结尾的空串，不会留下写了一半的PAYLOAD
+static void test_args_to_text_always_terminates() {
+    BinaryFrame frame = {};
+    frame.opcode = BIN_OP_SET_BATCH_PARAMS;
+    frame.paramCount = 2;
+    frame.params[0] = {BIN_PARAM_VOLTAGE, 60};
+    frame.params[1] = {0x1F, 5};
+    char text[64];
+    memset(text, 'x', sizeof(text));
+    TEST_ASSERT_FALSE(binaryArgsToText(frame, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("", text);
+
+    // 缓冲区不足
+    frame.paramCount = 1;
+    memset(text, 'x', sizeof(text));
+    TEST_ASSERT_FALSE(binaryArgsToText(frame, text, 8));
+    TEST_ASSERT_EQUAL_STRING("", text);
+
+    // 页号越界
+    frame.opcode = BIN_OP_LINK_STATS;
+    frame.params[0] = {0, 7};
+    memset(text, 'x', sizeof(text));
+    TEST_ASSERT_FALSE(binaryArgsToText(frame, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("", text);
+
+    // 无参数命令返回true且输出空串
+    frame.opcode = BIN_OP_STOP;
+    frame.paramCount = 0;
+    memset(text, 'x', sizeof(text));
+    TEST_ASSERT_TRUE(binaryArgsToText(frame, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("", text);
+}
+
+static void test_rejects_bad_text() {
+    BinaryFrame frame;
+    TEST_ASSERT_FALSE(
+        binaryArgsFromText(BIN_OP_SET_BATCH_PARAMS, "NOPE:1", frame));
+    TEST_ASSERT_FALSE(binaryArgsFromText(BIN_OP_GET_PARAM, "NOPE", frame));
+    TEST_ASSERT_FALSE(binaryArgsFromText(BIN_OP_LINK_STATS, "RX", frame));
+    TEST_ASSERT_FALSE(binaryArgsFromText(BIN_OP_PARAM_DELTA, "12", frame));
+    TEST_ASSERT_FALSE(binaryArgsFromText(BIN_OP_PARAM_DELTA, "XY,1", frame));
+}
+
+static void test_rejects_corrupted_crc() {
+    BinaryFrame frame = {};
+    frame.receiver = 0x02;
+    frame.opcode = BIN_OP_FORWARD;
+    uint8_t wire[BIN_MAX_WIRE_LEN];
+    size_t len = encodeToWire(frame, wire, sizeof(wire));
+    wire[len - 1] ^= 0x01;
+    BinaryFrame decoded;
+    TEST_ASSERT_FALSE(decodeBinaryFrame(wire, len, decoded));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_params_follow_registry);
+    RUN_TEST(test_rejects_unknown_param_id);
+    RUN_TEST(test_args_to_text_always_terminates);
+    RUN_TEST(test_rejects_bad_text);
+    RUN_TEST(test_rejects_corrupted_crc);
+    return UNITY_END();
+}
@@ -0,0 +1,322 @@
+// --- 文件名: test/test_espnow_link/test_espnow_link.cpp ---
+// ESP-NOW传输逻辑：用回环无线代替ESP-IDF，几个虚拟设备共用一段"空中"
+// 回环无线与 espnow_radio.cpp 的行为一致：单播只能发给addPeer过的MAC，
+// 广播所有设备都能收到，对端表有上限；发出的帧先排队，由deliver()依次送达
+// 检查邻居发现、单播/广播的选择、对端表的增删，以及交给命令处理的帧内容
+// 运行：pio test -e native -f test_espnow_link
+
+#include "binary_frame.h"
+#include "espnow_link.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unity.h>
+#include <vector>
+
+#define SIM_NODES_MAX 20
+#define SIM_RADIO_PEER_MAX 20 // ESP-NOW非加密对端上限
+
+void setUp() {}
+void tearDown() {}
+
+struct SimPacket {
+    int from;
+    uint8_t to[ESPNOW_MAC_LEN];
+    std::string data;
+};
+
+struct SimDevice {
+    char name[16];
+    uint8_t mac[ESPNOW_MAC_LEN];
+    EspNowLink link;
+    std::vector<std::vector<uint8_t>> radioPeers; // 无线层的对端表
+    std::vector<std::string> delivered; // receive交给命令处理的帧
+    int removed;                        // removePeer的调用次数
+};
+
+// 无线接口只有函数指针，没有上下文：调用设备的EspNowLink之前先记下是哪台设备
+static struct LoopbackAir *air = NULL;
+static int current = -1;
+
+struct LoopbackAir {
+    SimDevice devices[SIM_NODES_MAX];
+    int count;
+    std::vector<SimPacket> pending;
+    bool reach[SIM_NODES_MAX][SIM_NODES_MAX]; // reach[a][b]: b能听到a
+    uint32_t nowMs;
+
+    explicit LoopbackAir(int n) : count(n), nowMs(0) {
+        air = this;
+        for (int a = 0; a < n; a++) {
+            for (int b = 0; b < n; b++) {
+                reach[a][b] = a != b;
+            }
+        }
+        for (int k = 0; k < n; k++) {
+            SimDevice &d = devices[k];
+            snprintf(d.name, sizeof(d.name), "SR_%02d", k + 1);
+            const uint8_t mac[ESPNOW_MAC_LEN] = {0x24, 0x0A, 0xC4,
+                                                 0x00, 0x00, (uint8_t)k};
+            memcpy(d.mac, mac, ESPNOW_MAC_LEN);
+            d.removed = 0;
+            current = k;
+            d.link.begin(&radio, d.name, binaryIdFromName(d.name));
+        }
+        current = -1;
+    }
+
+    static const EspNowRadio radio;
+
+    static std::vector<std::vector<uint8_t>>::iterator
+    findRadioPeer(SimDevice &d, const uint8_t *mac) {
+        for (auto it = d.radioPeers.begin(); it != d.radioPeers.end(); ++it) {
+            if (memcmp(it->data(), mac, ESPNOW_MAC_LEN) == 0) {
+                return it;
+            }
+        }
+        return d.radioPeers.end();
+    }
+
+    static bool radioSend(const uint8_t *mac, const uint8_t *data,
+                          size_t len) {
+        SimDevice &d = air->devices[current];
+        bool broadcast = memcmp(mac, ESPNOW_BROADCAST_MAC, ESPNOW_MAC_LEN) == 0;
+        if (!broadcast && findRadioPeer(d, mac) == d.radioPeers.end()) {
+            return false; // 与 esp_now_send 相同：未添加的对端不能单播
+        }
+        SimPacket p;
+        p.from = current;
+        memcpy(p.to, mac, ESPNOW_MAC_LEN);
+        p.data.assign((const char *)data, len);
+        air->pending.push_back(p);
+        return true;
+    }
+
+    static bool radioAddPeer(const uint8_t *mac) {
+        SimDevice &d = air->devices[current];
+        if (findRadioPeer(d, mac) != d.radioPeers.end()) {
+            return true;
+        }
+        if (d.radioPeers.size() >= SIM_RADIO_PEER_MAX) {
+            return false;
+        }
+        d.radioPeers.push_back(std::vector<uint8_t>(mac, mac + ESPNOW_MAC_LEN));
+        return true;
+    }
+
+    static void radioRemovePeer(const uint8_t *mac) {
+        SimDevice &d = air->devices[current];
+        auto it = findRadioPeer(d, mac);
+        if (it != d.radioPeers.end()) {
+            d.radioPeers.erase(it);
+        }
+        d.removed++;
+    }
+
+    bool send(int k, const char *frame) {
+        current = k;
+        bool ok = devices[k].link.send(frame, strlen(frame));
+        current = -1;
+        return ok;
+    }
+
+    void poll(int k) {
+        current = k;
+        devices[k].link.poll(nowMs);
+        current = -1;
+    }
+
+    void pollAll() {
+        for (int k = 0; k < count; k++) {
+            poll(k);
+        }
+    }
+
+    // 把排队的帧送到能听到的设备，收到的设备在receive中可能再发出帧
+    void deliver() {
+        while (!pending.empty()) {
+            SimPacket p = pending.front();
+            pending.erase(pending.begin());
+            bool broadcast =
+                memcmp(p.to, ESPNOW_BROADCAST_MAC, ESPNOW_MAC_LEN) == 0;
+            for (int k = 0; k < count; k++) {
+                SimDevice &d = devices[k];
+                if (!reach[p.from][k] ||
+                    (!broadcast && memcmp(p.to, d.mac, ESPNOW_MAC_LEN) != 0)) {
+                    continue;
+                }
+                char out[ESPNOW_FRAME_MAX + 1];
+                current = k;
+                size_t len = d.link.receive(
+                    devices[p.from].mac, (const uint8_t *)p.data.data(),
+                    p.data.size(), nowMs, out, sizeof(out));
+                current = -1;
+                if (len > 0) {
+                    d.delivered.push_back(std::string(out, len));
+                }
+            }
+        }
+    }
+};
+
+const EspNowRadio LoopbackAir::radio = {LoopbackAir::radioSend,
+                                        LoopbackAir::radioAddPeer,
+                                        LoopbackAir::radioRemovePeer};
+
+static void test_hello_discovers_neighbours() {
+    LoopbackAir sim(3);
+    sim.pollAll();
+    sim.deliver();
+    for (int k = 0; k < 3; k++) {
+        EspNowLink &link = sim.devices[k].link;
+        TEST_ASSERT_EQUAL(2, link.peerCount());
+        TEST_ASSERT_EQUAL(1, link.getStats().broadcast);
+        // 邻居发现帧在链路层消化，不交给命令处理
+        TEST_ASSERT_EQUAL(0, sim.devices[k].delivered.size());
+    }
+    const EspNowPeer *peer = sim.devices[0].link.findPeer(2);
+    TEST_ASSERT_NOT_NULL(peer);
+    TEST_ASSERT_EQUAL_MEMORY(sim.devices[1].mac, peer->mac, ESPNOW_MAC_LEN);
+
+    char peers[32];
+    sim.devices[0].link.formatPeers(peers, sizeof(peers));
+    TEST_ASSERT_EQUAL_STRING("2,3", peers);
+
+    // 周期未到不再广播
+    sim.nowMs += ESPNOW_HELLO_MS - 1;
+    sim.pollAll();
+    TEST_ASSERT_EQUAL(0, sim.pending.size());
+    sim.nowMs += 1;
+    sim.pollAll();
+    TEST_ASSERT_EQUAL(3, sim.pending.size());
+}
+
+static void test_unknown_receiver_is_broadcast_then_unicast() {
+    LoopbackAir sim(3);
+    // 还不认识SR_02：广播，SR_02和SR_03都收到，是否执行由地址过滤决定
+    TEST_ASSERT_TRUE(sim.send(0, "SR_02:SR_01:M_F:100\n"));
+    sim.deliver();
+    TEST_ASSERT_EQUAL(1, sim.devices[0].link.getStats().broadcast);
+    TEST_ASSERT_EQUAL(1, sim.devices[1].delivered.size());
+    TEST_ASSERT_EQUAL(1, sim.devices[2].delivered.size());
+    TEST_ASSERT_EQUAL_STRING("SR_02:SR_01:M_F:100",
+                             sim.devices[1].delivered[0].c_str());
+
+    // SR_02回复之后SR_01学到它的MAC，之后单播，SR_03听不到
+    TEST_ASSERT_TRUE(sim.send(1, "SR_01:SR_02:ACK:M_F\n"));
+    sim.deliver();
+    TEST_ASSERT_EQUAL(1, sim.devices[0].delivered.size());
+    TEST_ASSERT_TRUE(sim.send(0, "SR_02:SR_01:STOP:\n"));
+    sim.deliver();
+    TEST_ASSERT_EQUAL(1, sim.devices[0].link.getStats().sent);
+    TEST_ASSERT_EQUAL(2, sim.devices[1].delivered.size());
+    TEST_ASSERT_EQUAL(1, sim.devices[2].delivered.size());
+}
+
+static void test_multicast_addresses_are_broadcast() {
+    LoopbackAir sim(3);
+    sim.pollAll();
+    sim.deliver();
+    // 组、区间、位图地址末尾的数字不是设备号，不能单播给某个邻居
+    const char *frames[] = {"ALL:SR_01:STOP:\n", "@2:SR_01:STOP:\n",
+                            "#2-3:SR_01:STOP:\n", "$6:SR_01:STOP:\n"};
+    for (const char *frame : frames) {
+        TEST_ASSERT_TRUE(sim.send(0, frame));
+    }
+    sim.deliver();
+    TEST_ASSERT_EQUAL(0, sim.devices[0].link.getStats().sent);
+    TEST_ASSERT_EQUAL(5, sim.devices[0].link.getStats().broadcast);
+    TEST_ASSERT_EQUAL(4, sim.devices[1].delivered.size());
+    TEST_ASSERT_EQUAL(4, sim.devices[2].delivered.size());
+}
+
+static void test_own_and_malformed_frames() {
+    LoopbackAir sim(2);
+    char out[ESPNOW_FRAME_MAX + 1];
+    EspNowLink &link = sim.devices[0].link;
+    current = 0;
+    // 中继回来的自己的帧不处理，也不把自己记为邻居
+    const char *own = "SR_02:SR_01/T1:M_F:\n";
+    TEST_ASSERT_EQUAL(0, link.receive(sim.devices[1].mac, (const uint8_t *)own,
+                                      strlen(own), 0, out, sizeof(out)));
+    TEST_ASSERT_EQUAL(0, link.peerCount());
+
+    const char *bad = "NO_FIELDS\n";
+    TEST_ASSERT_EQUAL(0, link.receive(sim.devices[1].mac, (const uint8_t *)bad,
+                                      strlen(bad), 0, out, sizeof(out)));
+    TEST_ASSERT_EQUAL(1, link.getStats().dropped);
+
+    // 发送者选项不影响学习：按去掉选项后的名字记下设备号
+    const char *relayed = "SR_01:SR_02/S5/T2:M_B:\n";
+    size_t len = link.receive(sim.devices[1].mac, (const uint8_t *)relayed,
+                              strlen(relayed), 0, out, sizeof(out));
+    TEST_ASSERT_EQUAL(strlen(relayed) - 1, len);
+    TEST_ASSERT_NOT_NULL(link.findPeer(2));
+
+    std::string tooLong = "SR_02:SR_01:SET_PARAM:" +
+                          std::string(ESPNOW_FRAME_MAX, 'A') + "\n";
+    TEST_ASSERT_FALSE(link.send(tooLong.c_str(), tooLong.size()));
+    TEST_ASSERT_EQUAL(2, link.getStats().dropped);
+    current = -1;
+}
+
+static void test_peers_expire_and_follow_mac_changes() {
+    LoopbackAir sim(2);
+    sim.pollAll();
+    sim.deliver();
+    TEST_ASSERT_EQUAL(1, sim.devices[0].link.peerCount());
+    TEST_ASSERT_EQUAL(1, sim.devices[0].radioPeers.size());
+
+    // SR_02换了板子：同一设备号换成新的MAC，旧的对端从无线层移除
+    sim.devices[1].mac[5] = 0x42;
+    sim.nowMs += 1;
+    TEST_ASSERT_TRUE(sim.send(1, "SR_01:SR_02:ACK:M_F\n"));
+    sim.deliver();
+    const EspNowPeer *peer = sim.devices[0].link.findPeer(2);
+    TEST_ASSERT_NOT_NULL(peer);
+    TEST_ASSERT_EQUAL_HEX8(0x42, peer->mac[5]);
+    TEST_ASSERT_EQUAL(1, sim.devices[0].removed);
+    TEST_ASSERT_EQUAL(1, sim.devices[0].radioPeers.size());
+
+    // 超过ESPNOW_PEER_EXPIRE_MS没有再听到：移除，之后发给它的帧改为广播
+    sim.reach[1][0] = false;
+    for (uint32_t t = 0; t <= ESPNOW_PEER_EXPIRE_MS; t += ESPNOW_HELLO_MS) {
+        sim.nowMs += ESPNOW_HELLO_MS;
+        sim.pollAll();
+        sim.deliver();
+    }
+    TEST_ASSERT_EQUAL(0, sim.devices[0].link.peerCount());
+    TEST_ASSERT_EQUAL(0, sim.devices[0].radioPeers.size());
+    uint32_t broadcast = sim.devices[0].link.getStats().broadcast;
+    TEST_ASSERT_TRUE(sim.send(0, "SR_02:SR_01:STOP:\n"));
+    TEST_ASSERT_EQUAL(broadcast + 1, sim.devices[0].link.getStats().broadcast);
+}
+
+static void test_full_table_replaces_oldest() {
+    // 邻居比表大：最久没听到的邻居让位，无线层的对端数不超过表的大小
+    const int devices = ESPNOW_PEER_MAX + 3;
+    TEST_ASSERT_TRUE(devices <= SIM_NODES_MAX);
+    LoopbackAir sim(devices);
+    for (int k = 1; k < devices; k++) {
+        sim.nowMs += 10;
+        sim.poll(k);
+        sim.deliver();
+    }
+    EspNowLink &link = sim.devices[0].link;
+    TEST_ASSERT_EQUAL(ESPNOW_PEER_MAX, link.peerCount());
+    TEST_ASSERT_EQUAL(ESPNOW_PEER_MAX, sim.devices[0].radioPeers.size());
+    TEST_ASSERT_NULL(link.findPeer(2)); // 最早听到的两个被替换
+    TEST_ASSERT_NULL(link.findPeer(3));
+    TEST_ASSERT_NOT_NULL(link.findPeer((uint8_t)devices));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_hello_discovers_neighbours);
+    RUN_TEST(test_unknown_receiver_is_broadcast_then_unicast);
+    RUN_TEST(test_multicast_addresses_are_broadcast);
+    RUN_TEST(test_own_and_malformed_frames);
+    RUN_TEST(test_peers_expire_and_follow_mac_changes);
+    RUN_TEST(test_full_table_replaces_oldest);
+    return UNITY_END();
+}
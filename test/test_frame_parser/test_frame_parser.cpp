@@ -0,0 +1,340 @@
+// --- 文件名: test/test_frame_parser/test_frame_parser.cpp ---
+// FrameBuffer / tokenizeFrame / parseSenderOptions 的单元测试，
+// 以及与原来String逐字节拼接+substring解析方式的吞吐量对比
+// 运行：pio test -e native -f test_frame_parser
+
+#include "Command.h"
+#include "frame_parser.h"
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <unity.h>
+
+// 统计堆分配次数，用于验证解析过程不分配内存
+static size_t heapAllocs = 0;
+
+void *operator new(size_t size) {
+    heapAllocs++;
+    void *p = malloc(size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+void setUp() {}
+void tearDown() {}
+
+// 逐字节送入，返回最后一个字节的结果
+static FramePushResult pushAll(FrameBuffer &fb, const char *s, size_t n) {
+    FramePushResult r = FRAME_PENDING;
+    for (size_t i = 0; i < n; i++) {
+        r = fb.push(s[i]);
+    }
+    return r;
+}
+
+static void test_frame_ready_on_newline() {
+    FrameBuffer fb;
+    const char *frame = "SR_01:HOST:M_F:\n";
+    TEST_ASSERT_EQUAL(FRAME_READY, pushAll(fb, frame, strlen(frame)));
+    TEST_ASSERT_EQUAL_STRING("SR_01:HOST:M_F:", fb.data());
+    TEST_ASSERT_EQUAL(15, fb.length());
+}
+
+static void test_overlong_frame_dropped_whole() {
+    FrameBuffer fb;
+    for (int i = 0; i < FRAME_MAX_LEN + 10; i++) {
+        TEST_ASSERT_EQUAL(FRAME_PENDING, fb.push('A'));
+    }
+    TEST_ASSERT_EQUAL(FRAME_OVERFLOW, fb.push('\n'));
+    // 溢出后缓冲区已复位，下一帧正常
+    const char *next = "SR_01:HOST:STOP:\n";
+    TEST_ASSERT_EQUAL(FRAME_READY, pushAll(fb, next, strlen(next)));
+    TEST_ASSERT_EQUAL_STRING("SR_01:HOST:STOP:", fb.data());
+}
+
+static void test_frame_at_max_len_accepted() {
+    FrameBuffer fb;
+    for (int i = 0; i < FRAME_MAX_LEN; i++) {
+        fb.push('A');
+    }
+    TEST_ASSERT_EQUAL(FRAME_READY, fb.push('\n'));
+    TEST_ASSERT_EQUAL(FRAME_MAX_LEN, fb.length());
+}
+
+static void test_binary_frame_uses_zero_terminator() {
+    FrameBuffer fb;
+    TEST_ASSERT_EQUAL(FRAME_PENDING, fb.push((char)BIN_FRAME_SYNC));
+    TEST_ASSERT_EQUAL(FRAME_PENDING, fb.push('\n')); // 二进制帧中的'\n'不是结束符
+    TEST_ASSERT_EQUAL(FRAME_PENDING, fb.push(0x42));
+    TEST_ASSERT_EQUAL(FRAME_READY_BINARY, fb.push(0x00));
+    TEST_ASSERT_EQUAL(2, fb.length());
+}
+
+static void test_tokenize_trims_fields() {
+    char frame[] = "SR_01:HOST: SET_BATCH_PARAMS :VOLTAGE:12;DUTY:50\r";
+    FrameFields f;
+    TEST_ASSERT_TRUE(tokenizeFrame(frame, strlen(frame), f));
+    TEST_ASSERT_EQUAL_STRING("SR_01", f.receiver.data);
+    TEST_ASSERT_EQUAL_STRING("HOST", f.sender.data);
+    TEST_ASSERT_EQUAL_STRING("SET_BATCH_PARAMS", f.command.data);
+    // 只切前三个冒号，负载中的冒号保留
+    TEST_ASSERT_EQUAL_STRING("VOLTAGE:12;DUTY:50", f.payload.data);
+}
+
+static void test_tokenize_rejects_bad_frames() {
+    char twoColons[] = "SR_01:HOST:M_F";
+    char noReceiver[] = ":HOST:M_F:";
+    FrameFields f;
+    TEST_ASSERT_FALSE(tokenizeFrame(twoColons, strlen(twoColons), f));
+    TEST_ASSERT_FALSE(tokenizeFrame(noReceiver, strlen(noReceiver), f));
+}
+
+static void test_sender_options() {
+    StrView sender = {"HOST/S17/W8/D250", 16};
+    SenderOptions opt;
+    TEST_ASSERT_TRUE(parseSenderOptions(sender, opt));
+    TEST_ASSERT_TRUE(opt.name.equals("HOST"));
+    TEST_ASSERT_TRUE(opt.has(SENDER_OPT_SEQ));
+    TEST_ASSERT_EQUAL_UINT32(17, opt.get(SENDER_OPT_SEQ));
+    TEST_ASSERT_EQUAL_UINT32(8, opt.get(SENDER_OPT_WINDOW));
+    TEST_ASSERT_EQUAL_UINT32(250, opt.get(SENDER_OPT_DEADLINE));
+    TEST_ASSERT_FALSE(opt.has(SENDER_OPT_TTL));
+
+    StrView bad = {"HOST/s1", 7};
+    TEST_ASSERT_FALSE(parseSenderOptions(bad, opt));
+    StrView noValue = {"HOST/S", 6};
+    TEST_ASSERT_FALSE(parseSenderOptions(noValue, opt));
+
+    // 不存在的选项读出0，不是上一帧留下的值
+    StrView withHops = {"HOST/H7/V3", 10};
+    TEST_ASSERT_TRUE(parseSenderOptions(withHops, opt));
+    StrView viaOnly = {"HOST/V3", 7};
+    TEST_ASSERT_TRUE(parseSenderOptions(viaOnly, opt));
+    TEST_ASSERT_EQUAL_UINT32(0, opt.get(SENDER_OPT_HOPS));
+
+    // 溢出uint32_t的值整帧拒绝，/A 的时间可以用满32位
+    StrView maxAt = {"HOST/A4294967295", 16};
+    TEST_ASSERT_TRUE(parseSenderOptions(maxAt, opt));
+    TEST_ASSERT_EQUAL_UINT32(4294967295UL, opt.get(SENDER_OPT_AT));
+    StrView overflow = {"HOST/A4294967296", 16};
+    TEST_ASSERT_FALSE(parseSenderOptions(overflow, opt));
+    StrView elevenDigits = {"HOST/S00000000001", 17};
+    TEST_ASSERT_FALSE(parseSenderOptions(elevenDigits, opt));
+}
+
+static void test_next_token() {
+    StrView rest = {"A:1;;B:2", 8};
+    StrView t;
+    TEST_ASSERT_TRUE(nextToken(rest, ';', t));
+    TEST_ASSERT_TRUE(t.equals("A:1"));
+    TEST_ASSERT_TRUE(nextToken(rest, ';', t));
+    TEST_ASSERT_TRUE(t.empty());
+    TEST_ASSERT_TRUE(nextToken(rest, ';', t));
+    TEST_ASSERT_TRUE(t.equals("B:2"));
+    TEST_ASSERT_FALSE(nextToken(rest, ';', t));
+}
+
+static void test_stop_token_only_at_frame_boundary() {
+    StopTokenDetector d;
+    const char *frame = "SR_01:HOST:M_F:\x1B\x1B\x1B\n";
+    bool fired = false;
+    for (size_t i = 0; i < strlen(frame); i++) {
+        fired |= d.push((uint8_t)frame[i]);
+    }
+    TEST_ASSERT_FALSE(fired); // 帧中间的ESC不是停止标记
+
+    int count = 0;
+    const char *stop = STOP_FAST;
+    for (size_t i = 0; i < strlen(stop); i++) {
+        count += d.push((uint8_t)stop[i]) ? 1 : 0;
+    }
+    TEST_ASSERT_EQUAL(1, count);
+}
+
+// --- 吞吐量对比 ---
+
+static const char *benchFrames[] = {
+    "SR_01:HOST/S17:SET_BATCH_PARAMS:VOLTAGE:40;DUTY:50.00;FWD_FREQ:20000\n",
+    "ALL:HOST:M_F:\n",
+    "SR_01:HOST/S18/W8:STEP_MODE:1\n",
+    "SR_02:HOST:REPORT_ALL_PARAMS:\n",
+};
+#define BENCH_ROUNDS 50000
+
+// 原来的接收方式：String逐字节拼接，每帧5次substring和2次trim
+// LegacyString按Arduino-ESP32 WString的策略管理内存：15字节以内放在对象内部，
+// 更长时按实际需要的大小realloc，每次+=都可能重新分配
+static size_t legacyAllocs = 0;
+
+class LegacyString {
+  public:
+    LegacyString() : heap(NULL), len(0), cap(sizeof(sso) - 1) { sso[0] = 0; }
+    LegacyString(const char *s, size_t n) : LegacyString() { assign(s, n); }
+    LegacyString(const LegacyString &o) : LegacyString() {
+        assign(o.c_str(), o.len);
+    }
+    ~LegacyString() { free(heap); }
+
+    void operator+=(char c) {
+        reserve(len + 1);
+        buffer()[len++] = c;
+        buffer()[len] = '\0';
+    }
+    const char *c_str() const { return heap != NULL ? heap : sso; }
+    size_t length() const { return len; }
+
+    int indexOf(char c, size_t from = 0) const {
+        const char *p = (const char *)memchr(c_str() + from, c, len - from);
+        return p != NULL ? (int)(p - c_str()) : -1;
+    }
+    LegacyString substring(size_t from, size_t to) const {
+        return LegacyString(c_str() + from, to - from);
+    }
+    LegacyString substring(size_t from) const { return substring(from, len); }
+    void trim() {
+        const char *b = c_str();
+        size_t n = len;
+        while (n > 0 && isspace((unsigned char)*b)) {
+            b++;
+            n--;
+        }
+        while (n > 0 && isspace((unsigned char)b[n - 1])) {
+            n--;
+        }
+        memmove(buffer(), b, n);
+        len = n;
+        buffer()[len] = '\0';
+    }
+
+  private:
+    char *buffer() { return heap != NULL ? heap : sso; }
+    void reserve(size_t n) {
+        if (n <= cap) {
+            return;
+        }
+        bool wasSso = heap == NULL;
+        char *next = (char *)realloc(heap, n + 1);
+        legacyAllocs++;
+        if (wasSso) {
+            memcpy(next, sso, len + 1);
+        }
+        heap = next;
+        cap = n;
+    }
+    void assign(const char *s, size_t n) {
+        reserve(n);
+        memcpy(buffer(), s, n);
+        len = n;
+        buffer()[len] = '\0';
+    }
+
+    char sso[16];
+    char *heap;
+    size_t len;
+    size_t cap;
+};
+
+static size_t legacyParse(const char *frame, size_t &checksum) {
+    LegacyString received;
+    for (const char *p = frame; *p != '\n'; p++) {
+        received += *p;
+    }
+    int c1 = received.indexOf(':');
+    int c2 = c1 < 0 ? -1 : received.indexOf(':', c1 + 1);
+    int c3 = c2 < 0 ? -1 : received.indexOf(':', c2 + 1);
+    if (c3 < 0) {
+        return 0;
+    }
+    LegacyString receiver = received.substring(0, c1);
+    LegacyString sender = received.substring(c1 + 1, c2);
+    LegacyString rest = received.substring(c2 + 1);
+    LegacyString command = rest.substring(0, c3 - c2 - 1);
+    LegacyString payload = rest.substring(c3 - c2);
+    command.trim();
+    payload.trim();
+    checksum += receiver.length() + sender.length() + command.length() +
+                payload.length();
+    return 1;
+}
+
+static size_t currentParse(FrameBuffer &fb, const char *frame,
+                           size_t &checksum) {
+    size_t parsed = 0;
+    for (const char *p = frame; *p != '\0'; p++) {
+        if (fb.push(*p) == FRAME_READY) {
+            FrameFields f;
+            if (tokenizeFrame(fb.data(), fb.length(), f)) {
+                checksum += f.receiver.len + f.sender.len + f.command.len +
+                            f.payload.len;
+                parsed++;
+            }
+            fb.reset();
+        }
+    }
+    return parsed;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+}
+
+static void test_throughput_against_string_parsing() {
+    const size_t n = sizeof(benchFrames) / sizeof(benchFrames[0]);
+    size_t legacySum = 0;
+    size_t currentSum = 0;
+    FrameBuffer fb;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (size_t i = 0; i < n; i++) {
+            legacyParse(benchFrames[i], legacySum);
+        }
+    }
+    double legacySec = secondsSince(start);
+
+    size_t allocsBefore = heapAllocs;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (size_t i = 0; i < n; i++) {
+            currentParse(fb, benchFrames[i], currentSum);
+        }
+    }
+    double currentSec = secondsSince(start);
+    size_t currentAllocs = heapAllocs - allocsBefore;
+
+    // 两种方式切出的字段长度一致
+    TEST_ASSERT_EQUAL_UINT32(legacySum, currentSum);
+    TEST_ASSERT_EQUAL_UINT32(0, currentAllocs);
+
+    double frames = (double)BENCH_ROUNDS * n;
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "String: %.0f frames/s, %.1f allocs/frame; FrameBuffer: %.0f "
+             "frames/s, 0 allocs/frame",
+             frames / legacySec, legacyAllocs / frames, frames / currentSec);
+    TEST_MESSAGE(msg);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_frame_ready_on_newline);
+    RUN_TEST(test_overlong_frame_dropped_whole);
+    RUN_TEST(test_frame_at_max_len_accepted);
+    RUN_TEST(test_binary_frame_uses_zero_terminator);
+    RUN_TEST(test_tokenize_trims_fields);
+    RUN_TEST(test_tokenize_rejects_bad_frames);
+    RUN_TEST(test_sender_options);
+    RUN_TEST(test_next_token);
+    RUN_TEST(test_stop_token_only_at_frame_boundary);
+    RUN_TEST(test_throughput_against_string_parsing);
+    return UNITY_END();
+}
@@ -0,0 +1,84 @@
+// --- 文件名: test/test_param_batch/test_param_batch.cpp ---
+// SET_BATCH_PARAMS 的整批暂存：全部条目先检查并写入快照副本，
+// 任一条失败则整批不提交，ACK中每个条目各有一个结果码
+// 按 handle_SetBatchParams 的做法暂存，提交(Motion::applyParams)在设备上进行
+// 运行：pio test -e native -f test_param_batch
+
+#include "Pins.h"
+#include "param_registry.h"
+#include <cstring>
+#include <string>
+#include <unity.h>
+
+void setUp() {}
+void tearDown() {}
+
+static MotionParams defaults() {
+    MotionParams p = {DEFAULT_VOLTAGE,   DEFAULT_DUTY_CYCLE, DEFAULT_FWD_FREQ,
+                      DEFAULT_FWD_PHASE, DEFAULT_BWD_FREQ,   DEFAULT_BWD_PHASE,
+                      100.0f,            100.0f,             false,
+                      false};
+    return p;
+}
+
+// 按 handle_SetBatchParams 的做法暂存一批 NAME:VALUE;NAME:VALUE
+static void stageAll(ParamBatch &batch, const char *args) {
+    std::string rest = args;
+    size_t start = 0;
+    while (start <= rest.size()) {
+        size_t end = rest.find(';', start);
+        if (end == std::string::npos) {
+            end = rest.size();
+        }
+        if (end > start) {
+            paramBatchStage(batch, rest.data() + start, end - start);
+        }
+        start = end + 1;
+    }
+}
+
+static void test_batch_commits_only_when_all_valid() {
+    MotionParams current = defaults();
+    ParamBatch batch;
+    paramBatchBegin(batch, current);
+    stageAll(batch, "VOLTAGE:40;DUTY:30.5;FWD_FREQ:25000");
+    TEST_ASSERT_TRUE(batch.valid);
+    TEST_ASSERT_EQUAL_STRING("000", batch.results);
+    TEST_ASSERT_EQUAL(40, batch.shadow.voltage);
+    TEST_ASSERT_EQUAL_FLOAT(30.5f, batch.shadow.dutyCycle);
+    TEST_ASSERT_EQUAL_UINT32(25000, batch.shadow.forwardFreq);
+    TEST_ASSERT_EQUAL_UINT32(DEFAULT_BWD_FREQ, batch.shadow.backwardFreq);
+
+    // 一条失败则整批不提交，但每一条都有自己的结果码
+    paramBatchBegin(batch, current);
+    stageAll(batch, "VOLTAGE:40;DUTY:120;SPEED:3;VOLTAGE:50;"
+                    "STEP_MODE_ENABLED:1;BWD_PHASE;FWD_PHASE:45");
+    TEST_ASSERT_FALSE(batch.valid);
+    TEST_ASSERT_EQUAL_STRING("0RUDWF0", batch.results);
+    // 失败的条目不写入暂存区，当前参数本身从未改动
+    TEST_ASSERT_EQUAL_FLOAT(DEFAULT_DUTY_CYCLE, batch.shadow.dutyCycle);
+    TEST_ASSERT_EQUAL(DEFAULT_VOLTAGE, current.voltage);
+}
+
+static void test_batch_limit() {
+    ParamBatch batch;
+    paramBatchBegin(batch, defaults());
+    std::string args;
+    for (int i = 0; i < PARAM_BATCH_MAX + 3; i++) {
+        args += "DUTY:50;";
+    }
+    stageAll(batch, args.c_str());
+    // 第一条成功，其余重复；超过上限的只记一个'X'
+    TEST_ASSERT_EQUAL(PARAM_BATCH_MAX + 1, strlen(batch.results));
+    TEST_ASSERT_EQUAL('0', batch.results[0]);
+    TEST_ASSERT_EQUAL('D', batch.results[PARAM_BATCH_MAX - 1]);
+    TEST_ASSERT_EQUAL('X', batch.results[PARAM_BATCH_MAX]);
+    TEST_ASSERT_FALSE(batch.valid);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_batch_commits_only_when_all_valid);
+    RUN_TEST(test_batch_limit);
+    return UNITY_END();
+}
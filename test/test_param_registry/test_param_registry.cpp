@@ -0,0 +1,149 @@
+// --- 文件名: test/test_param_registry/test_param_registry.cpp ---
+// 参数注册表：按名字和ID查找、数值解析、上报与参数说明分页
+// 上报能被 SET_BATCH_PARAMS 原样解析回来(整批暂存的检查见 test_param_batch)
+// 运行：pio test -e native -f test_param_registry
+
+#include "Pins.h"
+#include "binary_frame.h"
+#include "param_registry.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unity.h>
+
+void setUp() {}
+void tearDown() {}
+
+static MotionParams defaults() {
+    MotionParams p = {DEFAULT_VOLTAGE,   DEFAULT_DUTY_CYCLE, DEFAULT_FWD_FREQ,
+                      DEFAULT_FWD_PHASE, DEFAULT_BWD_FREQ,   DEFAULT_BWD_PHASE,
+                      100.0f,            100.0f,             false,
+                      false};
+    return p;
+}
+
+// 按 handle_SetBatchParams 的做法暂存一批 NAME:VALUE;NAME:VALUE
+static void stageAll(ParamBatch &batch, const char *args) {
+    std::string rest = args;
+    size_t start = 0;
+    while (start <= rest.size()) {
+        size_t end = rest.find(';', start);
+        if (end == std::string::npos) {
+            end = rest.size();
+        }
+        if (end > start) {
+            paramBatchStage(batch, rest.data() + start, end - start);
+        }
+        start = end + 1;
+    }
+}
+
+static void test_lookup_by_name_and_id() {
+    TEST_ASSERT_TRUE(paramCount() > 0);
+    for (size_t i = 0; i < paramCount(); i++) {
+        const ParamDescriptor *param = paramAt(i);
+        TEST_ASSERT_NOT_NULL(param);
+        TEST_ASSERT_EQUAL_PTR(param,
+                              paramFind(param->name, strlen(param->name)));
+        TEST_ASSERT_EQUAL_PTR(param, paramFindById(param->id));
+    }
+    TEST_ASSERT_NULL(paramAt(paramCount()));
+    TEST_ASSERT_EQUAL_UINT8(BIN_PARAM_DUTY, paramFind("DUTY", 4)->id);
+
+    // 名字不必以'\0'结尾；前缀、加长、大小写不同都找不到
+    TEST_ASSERT_NOT_NULL(paramFind("DUTY:42", 4));
+    TEST_ASSERT_NULL(paramFind("DUT", 3));
+    TEST_ASSERT_NULL(paramFind("DUTYX", 5));
+    TEST_ASSERT_NULL(paramFind("duty", 4));
+    TEST_ASSERT_NULL(paramFind("", 0));
+    TEST_ASSERT_NULL(paramFindById(0));
+    TEST_ASSERT_NULL(paramFindById(PARAM_ID_LIMIT));
+}
+
+static void test_parse_types_and_ranges() {
+    const ParamDescriptor &voltage = *paramFind("VOLTAGE", 7);
+    const ParamDescriptor &duty = *paramFind("DUTY", 4);
+    float v = 0;
+    TEST_ASSERT_EQUAL(PARAM_OK, paramParse(voltage, "80", 2, v));
+    TEST_ASSERT_EQUAL_FLOAT(80, v);
+    TEST_ASSERT_EQUAL(PARAM_ERR_RANGE, paramParse(voltage, "81", 2, v));
+    TEST_ASSERT_EQUAL(PARAM_ERR_RANGE, paramParse(voltage, "-1", 2, v));
+    // 整数参数不接受小数
+    TEST_ASSERT_EQUAL(PARAM_ERR_FORMAT, paramParse(voltage, "12.5", 4, v));
+    TEST_ASSERT_EQUAL(PARAM_OK, paramParse(duty, "12.5", 4, v));
+    TEST_ASSERT_EQUAL_FLOAT(12.5f, v);
+    TEST_ASSERT_EQUAL(PARAM_ERR_RANGE, paramParse(duty, "0", 1, v));
+    TEST_ASSERT_EQUAL(PARAM_ERR_FORMAT, paramParse(duty, "nan", 3, v));
+    TEST_ASSERT_EQUAL(PARAM_ERR_FORMAT, paramParse(duty, "", 0, v));
+    TEST_ASSERT_EQUAL(PARAM_ERR_FORMAT, paramParse(duty, "1x", 2, v));
+    std::string tooLong(PARAM_VALUE_MAX_LEN + 1, '1');
+    TEST_ASSERT_EQUAL(PARAM_ERR_FORMAT,
+                      paramParse(duty, tooLong.data(), tooLong.size(), v));
+}
+
+static void test_report_round_trip() {
+    // 所有参数取上限时上报也放得下，可写参数经整批设置可以原样恢复
+    MotionParams extreme = {VOLTAGE_MAX,      DUTY_MAX,  FREQ_MAX,
+                            PHASE_MAX,        FREQ_MAX,  PHASE_MAX,
+                            STEP_TIME_MAX_MS, STEP_TIME_MAX_MS,
+                            true,             true};
+    char report[PARAM_REPORT_MAX + 1];
+    size_t len = paramFormatAll(extreme, report, sizeof(report));
+    TEST_ASSERT_TRUE(len > 0);
+    TEST_ASSERT_EQUAL(len, strlen(report));
+
+    ParamBatch batch;
+    paramBatchBegin(batch, defaults());
+    stageAll(batch, report);
+    for (size_t i = 0; i < paramCount(); i++) {
+        const ParamDescriptor *param = paramAt(i);
+        char expected = param->set != NULL ? PARAM_OK : PARAM_ERR_READONLY;
+        TEST_ASSERT_EQUAL(expected, batch.results[i]);
+        if (param->set != NULL) {
+            TEST_ASSERT_EQUAL_FLOAT(param->get(extreme),
+                                    param->get(batch.shadow));
+        }
+    }
+
+    // 空间不足时返回0，不输出半截
+    TEST_ASSERT_EQUAL(0, paramFormatAll(extreme, report, len));
+}
+
+static void test_schema_pages_cover_every_param() {
+    char full[PARAM_SCHEMA_PAGE_MAX + 1];
+    TEST_ASSERT_TRUE(paramFormatSchema(0, full, sizeof(full)) > 0);
+    char header[32];
+    snprintf(header, sizeof(header), "0,%u,%08lx", (unsigned)paramCount(),
+             (unsigned long)paramSchemaHash());
+    TEST_ASSERT_EQUAL(0, strncmp(full, header, strlen(header)));
+
+    // 小页：上位机按本页条数继续请求，每个参数恰好出现一次
+    size_t first = 0;
+    int pages = 0;
+    while (first < paramCount()) {
+        char page[64];
+        TEST_ASSERT_TRUE(paramFormatSchema(first, page, sizeof(page)) > 0);
+        size_t entries = 0;
+        for (const char *p = strchr(page, ';'); p != NULL;
+             p = strchr(p + 1, ';')) {
+            const ParamDescriptor *param = paramAt(first + entries);
+            TEST_ASSERT_EQUAL(0, strncmp(p + 1, param->name,
+                                         strlen(param->name)));
+            entries++;
+        }
+        TEST_ASSERT_TRUE(entries > 0);
+        first += entries;
+        pages++;
+    }
+    TEST_ASSERT_EQUAL(paramCount(), first);
+    TEST_ASSERT_TRUE(pages > 1);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_lookup_by_name_and_id);
+    RUN_TEST(test_parse_types_and_ranges);
+    RUN_TEST(test_report_round_trip);
+    RUN_TEST(test_schema_pages_cover_every_param);
+    return UNITY_END();
+}
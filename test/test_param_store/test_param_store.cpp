@@ -0,0 +1,118 @@
+// --- 文件名: test/test_param_store/test_param_store.cpp ---
+// 带版本号的参数存储：版本号、按版本取变化的参数、变化通知与脏位
+// 组播回复时隙内的通知只有 <纪元>,<版本>，整帧不超过 REPLY_SLOT_NOTICE_BYTES
+// 运行：pio test -e native -f test_param_store
+
+#include "Command.h"
+#include "Pins.h"
+#include "param_store.h"
+#include "reply_slot.h"
+#include <cstdio>
+#include <cstring>
+#include <unity.h>
+
+void setUp() {}
+void tearDown() {}
+
+static MotionParams defaults() {
+    MotionParams p = {DEFAULT_VOLTAGE,   DEFAULT_DUTY_CYCLE, DEFAULT_FWD_FREQ,
+                      DEFAULT_FWD_PHASE, DEFAULT_BWD_FREQ,   DEFAULT_BWD_PHASE,
+                      100.0f,            100.0f,             false,
+                      false};
+    return p;
+}
+
+static void test_versions_and_delta_since() {
+    ParamStore store;
+    MotionParams p = defaults();
+    store.begin(p, 0x1a2b);
+    TEST_ASSERT_EQUAL_UINT32(1, store.version());
+    TEST_ASSERT_FALSE(store.update(p));
+
+    p.voltage = 40;
+    p.dutyCycle = 30.5f;
+    TEST_ASSERT_TRUE(store.update(p)); // 一次提交改动的参数算一个版本
+    TEST_ASSERT_EQUAL_UINT32(2, store.version());
+    p.forwardFreq = 25000;
+    TEST_ASSERT_TRUE(store.update(p));
+
+    char out[PARAM_DELTA_MAX + 1];
+    store.formatSince(0x1a2b, 3, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("1a2b,3", out);
+    store.formatSince(0x1a2b, 2, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("1a2b,3;FWD_FREQ:25000", out);
+    store.formatSince(0x1a2b, 1, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("1a2b,3;VOLTAGE:40;DUTY:30.50;FWD_FREQ:25000",
+                             out);
+
+    // 纪元不符(设备重启过)或版本比设备新：回复全部参数
+    char all[PARAM_DELTA_MAX + 1];
+    store.formatSince(0x1a2b, 0, all, sizeof(all));
+    store.formatSince(0x9999, 3, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING(all, out);
+    store.formatSince(0x1a2b, 4, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING(all, out);
+}
+
+static void test_notice_takes_dirty_once() {
+    ParamStore store;
+    MotionParams p = defaults();
+    store.begin(p, 0x1a2b);
+    char out[PARAM_DELTA_MAX + 1];
+    TEST_ASSERT_EQUAL(0, store.takeDirty(out, sizeof(out)));
+
+    p.stepTimeMs = 50.0f;
+    store.update(p);
+    TEST_ASSERT_TRUE(store.takeDirty(out, sizeof(out)) > 0);
+    TEST_ASSERT_EQUAL_STRING("1a2b,2;STEP_TIME_MS:50.00", out);
+    TEST_ASSERT_EQUAL(0, store.takeDirty(out, sizeof(out)));
+
+    // 空间不足时不清空脏位，下次还能发出
+    p.voltage = 12;
+    store.update(p);
+    char tiny[8];
+    TEST_ASSERT_EQUAL(0, store.takeDirty(tiny, sizeof(tiny)));
+    TEST_ASSERT_TRUE(store.dirtyMask() != 0);
+    TEST_ASSERT_TRUE(store.takeDirty(out, sizeof(out)) > 0);
+}
+
+static void test_slotted_notice_is_header_only() {
+    ParamStore store;
+    MotionParams p = defaults();
+    store.begin(p, 0xffff);
+    // 所有可写参数同时变化：带值的通知远超一个时隙，只含版本号的通知不受影响
+    p.voltage = VOLTAGE_MAX;
+    p.dutyCycle = DUTY_MAX;
+    p.forwardFreq = FREQ_MAX;
+    p.forwardPhase = PHASE_MAX;
+    p.backwardFreq = FREQ_MAX;
+    p.backwardPhase = PHASE_MAX;
+    p.stepTimeMs = STEP_TIME_MAX_MS;
+    p.stillTimeMs = STEP_TIME_MAX_MS;
+    store.update(p);
+
+    char full[PARAM_DELTA_MAX + 1];
+    ParamStore copy = store;
+    size_t fullLen = copy.takeDirty(full, sizeof(full));
+    TEST_ASSERT_TRUE(fullLen > REPLY_SLOT_NOTICE_BYTES);
+
+    char header[PARAM_DELTA_MAX + 1];
+    size_t len = store.takeDirty(header, sizeof(header), false);
+    TEST_ASSERT_EQUAL_STRING("ffff,2", header);
+    TEST_ASSERT_TRUE(len <= PARAM_NOTICE_HEADER_MAX);
+    TEST_ASSERT_EQUAL(0, store.dirtyMask());
+
+    // 最长的情况：版本号10位，回复经过中继带/T选项
+    char frame[64];
+    int n = snprintf(frame, sizeof(frame), "HOST:SR_01/T7:%s:ffff,%lu\n",
+                     PARAM_DELTA, 4294967295UL);
+    TEST_ASSERT_TRUE(n > 0 && n <= REPLY_SLOT_NOTICE_BYTES);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_versions_and_delta_since);
+    RUN_TEST(test_notice_takes_dirty_once);
+    RUN_TEST(test_slotted_notice_is_header_only);
+    return UNITY_END();
+}
@@ -0,0 +1,176 @@
+// --- 文件名: test/test_perfect_hash/test_perfect_hash.cpp ---
+// 编译期完美哈希的命令分派：每个命令字都找回自己，未注册的命令字找不到
+// 另外比较8、32、128个命令时每帧的分派耗时：原来的逐项strcmp与哈希+一次strcmp
+// 命令表与 command_processor.cpp 的写法相同，耗时含一次处理函数调用
+// 运行：pio test -e native -f test_perfect_hash
+
+#include "Command.h"
+#include "perfect_hash.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <unity.h>
+
+#define BENCH_CALLS 1600000 // 每种方式查找的次数
+
+void setUp() {}
+void tearDown() {}
+
+typedef bool (*BenchHandler)(const char *args);
+
+struct BenchEntry {
+    const char *commandName;
+    BenchHandler handler;
+};
+
+static volatile uint32_t handled = 0;
+static bool benchHandler(const char *args) {
+    handled++;
+    return args != NULL;
+}
+
+// 用字面量拼接生成合成命令字，前缀相同，逐项比较时要比到最后几个字符
+#define NAMES4(p) p "A", p "B", p "C", p "D"
+#define NAMES16(p)                                                             \
+    NAMES4(p "_0"), NAMES4(p "_1"), NAMES4(p "_2"), NAMES4(p "_3")
+#define NAMES128(p)                                                            \
+    NAMES16(p "0"), NAMES16(p "1"), NAMES16(p "2"), NAMES16(p "3"),            \
+        NAMES16(p "4"), NAMES16(p "5"), NAMES16(p "6"), NAMES16(p "7")
+#define E(name) {name, benchHandler}
+
+// 8个：当前命令表中的一部分真实命令字
+static constexpr BenchEntry table8[] = {
+    E(Forward),    E(Backward),         E(STOP),        E(SWAP_DIRECTION),
+    E(GET_PARAM),  E(SET_BATCH_PARAMS), E(LINK_STATS), E(PING)};
+
+static constexpr const char *names32[] = {NAMES16("CMD_A"),
+                                          NAMES16("CMD_B")};
+static constexpr const char *names128[] = {NAMES128("CMD_")};
+
+template <size_t N> struct BenchTable {
+    BenchEntry entries[N] = {};
+};
+
+template <size_t N>
+constexpr BenchTable<N> benchTable(const char *const (&names)[N]) {
+    BenchTable<N> t;
+    for (size_t i = 0; i < N; i++) {
+        t.entries[i] = {names[i], benchHandler};
+    }
+    return t;
+}
+
+static constexpr BenchTable<32> table32 = benchTable(names32);
+static constexpr BenchTable<128> table128 = benchTable(names128);
+
+static constexpr PerfectHash<8> index8 =
+    buildPerfectHash(table8, &BenchEntry::commandName);
+static constexpr PerfectHash<32> index32 =
+    buildPerfectHash(table32.entries, &BenchEntry::commandName);
+static constexpr PerfectHash<128> index128 =
+    buildPerfectHash(table128.entries, &BenchEntry::commandName);
+static_assert(index8.unique && index8.found, "table8");
+static_assert(index32.unique && index32.found, "table32");
+static_assert(index128.unique && index128.found, "table128");
+
+// 重复的命令字在编译期就能发现，command_processor.cpp 据此static_assert
+static constexpr BenchEntry duplicated[] = {E(STOP), E(PING), E(STOP)};
+static_assert(!buildPerfectHash(duplicated, &BenchEntry::commandName).unique,
+              "duplicate names must be detected");
+
+template <size_t N>
+static bool dispatchHashed(const BenchEntry (&table)[N],
+                           const PerfectHash<N> &index, const char *command) {
+    size_t i = index.candidate(command);
+    if (i < N && strcmp(command, table[i].commandName) == 0) {
+        return table[i].handler("");
+    }
+    return false;
+}
+
+// 原来的做法：逐项比较
+template <size_t N>
+static bool dispatchLinear(const BenchEntry (&table)[N], const char *command) {
+    for (size_t i = 0; i < N; i++) {
+        if (strcmp(command, table[i].commandName) == 0) {
+            return table[i].handler("");
+        }
+    }
+    return false;
+}
+
+template <size_t N>
+static void checkTable(const BenchEntry (&table)[N],
+                       const PerfectHash<N> &index) {
+    for (size_t i = 0; i < N; i++) {
+        // 从帧中切出的命令字不是表中的同一个指针
+        char command[32];
+        snprintf(command, sizeof(command), "%s", table[i].commandName);
+        TEST_ASSERT_EQUAL(i, index.candidate(command));
+        TEST_ASSERT_TRUE(dispatchHashed(table, index, command));
+    }
+    const char *unknown[] = {"", "M", "STOPX", "CMD_", "CMD_9_0A", "ZZZZ"};
+    for (const char *command : unknown) {
+        TEST_ASSERT_FALSE(dispatchHashed(table, index, command));
+        TEST_ASSERT_FALSE(dispatchLinear(table, command));
+    }
+}
+
+static void test_every_name_maps_to_itself() {
+    checkTable(table8, index8);
+    checkTable(table32.entries, index32);
+    checkTable(table128.entries, index128);
+}
+
+static double nsPerCall(std::chrono::steady_clock::time_point start,
+                        size_t calls) {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+}
+
+template <size_t N>
+static void bench(const BenchEntry (&table)[N], const PerfectHash<N> &index,
+                  double &linearNs, double &hashNs) {
+    // 命令字复制到帧缓冲区里，按表的顺序轮流查找，每个命令被查到的次数相同
+    static char commands[N][32];
+    for (size_t i = 0; i < N; i++) {
+        snprintf(commands[i], sizeof(commands[i]), "%s", table[i].commandName);
+    }
+    const size_t calls = BENCH_CALLS;
+    handled = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < calls; k++) {
+        dispatchLinear(table, commands[k % N]);
+    }
+    linearNs = nsPerCall(start, calls);
+    start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < calls; k++) {
+        dispatchHashed(table, index, commands[k % N]);
+    }
+    hashNs = nsPerCall(start, calls);
+    TEST_ASSERT_EQUAL(2 * calls, handled);
+
+    char msg[120];
+    snprintf(msg, sizeof(msg),
+             "%3u commands: linear %6.1f ns/frame, perfect hash %5.1f "
+             "ns/frame",
+             (unsigned)N, linearNs, hashNs);
+    TEST_MESSAGE(msg);
+}
+
+static void test_dispatch_cost_per_frame() {
+    double linear8, hash8, linear32, hash32, linear128, hash128;
+    bench(table8, index8, linear8, hash8);
+    bench(table32.entries, index32, linear32, hash32);
+    bench(table128.entries, index128, linear128, hash128);
+    // 逐项比较随命令数线性增长，哈希的耗时与命令数无关
+    TEST_ASSERT_TRUE(linear128 > linear8);
+    TEST_ASSERT_TRUE(hash128 < linear128);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_name_maps_to_itself);
+    RUN_TEST(test_dispatch_cost_per_frame);
+    return UNITY_END();
+}
@@ -0,0 +1,303 @@
+// --- 文件名: test/test_relay_sim/test_relay_sim.cpp ---
+// 多跳转发仿真：N个虚拟设备排成一条直线，每个设备只能听到radioRange以内的邻居
+// 每个虚拟设备有自己的RelayRouter和AddressFilter，收帧时按 tasks.cpp 中
+// handleLoRaFrame 的顺序处理：学习路由 -> 去重 -> 本机执行并回复 -> 判断转发
+// 统计请求送达目标的延迟、回复的往返时间，以及转发多占用的空中时间
+// 一跳的时间 = 串口写入模块 + 空中时间 + 串口读出 + 接收空闲超时
+// 不模拟冲突：同时发出的帧都能被收到，实际信道上它们可能互相干扰
+// 运行：pio test -e native -f test_relay_sim
+
+#include "address_filter.h"
+#include "binary_frame.h"
+#include "frame_parser.h"
+#include "lora_config.h"
+#include "relay.h"
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <unity.h>
+#include <vector>
+
+#define SIM_UART_BAUD 115200 // 与 LORA.h 中的 LORA_UART_BAUD 一致
+#define SIM_RX_TIMEOUT_SYMBOLS 2
+#define SIM_AIR_BPS loraAirRateBps((uint8_t)LoraAir::Bps2400) // 模块出厂空速
+#define SIM_HOST 0 // 节点0是上位机，节点k是SR_0k
+
+void setUp() {}
+void tearDown() {}
+
+static int64_t uartUs(size_t len) {
+    return (int64_t)len * 10 * 1000000LL / SIM_UART_BAUD;
+}
+
+struct SimEvent {
+    int64_t atUs;
+    uint32_t order; // 同一时刻按发出顺序处理
+    int node;
+    std::string frame;
+
+    bool operator>(const SimEvent &o) const {
+        return atUs != o.atUs ? atUs > o.atUs : order > o.order;
+    }
+};
+
+struct SimNode {
+    char name[16];
+    uint8_t id;
+    RelayRouter router;
+    AddressFilter filter;
+    int64_t txFreeUs; // 本机发送队列空闲的时刻
+    int executions;   // 发给本机的命令被执行的次数
+    int forwarded;    // 本机转发的帧数
+};
+
+struct RelaySim {
+    std::vector<SimNode> nodes;
+    int radioRange;
+    std::priority_queue<SimEvent, std::vector<SimEvent>,
+                        std::greater<SimEvent>>
+        events;
+    uint32_t order;
+    int transmissions;
+    int64_t airUs;
+    int64_t deliveredUs; // 目标第一次执行的时刻，-1表示未送达
+    int64_t replyUs;     // 上位机第一次收到回复的时刻，-1表示未收到
+    int hostReplies;     // 上位机收到的回复份数(含经不同路径的重复)
+
+    RelaySim(int devices, int range)
+        : nodes(devices + 1), radioRange(range), order(0), transmissions(0),
+          airUs(0), deliveredUs(-1), replyUs(-1), hostReplies(0) {
+        snprintf(nodes[SIM_HOST].name, sizeof(nodes[SIM_HOST].name), "HOST");
+        for (int k = 0; k <= devices; k++) {
+            SimNode &n = nodes[k];
+            if (k != SIM_HOST) {
+                snprintf(n.name, sizeof(n.name), "SR_%02d", k);
+            }
+            n.id = binaryIdFromName(n.name);
+            n.router.setEnabled(k != SIM_HOST);
+            n.filter.setSelf(n.name, strlen(n.name), n.id);
+            n.txFreeUs = 0;
+            n.executions = 0;
+            n.forwarded = 0;
+        }
+    }
+
+    // 节点k发出一帧，范围内的其他节点在空中时间结束并读出串口后收到
+    void transmit(int k, int64_t nowUs, const char *frame, size_t len) {
+        int64_t startUs = nowUs + uartUs(len);
+        if (startUs < nodes[k].txFreeUs) {
+            startUs = nodes[k].txFreeUs;
+        }
+        int64_t air = loraAirtimeUs(SIM_AIR_BPS, len);
+        nodes[k].txFreeUs = startUs + air;
+        transmissions++;
+        airUs += air;
+        int64_t rxUs = startUs + air + uartUs(len) +
+                       SIM_RX_TIMEOUT_SYMBOLS * uartUs(1);
+        for (int j = 0; j < (int)nodes.size(); j++) {
+            int d = j > k ? j - k : k - j;
+            if (j != k && d <= radioRange) {
+                events.push({rxUs, order++, j, std::string(frame, len)});
+            }
+        }
+    }
+
+    void receive(int k, int64_t nowUs, const std::string &wire) {
+        char frame[FRAME_MAX_LEN + 1];
+        size_t len = wire.size();
+        if (len > 0 && wire[len - 1] == '\n') {
+            len--; // FrameBuffer交出的帧不含'\n'
+        }
+        memcpy(frame, wire.data(), len);
+        frame[len] = '\0';
+        FrameFields fields;
+        SenderOptions sender;
+        TEST_ASSERT_TRUE(tokenizeFrame(frame, len, fields));
+        TEST_ASSERT_TRUE(parseSenderOptions(fields.sender, sender));
+        SimNode &n = nodes[k];
+        if (k == SIM_HOST) {
+            if (fields.receiver.equals("HOST", 4) &&
+                fields.command.equals("ACK", 3)) {
+                hostReplies++;
+                if (replyUs < 0) {
+                    replyUs = nowUs;
+                }
+            }
+            return;
+        }
+
+        uint32_t nowMs = (uint32_t)(nowUs / 1000);
+        n.router.learn(sender, nowMs);
+        if ((sender.has(SENDER_OPT_TTL) || sender.has(SENDER_OPT_VIA)) &&
+            n.router.seenBefore(RelayRouter::frameKey(fields, sender), nowMs)) {
+            return;
+        }
+        AddressMatch target =
+            n.filter.match(fields.receiver.data, fields.receiver.len);
+        if (AddressFilter::isForMe(target)) {
+            n.executions++;
+            if (deliveredUs < 0) {
+                deliveredUs = nowUs;
+            }
+            // 回复的TTL与 handleLoRaFrame 相同：请求经过的跳数加一
+            char reply[64];
+            int rl;
+            if (sender.has(SENDER_OPT_VIA)) {
+                unsigned long hops = sender.has(SENDER_OPT_HOPS)
+                                         ? sender.get(SENDER_OPT_HOPS)
+                                         : 0;
+                rl = snprintf(reply, sizeof(reply), "HOST:%s/T%lu:ACK:%s\n",
+                              n.name, hops + 1, fields.command.data);
+            } else {
+                rl = snprintf(reply, sizeof(reply), "HOST:%s:ACK:%s\n", n.name,
+                              fields.command.data);
+            }
+            transmit(k, nowUs, reply, (size_t)rl);
+        }
+        if (target == ADDR_SELF) {
+            return;
+        }
+        if (n.router.shouldForward(fields, sender, n.id,
+                                   AddressFilter::isMulticast(target), nowMs)) {
+            char relayed[FRAME_MAX_LEN + 1];
+            size_t rl = RelayRouter::formatForward(fields, sender, n.id,
+                                                   relayed, sizeof(relayed));
+            TEST_ASSERT_TRUE(rl > 0);
+            n.forwarded++;
+            transmit(k, nowUs, relayed, rl);
+        }
+    }
+
+    // 上位机在时刻0发出一条请求，运行到信道空闲
+    void run(const char *request) {
+        transmit(SIM_HOST, 0, request, strlen(request));
+        while (!events.empty()) {
+            SimEvent e = events.top();
+            events.pop();
+            receive(e.node, e.atUs, e.frame);
+        }
+    }
+};
+
+static int64_t directAirUs(const char *request, const char *reply) {
+    return loraAirtimeUs(SIM_AIR_BPS, strlen(request)) +
+           loraAirtimeUs(SIM_AIR_BPS, strlen(reply));
+}
+
+static void test_chain_latency_and_airtime() {
+    // 链状拓扑：上位机只能听到SR_01，目标是链尾的设备
+    int64_t lastDelivered = 0;
+    for (int devices = 1; devices <= 6; devices++) {
+        char request[64];
+        snprintf(request, sizeof(request), "SR_%02d:HOST/E1/S1/T%d:M_F:100\n",
+                 devices, devices - 1);
+        RelaySim sim(devices, 1);
+        sim.run(request);
+
+        SimNode &target = sim.nodes[devices];
+        TEST_ASSERT_EQUAL(1, target.executions);
+        TEST_ASSERT_TRUE(sim.deliveredUs > lastDelivered);
+        TEST_ASSERT_TRUE(sim.replyUs > sim.deliveredUs);
+        TEST_ASSERT_TRUE(sim.hostReplies >= 1);
+        // 每个中继对请求和回复各只转发一次
+        for (int k = 1; k < devices; k++) {
+            TEST_ASSERT_TRUE(sim.nodes[k].forwarded <= 2);
+            TEST_ASSERT_EQUAL(0, sim.nodes[k].executions);
+        }
+        lastDelivered = sim.deliveredUs;
+
+        int64_t direct = directAirUs(request, "HOST:SR_01:ACK:M_F\n");
+        char msg[200];
+        snprintf(msg, sizeof(msg),
+                 "chain %d hop(s): deliver %.1f ms, round trip %.1f ms, "
+                 "%d frames, airtime %.1f ms (+%.1f ms vs direct)",
+                 devices, sim.deliveredUs / 1000.0, sim.replyUs / 1000.0,
+                 sim.transmissions, sim.airUs / 1000.0,
+                 (sim.airUs - direct) / 1000.0);
+        TEST_MESSAGE(msg);
+    }
+}
+
+static void test_dense_line_suppresses_duplicates() {
+    // 每个设备能听到两跳以内的邻居：同一帧会经多个中继到达，目标只执行一次
+    const int devices = 6;
+    RelaySim sim(devices, 2);
+    sim.run("SR_06:HOST/E1/S1/T5:M_F:100\n");
+
+    TEST_ASSERT_EQUAL(1, sim.nodes[devices].executions);
+    uint32_t duplicates = 0;
+    for (int k = 1; k <= devices; k++) {
+        TEST_ASSERT_TRUE(sim.nodes[k].forwarded <= 2);
+        duplicates += sim.nodes[k].router.getStats().duplicates;
+    }
+    TEST_ASSERT_TRUE(duplicates > 0);
+    TEST_ASSERT_TRUE(sim.replyUs > 0);
+
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "dense line %d devices: deliver %.1f ms, round trip %.1f ms, "
+             "%d frames, %u duplicates suppressed",
+             devices, sim.deliveredUs / 1000.0, sim.replyUs / 1000.0,
+             sim.transmissions, (unsigned)duplicates);
+    TEST_MESSAGE(msg);
+}
+
+static void test_ttl_limits_reach() {
+    // TTL不够时帧在中途停止转发，目标收不到
+    RelaySim sim(4, 1);
+    sim.run("SR_04:HOST/E1/S1/T1:M_F:100\n");
+    TEST_ASSERT_EQUAL(0, sim.nodes[4].executions);
+    TEST_ASSERT_EQUAL(-1, sim.deliveredUs);
+    TEST_ASSERT_EQUAL(1, sim.nodes[1].forwarded);
+    TEST_ASSERT_EQUAL(0, sim.nodes[2].forwarded);
+
+    // 不带/T的旧格式帧不会被转发
+    RelaySim legacy(2, 1);
+    legacy.run("SR_02:HOST:M_F:100\n");
+    TEST_ASSERT_EQUAL(0, legacy.nodes[2].executions);
+    TEST_ASSERT_EQUAL(1, legacy.transmissions);
+}
+
+static void test_forward_keeps_other_options() {
+    // 定时(/A)、流水线窗口(/W)和有效期(/D)经过一跳后仍在，只改写/T、/H、/V
+    char frame[] = "SR_09:HOST/E7/S5/T2/A123456/W4/D200:M_F:";
+    FrameFields fields;
+    SenderOptions sender;
+    TEST_ASSERT_TRUE(tokenizeFrame(frame, strlen(frame), fields));
+    TEST_ASSERT_TRUE(parseSenderOptions(fields.sender, sender));
+    char relayed[FRAME_MAX_LEN + 1];
+    size_t len =
+        RelayRouter::formatForward(fields, sender, 3, relayed, sizeof(relayed));
+    TEST_ASSERT_EQUAL_STRING(
+        "SR_09:HOST/E7/S5/A123456/W4/D200/T1/H1/V3:M_F:\n", relayed);
+    TEST_ASSERT_EQUAL(strlen(relayed), len);
+
+    // 第二跳：旧的/T、/H、/V被替换，不会重复出现
+    relayed[len - 1] = '\0';
+    FrameFields again;
+    SenderOptions hop;
+    TEST_ASSERT_TRUE(tokenizeFrame(relayed, len - 1, again));
+    TEST_ASSERT_TRUE(parseSenderOptions(again.sender, hop));
+    TEST_ASSERT_EQUAL_UINT32(123456, hop.get(SENDER_OPT_AT));
+    TEST_ASSERT_EQUAL_UINT32(4, hop.get(SENDER_OPT_WINDOW));
+    TEST_ASSERT_EQUAL_UINT32(200, hop.get(SENDER_OPT_DEADLINE));
+    char twice[FRAME_MAX_LEN + 1];
+    TEST_ASSERT_TRUE(
+        RelayRouter::formatForward(again, hop, 4, twice, sizeof(twice)) > 0);
+    TEST_ASSERT_EQUAL_STRING(
+        "SR_09:HOST/E7/S5/A123456/W4/D200/T0/H2/V4:M_F:\n", twice);
+
+    // 空间不足时返回0
+    TEST_ASSERT_EQUAL(0, RelayRouter::formatForward(fields, sender, 3, relayed,
+                                                    20));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_chain_latency_and_airtime);
+    RUN_TEST(test_dense_line_suppresses_duplicates);
+    RUN_TEST(test_ttl_limits_reach);
+    RUN_TEST(test_forward_keeps_other_options);
+    return UNITY_END();
+}
@@ -0,0 +1,163 @@
+// --- 文件名: test/test_reliable_link/test_reliable_link.cpp ---
+// 序号去重与会话同步：设备只确认执行过的序号，丢帧、上位机重启、设备重启后都不会误ACK
+// 运行：pio test -e native -f test_reliable_link
+
+#include "reliable_link.h"
+#include <string.h>
+#include <unity.h>
+
+void setUp() {}
+void tearDown() {}
+
+#define HOST_NAME "HOST", 4
+
+static uint32_t cumulativeOf(SeqTracker &tracker) {
+    uint32_t cumulative = 0xFFFFFFFF;
+    tracker.cumulativeOf(HOST_NAME, cumulative);
+    return cumulative;
+}
+
+static void test_in_order_and_duplicates() {
+    SeqTracker tracker;
+    TEST_ASSERT_EQUAL(SEQ_NEW, tracker.accept(HOST_NAME, 7, 1));
+    TEST_ASSERT_EQUAL(SEQ_NEW, tracker.accept(HOST_NAME, 7, 2));
+    TEST_ASSERT_EQUAL(SEQ_DUPLICATE, tracker.accept(HOST_NAME, 7, 2));
+    TEST_ASSERT_EQUAL(SEQ_DUPLICATE, tracker.accept(HOST_NAME, 7, 1));
+    TEST_ASSERT_EQUAL(2, cumulativeOf(tracker));
+}
+
+// 会话的第一帧丢失：后一帧不能把前一帧变成"已执行"
+static void test_lost_first_frame_is_not_acked() {
+    SeqTracker tracker;
+    TEST_ASSERT_EQUAL(SEQ_RESYNC, tracker.accept(HOST_NAME, 7, 2));
+    uint32_t cumulative;
+    TEST_ASSERT_FALSE(tracker.cumulativeOf(HOST_NAME, cumulative));
+
+    TEST_ASSERT_EQUAL(SEQ_NEW, tracker.accept(HOST_NAME, 7, 1));
+    TEST_ASSERT_EQUAL(SEQ_NEW, tracker.accept(HOST_NAME, 7, 2));
+    TEST_ASSERT_EQUAL(2, cumulativeOf(tracker));
+}
+
+// 会话中间丢帧：乱序收到的序号记在位图里，累计序号不越过空缺
+static void test_gap_keeps_cumulative() {
+    SeqTracker tracker;
+    tracker.accept(HOST_NAME, 7, 1);
+    TEST_ASSERT_EQUAL(SEQ_NEW, tracker.accept(HOST_NAME, 7, 3));
+    TEST_ASSERT_EQUAL(1, cumulativeOf(tracker));
+
+    char ack[LINK_ACK_MAX_LEN];
+    TEST_ASSERT_TRUE(tracker.formatAck(HOST_NAME, "SR_01", ack, sizeof(ack)));
+    TEST_ASSERT_EQUAL_STRING("HOST:SR_01:ACK:SEQ,1,2\n", ack);
+
+    uint32_t cumulative;
+    uint32_t mask;
+    TEST_ASSERT_TRUE(parseCumulativeAck(strstr(ack, "SEQ,"), cumulative, mask));
+    TEST_ASSERT_FALSE(seqAcknowledged(2, cumulative, mask));
+    TEST_ASSERT_TRUE(seqAcknowledged(3, cumulative, mask));
+
+    TEST_ASSERT_EQUAL(SEQ_NEW, tracker.accept(HOST_NAME, 7, 2));
+    TEST_ASSERT_EQUAL(3, cumulativeOf(tracker));
+    TEST_ASSERT_EQUAL(SEQ_TOO_NEW,
+                      tracker.accept(HOST_NAME, 7, 4 + LINK_WINDOW_BITS));
+}
+
+// 上位机重启：新会话从序号1开始，即使旧会话的序号更大也照常执行
+static void test_host_restart_starts_new_session() {
+    SeqTracker tracker;
+    for (uint32_t seq = 1; seq <= 5; seq++) {
+        tracker.accept(HOST_NAME, 7, seq);
+    }
+    TEST_ASSERT_TRUE(tracker.inSession(HOST_NAME, 7));
+    TEST_ASSERT_FALSE(tracker.inSession(HOST_NAME, 9));
+    TEST_ASSERT_EQUAL(SEQ_NEW, tracker.accept(HOST_NAME, 9, 1));
+    TEST_ASSERT_EQUAL(1, cumulativeOf(tracker));
+    // 新会话的首帧丢失同样要求重新同步，而不是当作重复帧确认
+    SeqTracker other;
+    other.accept(HOST_NAME, 7, 1);
+    other.accept(HOST_NAME, 7, 2);
+    TEST_ASSERT_EQUAL(SEQ_RESYNC, other.accept(HOST_NAME, 11, 2));
+    TEST_ASSERT_EQUAL(2, cumulativeOf(other));
+}
+
+// 设备重启(或发送者被淘汰)：会话中途的序号不执行，回复SEQ_RESYNC
+static void test_device_restart_requests_resync() {
+    SeqTracker tracker;
+    TEST_ASSERT_EQUAL(SEQ_RESYNC, tracker.accept(HOST_NAME, 7, 40));
+
+    char resync[LINK_ACK_MAX_LEN];
+    size_t n = SeqTracker::formatResync(HOST_NAME, "SR_01", 7, resync,
+                                        sizeof(resync));
+    TEST_ASSERT_EQUAL(strlen(resync), n);
+    TEST_ASSERT_EQUAL_STRING("HOST:SR_01:ACK:SEQ_RESYNC,7\n", resync);
+
+    uint32_t session = 0;
+    resync[n - 1] = '\0';
+    TEST_ASSERT_TRUE(parseSeqResync(strstr(resync, "SEQ_RESYNC"), session));
+    TEST_ASSERT_EQUAL(7, session);
+    uint32_t cumulative;
+    uint32_t mask;
+    TEST_ASSERT_FALSE(
+        parseCumulativeAck(strstr(resync, "SEQ_RESYNC"), cumulative, mask));
+}
+
+// 不带/E的帧按会话0处理，遵守同样的规则
+static void test_frames_without_session() {
+    SeqTracker tracker;
+    TEST_ASSERT_EQUAL(SEQ_RESYNC, tracker.accept(HOST_NAME, 0, 17));
+    TEST_ASSERT_EQUAL(SEQ_NEW, tracker.accept(HOST_NAME, 0, 1));
+    TEST_ASSERT_EQUAL(SEQ_DUPLICATE, tracker.accept(HOST_NAME, 0, 1));
+}
+
+static void test_pipeline_drop() {
+    PipelineBuffer pipeline;
+    PipelineTiming timing = {false, 0, 1000, 0};
+    TEST_ASSERT_TRUE(pipeline.store(HOST_NAME, 3, "M_F", "", timing));
+    TEST_ASSERT_TRUE(pipeline.store("PAD", 3, 3, "M_B", "", timing));
+    pipeline.drop(HOST_NAME);
+
+    const char *command;
+    const char *args;
+    TEST_ASSERT_FALSE(pipeline.take(HOST_NAME, 3, command, args, timing));
+    TEST_ASSERT_TRUE(pipeline.take("PAD", 3, 3, command, args, timing));
+    TEST_ASSERT_EQUAL_STRING("M_B", command);
+}
+
+// 缓存的命令保留自己的收到时刻和有效期，取出时不被当前帧的条件替换
+static void test_pipeline_keeps_timing() {
+    PipelineBuffer pipeline;
+    PipelineTiming stored = {true, 123456, 5000000, 250};
+    TEST_ASSERT_TRUE(pipeline.store(HOST_NAME, 4, "M_P_F", "10", stored));
+
+    const char *command;
+    const char *args;
+    PipelineTiming timing = {false, 0, 9000000, 0};
+    TEST_ASSERT_TRUE(pipeline.take(HOST_NAME, 4, command, args, timing));
+    TEST_ASSERT_EQUAL_STRING("10", args);
+    TEST_ASSERT_TRUE(timing.hasAt);
+    TEST_ASSERT_EQUAL(123456, timing.atUs);
+    TEST_ASSERT_TRUE(timing.rxUs == 5000000);
+    TEST_ASSERT_EQUAL(250, timing.maxAgeMs);
+}
+
+static void test_rtt_estimator() {
+    RttEstimator rtt(1000, 200, 8000);
+    rtt.sample(100);
+    TEST_ASSERT_EQUAL(100, rtt.srtt());
+    TEST_ASSERT_EQUAL(300, rtt.rto());
+    rtt.backoff();
+    TEST_ASSERT_EQUAL(600, rtt.rto());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_in_order_and_duplicates);
+    RUN_TEST(test_lost_first_frame_is_not_acked);
+    RUN_TEST(test_gap_keeps_cumulative);
+    RUN_TEST(test_host_restart_starts_new_session);
+    RUN_TEST(test_device_restart_requests_resync);
+    RUN_TEST(test_frames_without_session);
+    RUN_TEST(test_pipeline_drop);
+    RUN_TEST(test_pipeline_keeps_timing);
+    RUN_TEST(test_rtt_estimator);
+    return UNITY_END();
+}
@@ -0,0 +1,175 @@
+// --- 文件名: test/test_reply_slots/test_reply_slots.cpp ---
+// 组播回复时隙仿真：上位机向ALL发出一条命令，M台设备几乎同时收到
+// 每台设备用自己的ReplySlots和TxScheduler，按 handleLoRaFrame 的做法把ACK暂存到
+// 本机时隙，再由发送调度器在到时刻后取出发送
+// 比较两种方式上位机收齐所有回复的时间和完整收到的回复数：
+//   - 立即回复：所有设备同时发送，空中重叠的帧互相破坏
+//   - 分时隙回复：LEAD + 时隙号 * 宽度 之后才发送
+// 各设备收到请求的时刻相差0~3ms(串口读出、任务调度)，由保护间隔吸收
+// 改动参数的命令(如组播 SET_BATCH_PARAMS)在ACK之后紧接一条只含版本号的
+// PARAM_DELTA 通知，两帧都必须落在本机时隙内
+// 运行：pio test -e native -f test_reply_slots
+
+#include "lora_config.h"
+#include "reply_slot.h"
+#include "tx_scheduler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unity.h>
+#include <vector>
+
+#define SIM_AIR_BPS loraAirRateBps((uint8_t)LoraAir::Bps2400) // 模块出厂空速
+#define SIM_DUTY_PERMILLE 100 // 与 LORA.h 中的 LORA_DUTY_CYCLE_PERMILLE 一致
+#define SIM_DUTY_WINDOW_MS 10000 // 与 LORA_DUTY_WINDOW_MS 一致
+#define SIM_RX_JITTER_MS 4       // 各设备收到请求的时刻在 [0, 4) ms 内错开
+
+void setUp() {}
+void tearDown() {}
+
+struct AirFrame {
+    int64_t startUs;
+    int64_t endUs;
+};
+
+struct FleetResult {
+    int64_t completeUs; // 最后一帧回复结束的时刻
+    int delivered;      // 没有与其他回复重叠、上位机能完整收到的回复数
+};
+
+// 设备k的ACK从发送调度器取出的时刻；held为false时即收到请求的时刻
+static uint32_t replyTxMs(uint8_t k, uint32_t rxMs, bool held,
+                          uint32_t widthCheckMs) {
+    ReplySlots slots;
+    slots.setAirRate(SIM_AIR_BPS);
+    slots.setIndex(REPLY_SLOT_AUTO, k);
+    TEST_ASSERT_EQUAL(widthCheckMs, slots.widthMs());
+
+    TxScheduler scheduler(SIM_AIR_BPS, SIM_DUTY_PERMILLE, SIM_DUTY_WINDOW_MS);
+    LoraTxFrame frame = {};
+    frame.held = held;
+    frame.dueMs = slots.dueMs(rxMs);
+    frame.len = snprintf(frame.data, sizeof(frame.data),
+                         "HOST:SR_%02u:ACK:M_F\n", (unsigned)k);
+    TEST_ASSERT_TRUE(scheduler.stage(frame));
+
+    uint32_t nowMs = rxMs;
+    LoraTxFrame out;
+    uint32_t waitMs;
+    while (!scheduler.next(nowMs, out, waitMs)) {
+        nowMs += waitMs > 0 ? waitMs : 1;
+    }
+    return nowMs;
+}
+
+#define SIM_BATCH_ACK "HOST:SR_01:ACK:BATCH_OK:000"
+#define SIM_NOTICE "HOST:SR_01:PARAM_DELTA:1a2b,42\n"
+
+static uint32_t slotWidthMs(uint32_t bps) {
+    return (loraAirtimeUs(bps, REPLY_SLOT_FRAME_BYTES) +
+            loraAirtimeUs(bps, REPLY_SLOT_NOTICE_BYTES) + REPLY_SLOT_GUARD_US +
+            999) /
+           1000;
+}
+
+// notice为true时每台设备在ACK之后紧接着发出参数变化通知
+static FleetResult runFleet(int fleet, bool slotted, uint32_t widthMs,
+                            bool notice) {
+    const size_t requestLen = strlen("ALL:HOST:M_F:100\n");
+    const size_t replyLen = strlen(notice ? SIM_BATCH_ACK "\n"
+                                          : "HOST:SR_01:ACK:M_F\n");
+    const int64_t noticeUs =
+        notice ? loraAirtimeUs(SIM_AIR_BPS, strlen(SIM_NOTICE)) : 0;
+    const int64_t requestEndUs = loraAirtimeUs(SIM_AIR_BPS, requestLen);
+    std::vector<AirFrame> air;
+    for (int k = 1; k <= fleet; k++) {
+        uint32_t rxMs = (uint32_t)(requestEndUs / 1000) +
+                        (uint32_t)(k * 7 % SIM_RX_JITTER_MS);
+        uint32_t txMs = replyTxMs((uint8_t)k, rxMs, slotted, widthMs);
+        int64_t startUs = (int64_t)txMs * 1000;
+        int64_t endUs =
+            startUs + loraAirtimeUs(SIM_AIR_BPS, replyLen) + noticeUs;
+        air.push_back({startUs, endUs});
+    }
+
+    FleetResult r = {0, 0};
+    for (size_t i = 0; i < air.size(); i++) {
+        bool clear = true;
+        for (size_t j = 0; j < air.size(); j++) {
+            if (i != j && air[i].startUs < air[j].endUs &&
+                air[j].startUs < air[i].endUs) {
+                clear = false;
+            }
+        }
+        r.delivered += clear ? 1 : 0;
+        r.completeUs = std::max(r.completeUs, air[i].endUs);
+    }
+    return r;
+}
+
+static void test_completion_time_vs_fleet_size() {
+    uint32_t widthMs = slotWidthMs(SIM_AIR_BPS);
+    const int fleets[] = {1, 2, 4, 8, 16, 32};
+    for (int fleet : fleets) {
+        FleetResult burst = runFleet(fleet, false, widthMs, false);
+        FleetResult slotted = runFleet(fleet, true, widthMs, false);
+
+        // 时隙各不相同：所有回复都能收到，收齐时间不超过 LEAD + M * 宽度
+        TEST_ASSERT_EQUAL(fleet, slotted.delivered);
+        int64_t requestUs =
+            loraAirtimeUs(SIM_AIR_BPS, strlen("ALL:HOST:M_F:100\n"));
+        int64_t boundUs =
+            requestUs + SIM_RX_JITTER_MS * 1000 +
+            (REPLY_SLOT_LEAD_MS + (int64_t)fleet * widthMs) * 1000;
+        TEST_ASSERT_TRUE(slotted.completeUs <= boundUs);
+        if (fleet > 1) {
+            TEST_ASSERT_TRUE(burst.delivered < fleet);
+        }
+
+        char msg[200];
+        snprintf(msg, sizeof(msg),
+                 "fleet %2d: immediate %6.1f ms, %2d/%d clear | slotted "
+                 "%7.1f ms, %2d/%d clear (slot width %u ms)",
+                 fleet, burst.completeUs / 1000.0, burst.delivered, fleet,
+                 slotted.completeUs / 1000.0, slotted.delivered, fleet,
+                 (unsigned)widthMs);
+        TEST_MESSAGE(msg);
+    }
+}
+
+static void test_ack_and_notice_share_a_slot() {
+    // 组播 SET_BATCH_PARAMS：ACK与只含版本号的通知都在本机时隙内，不碰撞
+    TEST_ASSERT_TRUE(strlen(SIM_NOTICE) <= REPLY_SLOT_NOTICE_BYTES);
+    uint32_t widthMs = slotWidthMs(SIM_AIR_BPS);
+    const int fleets[] = {2, 8, 32};
+    for (int fleet : fleets) {
+        FleetResult slotted = runFleet(fleet, true, widthMs, true);
+        TEST_ASSERT_EQUAL(fleet, slotted.delivered);
+    }
+}
+
+static void test_slots_do_not_overlap_at_every_air_rate() {
+    // 空速改变后重新计算宽度：64字节以内的回复加上通知，
+    // 在任何空速下都不会越过自己的时隙
+    for (uint8_t level = 0; level <= LORA_AIR_MAX; level++) {
+        uint32_t bps = loraAirRateBps(level);
+        ReplySlots a;
+        ReplySlots b;
+        a.setAirRate(bps);
+        b.setAirRate(bps);
+        a.setIndex(REPLY_SLOT_AUTO, 1);
+        b.setIndex(REPLY_SLOT_AUTO, 2);
+        uint32_t endA = a.dueMs(0) * 1000 +
+                        loraAirtimeUs(bps, REPLY_SLOT_FRAME_BYTES) +
+                        loraAirtimeUs(bps, REPLY_SLOT_NOTICE_BYTES);
+        TEST_ASSERT_TRUE(endA + REPLY_SLOT_GUARD_US <= b.dueMs(0) * 1000);
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_completion_time_vs_fleet_size);
+    RUN_TEST(test_ack_and_notice_share_a_slot);
+    RUN_TEST(test_slots_do_not_overlap_at_every_air_rate);
+    return UNITY_END();
+}
@@ -0,0 +1,289 @@
+// --- 文件名: test/test_rx_latency/test_rx_latency.cpp ---
+// 接收路径基准：用假UART按9600波特率逐字节"到达"，在虚拟时间里分别运行
+//   - 原来的轮询方式：每10ms读一个字节
+//   - 现在的事件方式：串口空闲LORA_RX_TIMEOUT_SYMBOLS个字符时间(或FIFO到达阈值)后
+//     产生接收事件，一次读出全部字节送入FrameBuffer
+// 统计从一帧最后一个字节到达到该帧分派的延迟，两种方式使用同一个FrameBuffer
+// 不计任务切换和命令处理本身的时间
+// 另外按模块串口波特率统计一帧端到端的延迟：上位机写入模块、空中时间、
+// 设备端模块读出、接收空闲超时，说明提高LORA_UART_BAUD能省下多少
+// 以及紧急停止标记的最坏延迟：标记最后一个字节到达后，要等下一次接收事件
+// 才由回调中的StopTokenDetector识别，数据流不停时最晚等到FIFO满
+// 运行：pio test -e native -f test_rx_latency
+
+#include "frame_parser.h"
+#include "lora_config.h"
+#include <cstdio>
+#include <unity.h>
+#include <vector>
+
+#define SIM_UART_BAUD 9600
+#define SIM_BYTE_US (10 * 1000000LL / SIM_UART_BAUD) // 8N1，每字节10位
+#define SIM_POLL_US 10000        // 原来的 vTaskDelay(pdMS_TO_TICKS(10))
+#define SIM_RX_TIMEOUT_SYMBOLS 2 // 与 LORA.h 中的 LORA_RX_TIMEOUT_SYMBOLS 一致
+#define SIM_FIFO_FULL_BYTES 120  // ESP32 UART驱动默认的FIFO满中断阈值
+
+void setUp() {}
+void tearDown() {}
+
+struct RxByte {
+    int64_t arrivalUs;
+    char c;
+};
+
+// 假UART：记录每个字节的到达时刻，以及每帧最后一个字节的到达时刻
+struct FakeUart {
+    std::vector<RxByte> bytes;
+    std::vector<int64_t> frameEndUs;
+
+    // 从startUs开始连续发送若干帧，帧之间没有空隙
+    void sendBurst(int64_t startUs, size_t frameLen, int frames) {
+        int64_t t = startUs;
+        for (int f = 0; f < frames; f++) {
+            for (size_t i = 0; i < frameLen; i++) {
+                t += SIM_BYTE_US;
+                char c = 'A';
+                if (i + 1 == frameLen) {
+                    c = '\n';
+                } else if (i == 3 || i == 8 || i == 12) {
+                    c = ':';
+                }
+                bytes.push_back({t, c});
+            }
+            frameEndUs.push_back(t);
+        }
+    }
+};
+
+struct LatencyStats {
+    int64_t maxUs;
+    int64_t totalUs;
+    int frames;
+
+    double meanMs() const { return frames ? totalUs / 1000.0 / frames : 0; }
+    void add(int64_t us) {
+        maxUs = us > maxUs ? us : maxUs;
+        totalUs += us;
+        frames++;
+    }
+};
+
+// 原来的方式：每个轮询周期最多读一个字节
+static LatencyStats runPolling(const FakeUart &uart, int64_t phaseUs) {
+    LatencyStats stats = {};
+    FrameBuffer fb;
+    size_t next = 0;
+    size_t frame = 0;
+    for (int64_t t = phaseUs; next < uart.bytes.size(); t += SIM_POLL_US) {
+        if (uart.bytes[next].arrivalUs > t) {
+            continue;
+        }
+        if (fb.push(uart.bytes[next++].c) == FRAME_READY) {
+            stats.add(t - uart.frameEndUs[frame++]);
+            fb.reset();
+        }
+    }
+    return stats;
+}
+
+// 现在的方式：空闲超时或FIFO满时产生事件，一次读出所有已到达的字节
+static LatencyStats runEventDriven(const FakeUart &uart) {
+    LatencyStats stats = {};
+    FrameBuffer fb;
+    size_t next = 0;
+    size_t frame = 0;
+    const int64_t idleUs = SIM_RX_TIMEOUT_SYMBOLS * SIM_BYTE_US;
+    while (next < uart.bytes.size()) {
+        // 找出下一次事件的时刻
+        size_t i = next;
+        int64_t eventUs = -1;
+        while (i < uart.bytes.size()) {
+            bool last = i + 1 == uart.bytes.size();
+            int64_t gap = last ? idleUs
+                               : uart.bytes[i + 1].arrivalUs -
+                                     uart.bytes[i].arrivalUs;
+            if (i + 1 - next >= SIM_FIFO_FULL_BYTES) {
+                eventUs = uart.bytes[i].arrivalUs;
+                break;
+            }
+            if (gap >= idleUs) {
+                eventUs = uart.bytes[i].arrivalUs + idleUs;
+                break;
+            }
+            i++;
+        }
+        // 批量读出事件时刻之前到达的所有字节
+        while (next < uart.bytes.size() &&
+               uart.bytes[next].arrivalUs <= eventUs) {
+            if (fb.push(uart.bytes[next++].c) == FRAME_READY) {
+                stats.add(eventUs - uart.frameEndUs[frame++]);
+                fb.reset();
+            }
+        }
+    }
+    return stats;
+}
+
+static void report(const char *label, size_t frameLen, int frames,
+                   const LatencyStats &poll, const LatencyStats &event) {
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "%s: %u x %u bytes @%d baud  polling mean %.1f ms max %.1f ms | "
+             "event mean %.2f ms max %.2f ms",
+             label, (unsigned)frames, (unsigned)frameLen, SIM_UART_BAUD,
+             poll.meanMs(), poll.maxUs / 1000.0, event.meanMs(),
+             event.maxUs / 1000.0);
+    TEST_MESSAGE(msg);
+}
+
+static void test_single_frame_latency() {
+    const size_t sizes[] = {16, 40, 120, 200};
+    for (size_t frameLen : sizes) {
+        FakeUart uart;
+        uart.sendBurst(0, frameLen, 1);
+        // 轮询相位不同结果不同，取所有相位中的最坏值
+        LatencyStats worst = {};
+        for (int64_t phase = 0; phase < SIM_POLL_US; phase += 1000) {
+            LatencyStats s = runPolling(uart, phase);
+            if (s.maxUs > worst.maxUs) {
+                worst = s;
+            }
+        }
+        LatencyStats event = runEventDriven(uart);
+        TEST_ASSERT_EQUAL(1, event.frames);
+        // 事件方式：最后一个字节之后只等空闲超时
+        TEST_ASSERT_TRUE(event.maxUs <= SIM_RX_TIMEOUT_SYMBOLS * SIM_BYTE_US);
+        TEST_ASSERT_TRUE(worst.maxUs > event.maxUs);
+        report("single", frameLen, 1, worst, event);
+    }
+}
+
+static void test_back_to_back_burst() {
+    // 连续5帧：轮询方式每秒只能读100字节，积压越来越多
+    FakeUart uart;
+    uart.sendBurst(0, 40, 5);
+    LatencyStats poll = runPolling(uart, 0);
+    LatencyStats event = runEventDriven(uart);
+    TEST_ASSERT_EQUAL(5, poll.frames);
+    TEST_ASSERT_EQUAL(5, event.frames);
+    // 数据流不停时靠FIFO满事件，最多晚一个FIFO的字节时间
+    TEST_ASSERT_TRUE(event.maxUs <= SIM_FIFO_FULL_BYTES * SIM_BYTE_US);
+    TEST_ASSERT_TRUE(poll.maxUs > event.maxUs);
+    report("burst", 40, 5, poll, event);
+}
+
+static void test_uart_baud_end_to_end() {
+    const uint32_t bauds[] = {9600, 19200, 38400, 57600, 115200};
+    const size_t frameLen = 40;
+    const uint32_t airBps = loraAirRateBps((uint8_t)LoraAir::Bps2400);
+    const int64_t airUs = loraAirtimeUs(airBps, frameLen);
+    int64_t last = INT64_MAX;
+    int64_t uart9600 = 0;
+    for (uint32_t baud : bauds) {
+        TEST_ASSERT_TRUE(loraBaudValid(baud));
+        int64_t byteUs = 10 * 1000000LL / baud;
+        // 两端各经过一次串口，接收端再等空闲超时
+        int64_t uartUs =
+            (2 * (int64_t)frameLen + SIM_RX_TIMEOUT_SYMBOLS) * byteUs;
+        int64_t totalUs = uartUs + airUs;
+        TEST_ASSERT_TRUE(totalUs < last);
+        last = totalUs;
+        if (baud == 9600) {
+            uart9600 = uartUs;
+        }
+        char msg[160];
+        snprintf(msg, sizeof(msg),
+                 "%u bytes @%6u baud: UART %6.1f ms + air %.1f ms = %6.1f ms "
+                 "(UART %2.0f%%)",
+                 (unsigned)frameLen, (unsigned)baud, uartUs / 1000.0,
+                 airUs / 1000.0, totalUs / 1000.0, 100.0 * uartUs / totalUs);
+        TEST_MESSAGE(msg);
+        if (baud == 115200) {
+            // 115200时串口部分不到9600时的十分之一
+            TEST_ASSERT_TRUE(uartUs * 10 < uart9600);
+        }
+    }
+}
+
+// 连续frames帧之间不留空隙，第tokenAfter帧之后插入停止标记
+// 返回从标记最后一个字节到达到接收回调识别出标记的时间
+static int64_t stopTokenLatencyUs(uint32_t baud, int frames, int tokenAfter) {
+    const int64_t byteUs = 10 * 1000000LL / baud;
+    const int64_t idleUs = SIM_RX_TIMEOUT_SYMBOLS * byteUs;
+    std::vector<RxByte> bytes;
+    int64_t t = 0;
+    int64_t tokenEndUs = -1;
+    for (int f = 0; f <= frames; f++) {
+        if (f == tokenAfter) {
+            for (int i = 0; i < STOP_TOKEN_LEN; i++) {
+                t += byteUs;
+                bytes.push_back({t, (char)STOP_TOKEN_BYTE});
+            }
+            tokenEndUs = t;
+        }
+        for (int i = 0; f < frames && i < 40; i++) {
+            t += byteUs;
+            bytes.push_back({t, i == 39 ? '\n' : 'A'});
+        }
+    }
+
+    // 与 runEventDriven 相同的事件规则，每次事件把读出的字节逐个送入识别器
+    StopTokenDetector detector;
+    size_t next = 0;
+    while (next < bytes.size()) {
+        size_t i = next;
+        int64_t eventUs = -1;
+        while (i < bytes.size()) {
+            bool last = i + 1 == bytes.size();
+            int64_t gap =
+                last ? idleUs : bytes[i + 1].arrivalUs - bytes[i].arrivalUs;
+            if (i + 1 - next >= SIM_FIFO_FULL_BYTES) {
+                eventUs = bytes[i].arrivalUs;
+                break;
+            }
+            if (gap >= idleUs) {
+                eventUs = bytes[i].arrivalUs + idleUs;
+                break;
+            }
+            i++;
+        }
+        while (next < bytes.size() && bytes[next].arrivalUs <= eventUs) {
+            if (detector.push((uint8_t)bytes[next++].c)) {
+                return eventUs - tokenEndUs;
+            }
+        }
+    }
+    return -1;
+}
+
+static void test_stop_token_worst_case() {
+    // 标记单独到达时只等空闲超时；跟在连续数据流中时取所有插入位置的最坏值
+    const uint32_t bauds[] = {9600, 115200};
+    for (uint32_t baud : bauds) {
+        const int64_t byteUs = 10 * 1000000LL / baud;
+        int64_t idle = stopTokenLatencyUs(baud, 0, 0);
+        TEST_ASSERT_EQUAL(SIM_RX_TIMEOUT_SYMBOLS * byteUs, idle);
+        int64_t worst = 0;
+        for (int k = 0; k <= 12; k++) {
+            int64_t us = stopTokenLatencyUs(baud, 12, k);
+            TEST_ASSERT_TRUE(us >= 0);
+            worst = us > worst ? us : worst;
+        }
+        TEST_ASSERT_TRUE(worst <= SIM_FIFO_FULL_BYTES * byteUs);
+        char msg[160];
+        snprintf(msg, sizeof(msg),
+                 "stop token @%6u baud: idle line %.2f ms, worst in stream "
+                 "%.2f ms (+ handler time, see FAST_STOP)",
+                 (unsigned)baud, idle / 1000.0, worst / 1000.0);
+        TEST_MESSAGE(msg);
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_frame_latency);
+    RUN_TEST(test_back_to_back_burst);
+    RUN_TEST(test_uart_baud_end_to_end);
+    RUN_TEST(test_stop_token_worst_case);
+    return UNITY_END();
+}
@@ -0,0 +1,140 @@
+// --- 文件名: test/test_text_dict/test_text_dict.cpp ---
+// 字典压缩：压缩/展开往返一致，并统计典型回复流量的压缩率和节省的空中时间
+// 也可当作工具统计实际抓包的压缩率：上位机收到的未压缩文本每帧一行存成文件，
+//   TEXT_DICT_CAPTURE=<文件> pio test -e native -f test_text_dict
+// 运行：pio test -e native -f test_text_dict
+
+#include "frame_parser.h"
+#include "lora_config.h"
+#include "param_registry.h"
+#include "text_dict.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unity.h>
+
+#define SIM_AIR_BPS loraAirRateBps((uint8_t)LoraAir::Bps2400) // 模块出厂空速
+
+void setUp() {}
+void tearDown() {}
+
+// 设备上电后一段典型的回复流量，按 command_processor.cpp 中的格式拼出
+static std::string sampleCapture() {
+    MotionParams params = {0,    50.0f,   20000, 90.0f, 20000,
+                           270.0f, 100.0f, 50.0f, false, false};
+    char report[PARAM_REPORT_MAX + 1];
+    TEST_ASSERT_TRUE(paramFormatAll(params, report, sizeof(report)) > 0);
+
+    std::string capture;
+    capture += std::string("HOST:SR_01:") + REPORT_ALL_PARAMS + ":" + report +
+               "\n";
+    capture += "HOST:SR_01:ACK:M_F\n";
+    capture += "HOST:SR_01:ACK:SEQ,17,0\n";
+    capture += "HOST:SR_01:ACK:SWAP_DIR,REVERSED\n";
+    capture += "HOST:SR_01:ACK:BATCH_OK:DUTY,FWD_FREQ\n";
+    capture += std::string("HOST:SR_01:") + PONG + ":115200\n";
+    capture += std::string("HOST:SR_01:") + LINK_STATS +
+               ":RELAYED:0;RELAY_DUP:0;RELAY_RANGE:0;SCHED:0,0,0\n";
+    return capture;
+}
+
+static void reportStats(const char *label, const TextDictStats &stats) {
+    uint32_t rawAir = 0;
+    uint32_t packedAir = 0;
+    if (stats.frames > 0) {
+        // 按平均帧长估算空中时间
+        rawAir = stats.frames *
+                 loraAirtimeUs(SIM_AIR_BPS, stats.rawBytes / stats.frames);
+        packedAir = stats.frames * loraAirtimeUs(SIM_AIR_BPS,
+                                                 stats.compressedBytes /
+                                                     stats.frames);
+    }
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "%s: %u frames, %u -> %u bytes (%.1f%%), airtime @2.4k "
+             "%.1f -> %.1f ms",
+             label, (unsigned)stats.frames, (unsigned)stats.rawBytes,
+             (unsigned)stats.compressedBytes,
+             stats.rawBytes ? 100.0 * stats.compressedBytes / stats.rawBytes
+                            : 0.0,
+             rawAir / 1000.0, packedAir / 1000.0);
+    TEST_MESSAGE(msg);
+}
+
+static void test_round_trip() {
+    std::string capture = sampleCapture();
+    size_t start = 0;
+    while (start < capture.size()) {
+        size_t end = capture.find('\n', start) + 1;
+        std::string line = capture.substr(start, end - start);
+        start = end;
+
+        char packed[FRAME_MAX_LEN + 1];
+        memcpy(packed, line.data(), line.size());
+        size_t packedLen = textDictCompress(packed, line.size());
+        TEST_ASSERT_TRUE(packedLen <= line.size());
+
+        // 上位机的展开
+        char out[FRAME_MAX_LEN + 1];
+        size_t outLen = textDictExpand(packed, packedLen, out, sizeof(out));
+        TEST_ASSERT_EQUAL(line.size(), outLen);
+        TEST_ASSERT_EQUAL_MEMORY(line.data(), out, outLen);
+
+        // 设备的接收路径：FrameBuffer逐字节展开，交出的帧不含'\n'
+        FrameBuffer fb;
+        FramePushResult r = FRAME_PENDING;
+        for (size_t i = 0; i < packedLen; i++) {
+            r = fb.push(packed[i]);
+        }
+        TEST_ASSERT_EQUAL(FRAME_READY, r);
+        TEST_ASSERT_EQUAL(line.size() - 1, fb.length());
+        TEST_ASSERT_EQUAL_MEMORY(line.data(), fb.data(), fb.length());
+    }
+}
+
+static void test_sample_compression_ratio() {
+    std::string capture = sampleCapture();
+    TextDictStats stats = {};
+    textDictMeasure(capture.data(), capture.size(), stats);
+    TEST_ASSERT_EQUAL(7, stats.frames);
+    TEST_ASSERT_EQUAL(capture.size(), stats.rawBytes);
+    TEST_ASSERT_TRUE(stats.compressedBytes < stats.rawBytes);
+    reportStats("sample replies", stats);
+}
+
+// 工具模式：统计TEXT_DICT_CAPTURE指定的抓包文件
+static void test_capture_file_ratio() {
+    const char *path = getenv("TEXT_DICT_CAPTURE");
+    if (path == NULL) {
+        TEST_IGNORE_MESSAGE("set TEXT_DICT_CAPTURE=<file> to measure");
+    }
+    FILE *f = fopen(path, "rb");
+    TEST_ASSERT_NOT_NULL_MESSAGE(f, path);
+    TextDictStats stats = {};
+    std::string pending;
+    char chunk[512];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        pending.append(chunk, n);
+        // 只交完整的行，跨块的半行留到下一块
+        size_t last = pending.rfind('\n');
+        if (last != std::string::npos) {
+            textDictMeasure(pending.data(), last + 1, stats);
+            pending.erase(0, last + 1);
+        }
+    }
+    fclose(f);
+    if (!pending.empty()) {
+        textDictMeasure(pending.data(), pending.size(), stats);
+    }
+    reportStats(path, stats);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_sample_compression_ratio);
+    RUN_TEST(test_capture_file_ratio);
+    return UNITY_END();
+}
@@ -0,0 +1,111 @@
+// --- 文件名: test/test_tx_scheduler/test_tx_scheduler.cpp ---
+// 发送调度器：状态上报的覆盖、ACK合并，中继转发的帧不与本机的帧混在一起
+// 运行：pio test -e native -f test_tx_scheduler
+
+#include "tx_scheduler.h"
+#include <cstdio>
+#include <cstring>
+#include <unity.h>
+
+void setUp() {}
+void tearDown() {}
+
+static LoraTxFrame makeFrame(const char *text) {
+    LoraTxFrame f = {};
+    f.priority = 1;
+    f.len = snprintf(f.data, sizeof(f.data), "%s", text);
+    return f;
+}
+
+// 预算足够大，只看调度顺序
+static TxScheduler makeScheduler() { return TxScheduler(62500, 1000, 10000); }
+
+static void test_state_report_superseded() {
+    TxScheduler s = makeScheduler();
+    TEST_ASSERT_TRUE(s.stage(makeFrame("HOST:SR_01:REPORT_ALL_PARAMS:a\n")));
+    TEST_ASSERT_TRUE(s.stage(makeFrame("HOST:SR_01:REPORT_ALL_PARAMS:b\n")));
+    LoraTxFrame out;
+    uint32_t waitMs;
+    TEST_ASSERT_TRUE(s.next(0, out, waitMs));
+    TEST_ASSERT_EQUAL_STRING("HOST:SR_01:REPORT_ALL_PARAMS:b\n", out.data);
+    TEST_ASSERT_TRUE(s.empty());
+    TEST_ASSERT_EQUAL(1, s.getStats(0).superseded);
+}
+
+static void test_link_stats_pages_not_superseded() {
+    // 上位机连续请求TX和AUX两页，两页都要发出
+    TxScheduler s = makeScheduler();
+    TEST_ASSERT_TRUE(s.stage(makeFrame("HOST:SR_01:LINK_STATS:SENT:3\n")));
+    TEST_ASSERT_TRUE(
+        s.stage(makeFrame("HOST:SR_01:LINK_STATS:AUX_LAST_US:120\n")));
+    LoraTxFrame out;
+    uint32_t waitMs;
+    TEST_ASSERT_TRUE(s.next(0, out, waitMs));
+    TEST_ASSERT_EQUAL_STRING("HOST:SR_01:LINK_STATS:SENT:3\n", out.data);
+    TEST_ASSERT_TRUE(s.next(0, out, waitMs));
+    TEST_ASSERT_EQUAL_STRING("HOST:SR_01:LINK_STATS:AUX_LAST_US:120\n",
+                             out.data);
+    TEST_ASSERT_EQUAL(0, s.getStats(0).superseded);
+}
+
+static void test_acks_coalesced() {
+    TxScheduler s = makeScheduler();
+    TEST_ASSERT_TRUE(s.stage(makeFrame("HOST:SR_01:ACK:M_F\n")));
+    TEST_ASSERT_TRUE(s.stage(makeFrame("HOST:SR_01:ACK:SWAP_DIR\n")));
+    LoraTxFrame out;
+    uint32_t waitMs;
+    TEST_ASSERT_TRUE(s.next(0, out, waitMs));
+    TEST_ASSERT_EQUAL_STRING("HOST:SR_01:ACK:M_F|SWAP_DIR\n", out.data);
+    TEST_ASSERT_TRUE(s.empty());
+}
+
+static void test_frames_from_two_senders_kept_apart() {
+    // 中继SR_03自己的累计ACK和转发的SR_05的累计ACK都要发出
+    TxScheduler s = makeScheduler();
+    TEST_ASSERT_TRUE(s.stage(makeFrame("HOST:SR_03:ACK:SEQ,4,0\n")));
+    TEST_ASSERT_TRUE(
+        s.stage(makeFrame("HOST:SR_05/T1/H1/V3:ACK:SEQ,12,0\n")));
+    LoraTxFrame out;
+    uint32_t waitMs;
+    TEST_ASSERT_TRUE(s.next(0, out, waitMs));
+    TEST_ASSERT_EQUAL_STRING("HOST:SR_03:ACK:SEQ,4,0\n", out.data);
+    TEST_ASSERT_TRUE(s.next(0, out, waitMs));
+    TEST_ASSERT_EQUAL_STRING("HOST:SR_05/T1/H1/V3:ACK:SEQ,12,0\n", out.data);
+    TEST_ASSERT_EQUAL(0, s.getStats(0).superseded);
+
+    // 普通ACK不合并到别的设备名下
+    TEST_ASSERT_TRUE(s.stage(makeFrame("HOST:SR_03:ACK:SWAP_DIR,NORMAL\n")));
+    TEST_ASSERT_TRUE(
+        s.stage(makeFrame("HOST:SR_05/T1/H1/V3:ACK:STEP_MODE,ENABLED\n")));
+    TEST_ASSERT_TRUE(s.next(0, out, waitMs));
+    TEST_ASSERT_EQUAL_STRING("HOST:SR_03:ACK:SWAP_DIR,NORMAL\n", out.data);
+    TEST_ASSERT_TRUE(s.next(0, out, waitMs));
+    TEST_ASSERT_EQUAL_STRING("HOST:SR_05/T1/H1/V3:ACK:STEP_MODE,ENABLED\n",
+                             out.data);
+    TEST_ASSERT_EQUAL(0, s.getStats(0).coalesced);
+
+    // 状态上报只覆盖同一来源的旧上报；选项不同的同一来源仍然覆盖
+    TEST_ASSERT_TRUE(
+        s.stage(makeFrame("HOST:SR_07/T1/H1/V3:REPORT_ALL_PARAMS:a\n")));
+    TEST_ASSERT_TRUE(
+        s.stage(makeFrame("HOST:SR_05/T1/H1/V3:REPORT_ALL_PARAMS:b\n")));
+    TEST_ASSERT_TRUE(
+        s.stage(makeFrame("HOST:SR_05/T2/H0/V4:REPORT_ALL_PARAMS:c\n")));
+    TEST_ASSERT_TRUE(s.next(0, out, waitMs));
+    TEST_ASSERT_EQUAL_STRING("HOST:SR_07/T1/H1/V3:REPORT_ALL_PARAMS:a\n",
+                             out.data);
+    TEST_ASSERT_TRUE(s.next(0, out, waitMs));
+    TEST_ASSERT_EQUAL_STRING("HOST:SR_05/T2/H0/V4:REPORT_ALL_PARAMS:c\n",
+                             out.data);
+    TEST_ASSERT_TRUE(s.empty());
+    TEST_ASSERT_EQUAL(1, s.getStats(0).superseded);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_state_report_superseded);
+    RUN_TEST(test_link_stats_pages_not_superseded);
+    RUN_TEST(test_acks_coalesced);
+    RUN_TEST(test_frames_from_two_senders_kept_apart);
+    return UNITY_END();
+}